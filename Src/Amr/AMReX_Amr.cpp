@@ -89,6 +89,16 @@ namespace
     bool checkpoint_files_output;
     bool precreateDirectories;
     bool prereadFAHeaders;
+    bool checkpoint_delta;
+    int  checkpoint_delta_full_int;
+    bool trim_arena_at_regrid;
+    bool repack_arena_at_regrid;
+    //
+    // The checkpoint delta checkpoints refer to and how many
+    // delta checkpoints have been written since the last full one.
+    //
+    std::string delta_ref_chkfile;
+    int  num_delta_checkpoints;
     VisMF::Header::Version plot_headerversion(VisMF::Header::Version_v1);
     VisMF::Header::Version checkpoint_headerversion(VisMF::Header::Version_v1);
 }
@@ -127,6 +137,12 @@ Amr::Initialize ()
     compute_new_dt_on_regrid = false;
     precreateDirectories     = true;
     prereadFAHeaders         = true;
+    checkpoint_delta         = false;
+    checkpoint_delta_full_int = 0;
+    trim_arena_at_regrid     = false;
+    repack_arena_at_regrid   = false;
+    delta_ref_chkfile.clear();
+    num_delta_checkpoints    = 0;
     plot_headerversion       = VisMF::Header::Version_v1;
     checkpoint_headerversion = VisMF::Header::Version_v1;
 #if defined(AMREX_USE_SENSEI_INSITU) && !defined(AMREX_NO_SENSEI_AMR_INST)
@@ -1392,6 +1408,12 @@ Amr::restart (const std::string& filename)
     if (record_run_info && ParallelDescriptor::IOProcessor()) {
         runlog << "RESTART from file = " << filename << '\n';
     }
+
+    delta_ref_chkfile = filename;
+    while (delta_ref_chkfile.size() > 1 && delta_ref_chkfile.back() == '/') {
+        delta_ref_chkfile.pop_back();
+    }
+    num_delta_checkpoints = 0;
     //
     // Init problem dependent data.
     //
@@ -1736,10 +1758,27 @@ Amr::checkPoint ()
   // For AsyncOut, we need to turn off stream retry and write to ckfile directly.
   const std::string ckfileTemp = (AsyncOut::UseAsyncOut()) ? ckfile : (ckfile + ".temp");
 
+  //
+  // Delta checkpoints only write the FABs that changed since the previous
+  // checkpoint and refer to the files of earlier checkpoints for the rest.
+  //
+  bool full_checkpoint = true;
+  if (checkpoint_delta) {
+      full_checkpoint = delta_ref_chkfile.empty() || delta_ref_chkfile == ckfile ||
+          (checkpoint_delta_full_int > 0 && num_delta_checkpoints >= checkpoint_delta_full_int-1);
+      if (verbose > 0 && ! full_checkpoint) {
+          amrex::Print() << "CHECKPOINT: delta of " << delta_ref_chkfile << "\n";
+      }
+  }
+
   while(sretry.TryFileOutput()) {
 
     StateData::ClearFabArrayHeaderNames();
 
+    if (checkpoint_delta) {
+        VisMF::SetDeltaReference(ckfileTemp, full_checkpoint ? std::string() : delta_ref_chkfile);
+    }
+
     //
     //  if either the ckfile or ckfileTemp exists, rename them
     //  to move them out of the way.  then create ckfile
@@ -1872,6 +1911,12 @@ Amr::checkPoint ()
     }
   }  // end while
 
+  if (checkpoint_delta) {
+      VisMF::ClearDeltaReference();
+      delta_ref_chkfile = ckfile;
+      num_delta_checkpoints = full_checkpoint ? 0 : num_delta_checkpoints+1;
+  }
+
   //
   // Restore the previous FAB format.
   //
@@ -2703,6 +2748,34 @@ Amr::regrid (int  lbase,
         amr_level[lev]->post_regrid(lbase,new_finest);
     }
 
+    FabArrayBase::trimCaches();
+
+    //
+    // Give the memory freed by the old grids back to the system.
+    //
+    if (trim_arena_at_regrid || repack_arena_at_regrid)
+    {
+        Long nbytes_moved = 0;
+        if (repack_arena_at_regrid) {
+            for (int lev = 0; lev <= new_finest; ++lev) {
+                for (int k = 0; k < amr_level[lev]->numStates(); ++k) {
+                    StateData& sd = amr_level[lev]->get_state_data(k);
+                    nbytes_moved += sd.newData().repack();
+                    if (sd.hasOldData()) {
+                        nbytes_moved += sd.oldData().repack();
+                    }
+                }
+            }
+        }
+        auto nbytes_released = static_cast<Long>(The_Arena()->freeUnused());
+        if (verbose > 1) {
+            ParallelDescriptor::ReduceLongSum(nbytes_moved, ParallelDescriptor::IOProcessorNumber());
+            ParallelDescriptor::ReduceLongSum(nbytes_released, ParallelDescriptor::IOProcessorNumber());
+            amrex::Print() << "REGRID: moved " << nbytes_moved << " bytes and released "
+                           << nbytes_released << " bytes of arena memory\n";
+        }
+    }
+
     //
     // Report creation of new grids.
     //
@@ -3303,6 +3376,12 @@ Amr::initPltAndChk ()
     pp.query("precreateDirectories", precreateDirectories);
     pp.query("prereadFAHeaders", prereadFAHeaders);
 
+    pp.queryAdd("checkpoint_delta", checkpoint_delta);
+    pp.queryAdd("checkpoint_delta_full_int", checkpoint_delta_full_int);
+
+    pp.queryAdd("trim_arena_at_regrid", trim_arena_at_regrid);
+    pp.queryAdd("repack_arena_at_regrid", repack_arena_at_regrid);
+
     int phvInt(plot_headerversion), chvInt(checkpoint_headerversion);
     pp.query("plot_headerversion", phvInt);
     if(phvInt != plot_headerversion) {
@@ -133,6 +133,8 @@ AmrCore::regrid (int lbase, Real time, bool)
     }
 
     finest_level = new_finest;
+
+    FabArrayBase::trimCaches();
 }
 
 
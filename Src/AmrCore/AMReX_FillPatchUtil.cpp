@@ -41,6 +41,7 @@ namespace amrex
         bool include_physbndry = false;
         const auto& cfinfo = FabArrayBase::TheCFinfo(*fine[0], fgeom, ngrow,
                                                      include_periodic, include_physbndry);
+        FabArrayBase::CachePin cfinfo_pin(cfinfo);
 
         if (! cfinfo.ba_cfb.empty())
         {
@@ -2,7 +2,10 @@
 #include <AMReX_Arena.H>
 #include <AMReX_BArena.H>
 #include <AMReX_CArena.H>
+#include <AMReX_NArena.H>
 #include <AMReX_PArena.H>
+#include <AMReX_SArena.H>
+#include <AMReX_TCArena.H>
 
 #include <AMReX.H>
 #include <AMReX_BLProfiler.H>
@@ -10,6 +13,9 @@
 #include <AMReX_ParallelDescriptor.H>
 #include <AMReX_ParmParse.H>
 #include <AMReX_Gpu.H>
+#include <AMReX_ParallelReduce.H>
+
+#include <cstdint>
 
 #ifdef _WIN32
 ///#include <memoryapi.h>
@@ -19,6 +25,9 @@
 #define AMREX_MUNLOCK(x,y) ((void)0)
 #else
 #include <sys/mman.h>
+#if defined(__linux__) && defined(MAP_HUGETLB) && !defined(MAP_HUGE_2MB)
+#define MAP_HUGE_2MB (21 << 26)
+#endif
 //#define AMREX_MLOCK(x,y) mlock(x,y)
 #define AMREX_MUNLOCK(x,y) munlock(x,y)
 #endif
@@ -28,6 +37,8 @@ namespace amrex {
 namespace {
     bool initialized = false;
 
+    thread_local int thread_hint = -1;
+
     Arena* the_arena = nullptr;
     Arena* the_async_arena = nullptr;
     Arena* the_device_arena = nullptr;
@@ -35,6 +46,7 @@ namespace {
     Arena* the_pinned_arena = nullptr;
     Arena* the_cpu_arena = nullptr;
     Arena* the_comms_arena = nullptr;
+    Arena* the_small_arena = nullptr;
 
     Long the_arena_init_size = 0L;
     Long the_device_arena_init_size = 1024*1024*8;
@@ -49,10 +61,121 @@ namespace {
     Long the_async_arena_release_threshold = std::numeric_limits<Long>::max();
     bool the_arena_is_managed = false;
     bool abort_on_out_of_gpu_memory = false;
+    bool the_arena_thread_cache = false;
+    bool the_cpu_arena_thread_cache = false;
+    bool the_arena_numa = false;
+    bool the_cpu_arena_numa = false;
+    Long thread_cache_max_size = TCArena::DefaultMaxCachedSize;
+    Long thread_cache_size = TCArena::DefaultThreadBytes;
+
+    bool the_arena_huge_pages = false;
+    bool the_cpu_arena_huge_pages = false;
+    Long the_small_arena_max_size = SArena::DefaultMaxBlockSize;
+
+    enum HugePageKind : int { hugetlb_pages = 0, transparent_pages, regular_pages };
+
+    std::size_t& huge_page_bytes (Arena::HugePageUsage& usage, int kind)
+    {
+        if (kind == hugetlb_pages) {
+            return usage.hugetlb_bytes;
+        } else if (kind == transparent_pages) {
+            return usage.transparent_bytes;
+        } else {
+            return usage.regular_bytes;
+        }
+    }
+
+    // nbytes is a multiple of the huge page size.
+    void* map_huge_pages (std::size_t nbytes, int& kind)
+    {
+#ifdef __linux__
+        void* p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        // This fails unless the system has enough reserved huge pages.
+        p = mmap(nullptr, nbytes, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+        if (p != MAP_FAILED) {
+            kind = hugetlb_pages;
+            return p;
+        }
+#endif
+        // Map one more huge page than needed so that the memory can be
+        // trimmed to start at a huge page boundary.
+        constexpr std::size_t hp = Arena::huge_page_size;
+        p = mmap(nullptr, nbytes+hp, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) { return nullptr; }
+        auto addr = reinterpret_cast<std::uintptr_t>(p);
+        auto aligned = static_cast<std::uintptr_t>(amrex::aligned_size(hp, addr));
+        auto head = static_cast<std::size_t>(aligned - addr);
+        if (head > 0) { munmap(p, head); }
+        munmap(reinterpret_cast<char*>(aligned)+nbytes, hp-head);
+        p = reinterpret_cast<void*>(aligned);
+        kind = regular_pages;
+#ifdef MADV_HUGEPAGE
+        // This fails if transparent huge pages are disabled.
+        if (madvise(p, nbytes, MADV_HUGEPAGE) == 0) {
+            kind = transparent_pages;
+        }
+#endif
+        return p;
+#else
+        kind = regular_pages;
+        return std::malloc(nbytes);
+#endif
+    }
+
+    void unmap_huge_pages (void* p, std::size_t nbytes)
+    {
+#ifdef __linux__
+        munmap(p, nbytes);
+#else
+        amrex::ignore_unused(nbytes);
+        std::free(p);
+#endif
+    }
+
+    CArena* new_carena (bool thread_cache, ArenaInfo const& info)
+    {
+        if (thread_cache) {
+            return new TCArena(0, info, static_cast<std::size_t>(thread_cache_max_size),
+                               static_cast<std::size_t>(thread_cache_size));
+        } else {
+            return new CArena(0, info);
+        }
+    }
+
+    template <typename... Args>
+    void print_usage (Arena* arena, Args&&... args)
+    {
+        if (auto* p = dynamic_cast<CArena*>(arena)) {
+            p->PrintUsage(std::forward<Args>(args)...);
+        } else if (auto* q = dynamic_cast<NArena*>(arena)) {
+            q->PrintUsage(std::forward<Args>(args)...);
+        } else if (auto* r = dynamic_cast<SArena*>(arena)) {
+            r->PrintUsage(std::forward<Args>(args)...);
+        }
+    }
 }
 
 const std::size_t Arena::align_size;
 
+Arena::ThreadHint::ThreadHint (int tid) noexcept
+    : m_previous(thread_hint)
+{
+    if (tid >= 0) { thread_hint = tid; }
+}
+
+Arena::ThreadHint::~ThreadHint ()
+{
+    thread_hint = m_previous;
+}
+
+int
+Arena::ThreadHint::get () noexcept
+{
+    return thread_hint;
+}
+
 bool
 Arena::isDeviceAccessible () const
 {
@@ -136,6 +259,25 @@ void*
 Arena::allocate_system (std::size_t nbytes) // NOLINT(readability-make-member-function-const)
 {
     void * p;
+    if (arena_info.use_huge_pages) {
+#ifdef AMREX_USE_GPU
+        AMREX_ASSERT(arena_info.use_cpu_memory);
+#endif
+        nbytes = amrex::aligned_size(huge_page_size, nbytes);
+        int kind = regular_pages;
+        p = map_huge_pages(nbytes, kind);
+        if (p == nullptr) { amrex::Abort("Sorry, mmap failed"); }
+        if (arena_info.numa_domain >= 0) {
+            NUMA::Bind(p, nbytes, arena_info.numa_domain);
+        }
+        m_huge_page_kind.emplace(p, kind);
+        huge_page_bytes(m_huge_page_usage, kind) += nbytes;
+        return p;
+    }
+    if (arena_info.numa_domain >= 0) {
+        AMREX_ASSERT(arena_info.use_cpu_memory);
+        return NUMA::Allocate(nbytes, arena_info.numa_domain);
+    }
 #ifdef AMREX_USE_GPU
     if (arena_info.use_cpu_memory)
     {
@@ -218,6 +360,20 @@ Arena::allocate_system (std::size_t nbytes) // NOLINT(readability-make-member-fu
 void
 Arena::deallocate_system (void* p, std::size_t nbytes) // NOLINT(readability-make-member-function-const)
 {
+    if (arena_info.use_huge_pages) {
+        nbytes = amrex::aligned_size(huge_page_size, nbytes);
+        auto it = m_huge_page_kind.find(p);
+        if (it != m_huge_page_kind.end()) {
+            huge_page_bytes(m_huge_page_usage, it->second) -= nbytes;
+            m_huge_page_kind.erase(it);
+        }
+        unmap_huge_pages(p, nbytes);
+        return;
+    }
+    if (arena_info.numa_domain >= 0) {
+        NUMA::Deallocate(p, nbytes);
+        return;
+    }
 #ifdef AMREX_USE_GPU
     if (arena_info.use_cpu_memory)
     {
@@ -244,6 +400,28 @@ Arena::deallocate_system (void* p, std::size_t nbytes) // NOLINT(readability-mak
 #endif
 }
 
+void
+Arena::PrintHugePageUsage (std::string const& name) const
+{
+    auto usage = hugePageUsage();
+    Long huge_min = static_cast<Long>((usage.hugetlb_bytes + usage.transparent_bytes) / (1024*1024));
+    Long huge_max = huge_min;
+    Long regular_min = static_cast<Long>(usage.regular_bytes / (1024*1024));
+    Long regular_max = regular_min;
+    const int IOProc = ParallelDescriptor::IOProcessorNumber();
+    ParallelReduce::Min<Long>({huge_min, regular_min}, IOProc, ParallelDescriptor::Communicator());
+    ParallelReduce::Max<Long>({huge_max, regular_max}, IOProc, ParallelDescriptor::Communicator());
+#ifdef AMREX_USE_MPI
+    amrex::Print() << "[" << name << "] space (MB) in huge pages    spread across MPI: ["
+                   << huge_min << " ... " << huge_max << "]\n"
+                   << "[" << name << "] space (MB) in regular pages spread across MPI: ["
+                   << regular_min << " ... " << regular_max << "]\n";
+#else
+    amrex::Print() << "[" << name << "] space in huge pages    (MB): " << huge_min << "\n"
+                   << "[" << name << "] space in regular pages (MB): " << regular_min << "\n";
+#endif
+}
+
 namespace {
 
     class NullArena final
@@ -303,20 +481,48 @@ Arena::Initialize ()
     pp.queryAdd(  "the_async_arena_release_threshold",   the_async_arena_release_threshold);
     pp.queryAdd("the_arena_is_managed", the_arena_is_managed);
     pp.queryAdd("abort_on_out_of_gpu_memory", abort_on_out_of_gpu_memory);
+    pp.queryAdd("the_arena_thread_cache", the_arena_thread_cache);
+    pp.queryAdd("the_cpu_arena_thread_cache", the_cpu_arena_thread_cache);
+    pp.queryAdd("thread_cache_max_size", thread_cache_max_size);
+    pp.queryAdd("thread_cache_size", thread_cache_size);
+    pp.queryAdd("the_arena_numa", the_arena_numa);
+    pp.queryAdd("the_cpu_arena_numa", the_cpu_arena_numa);
+    pp.queryAdd("the_arena_huge_pages", the_arena_huge_pages);
+    pp.queryAdd("the_cpu_arena_huge_pages", the_cpu_arena_huge_pages);
+    pp.queryAdd("the_small_arena_max_size", the_small_arena_max_size);
+    if ((the_arena_numa && the_arena_thread_cache) ||
+        (the_cpu_arena_numa && the_cpu_arena_thread_cache)) {
+        amrex::Abort("Arena::Initialize: an arena cannot have both NUMA domains and thread caches");
+    }
+#ifdef AMREX_USE_GPU
+    if (the_arena_numa) {
+        amrex::Abort("Arena::Initialize: amrex.the_arena_numa is not supported for GPU builds");
+    }
+    if (the_arena_huge_pages) {
+        amrex::Abort("Arena::Initialize: amrex.the_arena_huge_pages is not supported for GPU builds");
+    }
+#endif
 
-    {
+    ArenaInfo the_arena_info{};
+    the_arena_info.SetReleaseThreshold(the_arena_release_threshold);
+    if (the_arena_huge_pages) { the_arena_info.SetHugePages(); }
+
+    if (the_arena_numa) {
+        auto* narena = new NArena(0, the_arena_info);
+        narena->registerForProfiling("Cpu Memory");
+        the_arena = narena;
+    } else {
 #if defined(BL_COALESCE_FABS) || defined(AMREX_USE_GPU)
-        ArenaInfo ai{};
-        ai.SetReleaseThreshold(the_arena_release_threshold);
+        ArenaInfo ai = the_arena_info;
         if (the_arena_is_managed) {
-            the_arena = new CArena(0, ai.SetPreferred());
+            the_arena = new_carena(the_arena_thread_cache, ai.SetPreferred());
 #ifdef AMREX_USE_GPU
             the_arena->registerForProfiling("Managed Memory");
 #else
             the_arena->registerForProfiling("Cpu Memory");
 #endif
         } else {
-            the_arena = new CArena(0, ai.SetDeviceMemory());
+            the_arena = new_carena(the_arena_thread_cache, ai.SetDeviceMemory());
 #ifdef AMREX_USE_GPU
             the_arena->registerForProfiling("Device Memory");
 #else
@@ -329,7 +535,13 @@ Arena::Initialize ()
         the_arena->free(p);
 #endif
 #else
-        the_arena = The_BArena();
+        if (the_arena_thread_cache || the_arena_huge_pages) {
+            // The cache and the huge pages need a CArena.
+            the_arena = new_carena(the_arena_thread_cache, the_arena_info.SetDeviceMemory());
+            the_arena->registerForProfiling("Cpu Memory");
+        } else {
+            the_arena = The_BArena();
+        }
 #endif
     }
 
@@ -407,8 +619,25 @@ Arena::Initialize ()
         the_comms_arena->free(p);
     }
 
-    the_cpu_arena = The_BArena();
-    the_cpu_arena->registerForProfiling("Cpu Memory");
+    ArenaInfo the_cpu_arena_info = ArenaInfo{}.SetCpuMemory();
+    if (the_cpu_arena_huge_pages) { the_cpu_arena_info.SetHugePages(); }
+
+    if (the_cpu_arena_numa) {
+        auto* narena = new NArena(0, the_cpu_arena_info);
+        narena->registerForProfiling("Cpu Memory");
+        the_cpu_arena = narena;
+    } else {
+        if (the_cpu_arena_thread_cache || the_cpu_arena_huge_pages) {
+            the_cpu_arena = new_carena(the_cpu_arena_thread_cache, the_cpu_arena_info);
+        } else {
+            the_cpu_arena = The_BArena();
+        }
+        the_cpu_arena->registerForProfiling("Cpu Memory");
+    }
+
+    the_small_arena = new SArena(ArenaInfo{}.SetCpuMemory(),
+                                 static_cast<std::size_t>(the_small_arena_max_size));
+    the_small_arena->registerForProfiling("Cpu Memory");
 
     // Initialize the null arena
     auto* null_arena = The_Null_Arena();
@@ -446,36 +675,25 @@ Arena::PrintUsage ()
     }
 #endif
     if (The_Arena()) {
-        auto* p = dynamic_cast<CArena*>(The_Arena());
-        if (p) {
-            p->PrintUsage("The         Arena");
-        }
+        print_usage(The_Arena(), "The         Arena");
     }
     if (The_Device_Arena() && The_Device_Arena() != The_Arena()) {
-        auto* p = dynamic_cast<CArena*>(The_Device_Arena());
-        if (p) {
-            p->PrintUsage("The  Device Arena");
-        }
+        print_usage(The_Device_Arena(), "The  Device Arena");
     }
     if (The_Managed_Arena() && The_Managed_Arena() != The_Arena()) {
-        auto* p = dynamic_cast<CArena*>(The_Managed_Arena());
-        if (p) {
-            p->PrintUsage("The Managed Arena");
-        }
+        print_usage(The_Managed_Arena(), "The Managed Arena");
     }
     if (The_Pinned_Arena()) {
-        auto* p = dynamic_cast<CArena*>(The_Pinned_Arena());
-        if (p) {
-            p->PrintUsage("The  Pinned Arena");
-        }
+        print_usage(The_Pinned_Arena(), "The  Pinned Arena");
     }
     if (The_Comms_Arena() && The_Comms_Arena() != The_Device_Arena()
          && The_Comms_Arena() != The_Pinned_Arena()) {
-        auto* p = dynamic_cast<CArena*>(The_Comms_Arena());
-        if (p) {
-            p->PrintUsage("The   Comms Arena");
-        }
+        print_usage(The_Comms_Arena(), "The   Comms Arena");
+    }
+    if (The_Cpu_Arena() && The_Cpu_Arena() != The_Arena()) {
+        print_usage(The_Cpu_Arena(), "The     Cpu Arena");
     }
+    print_usage(The_Small_Arena(), "The   Small Arena");
 }
 
 void
@@ -498,36 +716,25 @@ Arena::PrintUsageToFiles (const std::string& filename, const std::string& messag
 #endif
 
     if (The_Arena()) {
-        auto* p = dynamic_cast<CArena*>(The_Arena());
-        if (p) {
-            p->PrintUsage(ofs, "The         Arena", "    ");
-        }
+        print_usage(The_Arena(), ofs, "The         Arena", "    ");
     }
     if (The_Device_Arena() && The_Device_Arena() != The_Arena()) {
-        auto* p = dynamic_cast<CArena*>(The_Device_Arena());
-        if (p) {
-            p->PrintUsage(ofs, "The  Device Arena", "    ");
-        }
+        print_usage(The_Device_Arena(), ofs, "The  Device Arena", "    ");
     }
     if (The_Managed_Arena() && The_Managed_Arena() != The_Arena()) {
-        auto* p = dynamic_cast<CArena*>(The_Managed_Arena());
-        if (p) {
-            p->PrintUsage(ofs, "The Managed Arena", "    ");
-        }
+        print_usage(The_Managed_Arena(), ofs, "The Managed Arena", "    ");
     }
     if (The_Pinned_Arena()) {
-        auto* p = dynamic_cast<CArena*>(The_Pinned_Arena());
-        if (p) {
-            p->PrintUsage(ofs, "The  Pinned Arena", "    ");
-        }
+        print_usage(The_Pinned_Arena(), ofs, "The  Pinned Arena", "    ");
     }
     if (The_Comms_Arena() && The_Comms_Arena() != The_Device_Arena()
         && The_Comms_Arena() != The_Pinned_Arena()) {
-        auto* p = dynamic_cast<CArena*>(The_Comms_Arena());
-        if (p) {
-            p->PrintUsage(ofs, "The   Comms Arena", "    ");
-        }
+        print_usage(The_Comms_Arena(), ofs, "The   Comms Arena", "    ");
+    }
+    if (The_Cpu_Arena() && The_Cpu_Arena() != The_Arena()) {
+        print_usage(The_Cpu_Arena(), ofs, "The     Cpu Arena", "    ");
     }
+    print_usage(The_Small_Arena(), ofs, "The   Small Arena", "    ");
 
     ofs << "\n";
 }
@@ -588,6 +795,9 @@ Arena::Finalize ()
         delete the_cpu_arena;
         the_cpu_arena = nullptr;
     }
+
+    delete the_small_arena;
+    the_small_arena = nullptr;
 }
 
 Arena*
@@ -650,6 +860,16 @@ The_Cpu_Arena ()
     }
 }
 
+Arena*
+The_Small_Arena ()
+{
+    if        (the_small_arena) {
+        return the_small_arena;
+    } else {
+        return The_Null_Arena();
+    }
+}
+
 Arena*
 The_Comms_Arena ()
 {
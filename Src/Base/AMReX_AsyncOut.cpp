@@ -6,6 +6,9 @@
 #include <AMReX_Utility.H>
 #include <AMReX.H>
 
+#include <condition_variable>
+#include <mutex>
+
 namespace amrex::AsyncOut {
 
 namespace {
@@ -18,6 +21,11 @@ std::unique_ptr<BackgroundThread> s_thread;
 
 WriteInfo s_info;
 
+Long s_staging_size = 0;
+Long s_staging_used = 0;
+std::mutex s_staging_mutex;
+std::condition_variable s_staging_cond;
+
 }
 
 void Initialize ()
@@ -27,6 +35,7 @@ void Initialize ()
     ParmParse pp("amrex");
     pp.queryAdd("async_out", s_asyncout);
     pp.queryAdd("async_out_nfiles", s_noutfiles);
+    pp.queryAdd("async_out_staging_size", s_staging_size);
 
     int nprocs = ParallelDescriptor::NProcs();
     s_noutfiles = std::min(s_noutfiles, nprocs);
@@ -109,6 +118,32 @@ void Finish ()
     }
 }
 
+Long StagingSize ()
+{
+    return std::max(s_staging_size, Long(0));
+}
+
+void AcquireStaging (Long nbytes)
+{
+    if (s_staging_size <= 0) { return; }
+    std::unique_lock<std::mutex> lock(s_staging_mutex);
+    // A piece larger than the budget has to wait until nothing else is staged.
+    s_staging_cond.wait(lock, [=] () {
+        return s_staging_used == 0 || s_staging_used + nbytes <= s_staging_size;
+    });
+    s_staging_used += nbytes;
+}
+
+void ReleaseStaging (Long nbytes)
+{
+    if (s_staging_size <= 0) { return; }
+    {
+        std::lock_guard<std::mutex> lock(s_staging_mutex);
+        s_staging_used -= nbytes;
+    }
+    s_staging_cond.notify_all();
+}
+
 void Wait ()
 {
 #ifdef AMREX_USE_MPI
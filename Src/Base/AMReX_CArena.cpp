@@ -5,6 +5,7 @@
 #include <AMReX_MFIter.H>
 #include <AMReX_ParallelReduce.H>
 
+#include <algorithm>
 #include <utility>
 #include <cstring>
 #include <iostream>
@@ -15,6 +16,9 @@ CArena::CArena (std::size_t hunk_size, ArenaInfo info)
     : m_hunk(align(hunk_size == 0 ? DefaultHunkSize : hunk_size))
 {
     arena_info = info;
+    if (arena_info.use_huge_pages) {
+        m_hunk = amrex::aligned_size(huge_page_size, m_hunk);
+    }
     BL_ASSERT(m_hunk >= hunk_size);
     BL_ASSERT(m_hunk%Arena::align_size == 0);
 }
@@ -26,10 +30,22 @@ CArena::~CArena ()
     }
 }
 
+std::unique_lock<std::mutex>
+CArena::lock_mutex ()
+{
+    std::unique_lock<std::mutex> lock(carena_mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        lock.lock();
+        ++m_nlocks_contended;
+    }
+    ++m_nlocks;
+    return lock;
+}
+
 void*
 CArena::alloc (std::size_t nbytes)
 {
-    std::lock_guard<std::mutex> lock(carena_mutex);
+    auto lock = lock_mutex();
     nbytes = Arena::align(nbytes == 0 ? 1 : nbytes);
     return alloc_protected(nbytes);
 }
@@ -67,7 +83,10 @@ CArena::alloc_protected (std::size_t nbytes)
 
     if (free_it == m_freelist.end())
     {
-        const std::size_t N = nbytes < m_hunk ? m_hunk : nbytes;
+        std::size_t N = nbytes < m_hunk ? m_hunk : nbytes;
+        if (arena_info.use_huge_pages) {
+            N = amrex::aligned_size(huge_page_size, N);
+        }
 
         vp = allocate_system(N);
 
@@ -75,7 +94,7 @@ CArena::alloc_protected (std::size_t nbytes)
 
         m_alloc.emplace_back(vp,N);
 
-        if (nbytes < m_hunk)
+        if (nbytes < N)
         {
             //
             // Add leftover chunk to free list.
@@ -84,7 +103,7 @@ CArena::alloc_protected (std::size_t nbytes)
             //
             void* block = static_cast<char*>(vp) + nbytes;
 
-            m_freelist.insert(m_freelist.end(), Node(block, vp, m_hunk-nbytes));
+            m_freelist.insert(m_freelist.end(), Node(block, vp, N-nbytes));
         }
 
         m_busylist.insert(Node(vp, vp, nbytes, stat));
@@ -126,7 +145,7 @@ CArena::alloc_protected (std::size_t nbytes)
 std::pair<void*,std::size_t>
 CArena::alloc_in_place (void* pt, std::size_t szmin, std::size_t szmax)
 {
-    std::lock_guard<std::mutex> lock(carena_mutex);
+    auto lock = lock_mutex();
 
     std::size_t nbytes_max = Arena::align(szmax == 0 ? 1 : szmax);
 
@@ -201,7 +220,7 @@ CArena::shrink_in_place (void* pt, std::size_t new_size)
 
     new_size = Arena::align(new_size);
 
-    std::lock_guard<std::mutex> lock(carena_mutex);
+    auto lock = lock_mutex();
 
     auto busy_it = m_busylist.find(Node(pt,nullptr,0));
     if (busy_it == m_busylist.end()) {
@@ -262,8 +281,13 @@ CArena::free (void* vp)
         return;
     }
 
-    std::lock_guard<std::mutex> lock(carena_mutex);
+    auto lock = lock_mutex();
+    free_protected(vp);
+}
 
+void
+CArena::free_protected (void* vp)
+{
     //
     // `vp' had better be in the busy list.
     //
@@ -345,7 +369,7 @@ CArena::free (void* vp)
 std::size_t
 CArena::freeUnused ()
 {
-    std::lock_guard<std::mutex> lock(carena_mutex);
+    auto lock = lock_mutex();
     return freeUnused_protected();
 }
 
@@ -375,12 +399,71 @@ CArena::freeUnused_protected ()
     return nbytes;
 }
 
+void*
+CArena::relocate (void* pt)
+{
+    if (pt == nullptr) { return nullptr; }
+
+    auto lock = lock_mutex();
+
+    auto busy_it = m_busylist.find(Node(pt,nullptr,0));
+    if (busy_it == m_busylist.end()) {
+        amrex::Abort("CArena::relocate: unknown pointer");
+        return nullptr;
+    }
+    const std::size_t nbytes = busy_it->size();
+    MemStat* stat = busy_it->mem_stat();
+
+    //
+    // First fit as in alloc_protected, but only below pt.
+    //
+    auto free_it = m_freelist.begin();
+    for ( ; free_it != m_freelist.end() && std::less<>{}(free_it->block(), pt); ++free_it) {
+        if (free_it->size() >= nbytes) {
+            break;
+        }
+    }
+    if (free_it == m_freelist.end() || !std::less<>{}(free_it->block(), pt)) {
+        return pt;
+    }
+
+    void* vp = free_it->block();
+    m_busylist.insert(Node(vp, free_it->owner(), nbytes, stat));
+
+    if (free_it->size() > nbytes)
+    {
+        Node freeblock = *free_it;
+        freeblock.size(freeblock.size() - nbytes);
+        freeblock.block(static_cast<char*>(vp) + nbytes);
+        m_freelist.insert(free_it, freeblock);
+    }
+    m_freelist.erase(free_it);
+
+    m_actually_used += nbytes;
+
+#ifdef AMREX_USE_GPU
+    if (isDevice() || isManaged()) {
+        Gpu::dtod_memcpy(vp, pt, nbytes);
+    } else
+#endif
+    {
+        std::memcpy(vp, pt, nbytes);
+    }
+
+    // The new block keeps the MemStat, so the free of the old block must
+    // not be counted.  The insert above may have invalidated busy_it.
+    const_cast<Node&>(*m_busylist.find(Node(pt,nullptr,0))).mem_stat(nullptr);
+    free_protected(pt);
+
+    return vp;
+}
+
 bool
 CArena::hasFreeDeviceMemory (std::size_t sz)
 {
 #ifdef AMREX_USE_GPU
     if (isDevice() || isManaged()) {
-        std::lock_guard<std::mutex> lock(carena_mutex);
+        auto lock = lock_mutex();
 
         std::size_t nbytes = Arena::align(sz == 0 ? 1 : sz);
 
@@ -444,6 +527,31 @@ CArena::sizeOf (void* p) const noexcept
     }
 }
 
+CArena::Fragmentation
+CArena::fragmentation () const
+{
+    Fragmentation r;
+    std::map<void*,std::size_t> hunk_free;
+    for (auto const& node : m_freelist) {
+        r.free_bytes += node.size();
+        r.largest_free_block = std::max(r.largest_free_block, node.size());
+        std::size_t i = 0;
+        while ((std::size_t(2) << i) <= node.size()) { ++i; }
+        if (i >= r.free_histogram.size()) {
+            r.free_histogram.resize(i+1, 0);
+        }
+        ++r.free_histogram[i];
+        hunk_free[node.owner()] += node.size();
+    }
+    for (auto const& a : m_alloc) {
+        auto it = hunk_free.find(a.first);
+        std::size_t nfree = (it == hunk_free.end()) ? 0 : it->second;
+        r.hunk_occupancy.emplace_back(a.second, a.second-nfree);
+        if (nfree == a.second) { ++r.nfree_hunks; }
+    }
+    return r;
+}
+
 void
 CArena::PrintUsage (std::string const& name) const
 {
@@ -451,20 +559,29 @@ CArena::PrintUsage (std::string const& name) const
     Long max_megabytes = min_megabytes;
     Long actual_min_megabytes = static_cast<Long>(heap_space_actually_used() / (1024*1024));
     Long actual_max_megabytes = actual_min_megabytes;
+    auto frag = fragmentation();
+    Long largest_min_megabytes = static_cast<Long>(frag.largest_free_block / (1024*1024));
+    Long largest_max_megabytes = largest_min_megabytes;
     const int IOProc = ParallelDescriptor::IOProcessorNumber();
-    ParallelReduce::Min<Long>({min_megabytes, actual_min_megabytes},
+    ParallelReduce::Min<Long>({min_megabytes, actual_min_megabytes, largest_min_megabytes},
                               IOProc, ParallelDescriptor::Communicator());
-    ParallelReduce::Max<Long>({max_megabytes, actual_max_megabytes},
+    ParallelReduce::Max<Long>({max_megabytes, actual_max_megabytes, largest_max_megabytes},
                               IOProc, ParallelDescriptor::Communicator());
 #ifdef AMREX_USE_MPI
     amrex::Print() << "[" << name << "] space (MB) allocated spread across MPI: ["
                    << min_megabytes << " ... " << max_megabytes << "]\n"
                    << "[" << name << "] space (MB) used      spread across MPI: ["
-                   << actual_min_megabytes << " ... " << actual_max_megabytes << "]\n";
+                   << actual_min_megabytes << " ... " << actual_max_megabytes << "]\n"
+                   << "[" << name << "] largest free block (MB) spread across MPI: ["
+                   << largest_min_megabytes << " ... " << largest_max_megabytes << "]\n";
 #else
     amrex::Print() << "[" << name << "] space allocated (MB): " << min_megabytes << "\n";
     amrex::Print() << "[" << name << "] space used      (MB): " << actual_min_megabytes << "\n";
+    amrex::Print() << "[" << name << "] largest free block (MB): " << largest_min_megabytes << "\n";
 #endif
+    if (arena_info.use_huge_pages) {
+        PrintHugePageUsage(name);
+    }
 }
 
 void
@@ -476,6 +593,28 @@ CArena::PrintUsage (std::ostream& os, std::string const& name, std::string const
     os << space << "[" << name << "] space used      (MB): " << actual_megabytes << "\n";
     os << space << "[" << name << "]: " << m_alloc.size() << " allocs, "
        << m_busylist.size() << " busy blocks, " << m_freelist.size() << " free blocks\n";
+    os << space << "[" << name << "]: " << m_nlocks << " lock acquisitions, "
+       << m_nlocks_contended << " contended\n";
+    auto frag = fragmentation();
+    os << space << "[" << name << "]: " << frag.free_bytes << " bytes free, largest free block "
+       << frag.largest_free_block << " bytes, " << frag.nfree_hunks << " of "
+       << frag.hunk_occupancy.size() << " hunks unused\n";
+    for (std::size_t i = 0; i < frag.free_histogram.size(); ++i) {
+        if (frag.free_histogram[i] > 0) {
+            os << space << "[" << name << "]   free blocks of " << (std::size_t(1) << i)
+               << " to " << (std::size_t(2) << i) << " bytes: " << frag.free_histogram[i] << "\n";
+        }
+    }
+    for (auto const& [hunk_size, hunk_used] : frag.hunk_occupancy) {
+        os << space << "[" << name << "]   hunk of " << hunk_size << " bytes: "
+           << (100*hunk_used)/hunk_size << "% in use\n";
+    }
+    if (arena_info.use_huge_pages) {
+        auto usage = hugePageUsage();
+        os << space << "[" << name << "]: " << usage.hugetlb_bytes << " bytes in reserved huge pages, "
+           << usage.transparent_bytes << " in transparent huge pages, "
+           << usage.regular_bytes << " in regular pages\n";
+    }
 }
 
 std::ostream& operator<< (std::ostream& os, const CArena& arena)
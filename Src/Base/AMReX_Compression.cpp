@@ -0,0 +1,297 @@
+#include <AMReX_Compression.H>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace amrex::Compression {
+
+namespace {
+
+    constexpr std::uint32_t magic = 0x5a584d41; // "AMXZ"
+    constexpr int hash_log = 14;
+    constexpr std::size_t min_match = 4;
+    constexpr std::size_t max_offset = 65535;
+
+    std::uint32_t read32 (unsigned char const* p)
+    {
+        std::uint32_t r;
+        std::memcpy(&r, p, sizeof(r));
+        return r;
+    }
+
+    std::uint32_t hash32 (std::uint32_t v)
+    {
+        return (v * 2654435761U) >> (32 - hash_log);
+    }
+
+    // Residual of the linear extrapolation from the previous two elements,
+    // computed on the bit patterns and zigzag encoded so that small
+    // residuals of either sign have leading zero bytes.
+    template <typename T>
+    void shuffle_pred (unsigned char const* src, unsigned char* dst, std::size_t nelem)
+    {
+        constexpr std::size_t es = sizeof(T);
+        constexpr int nbits = 8*sizeof(T);
+        T p1 = 0, p2 = 0;
+        for (std::size_t e = 0; e < nelem; ++e) {
+            T v;
+            std::memcpy(&v, src+e*es, es);
+            const auto r = static_cast<T>(v - static_cast<T>(2*p1 - p2));
+            const auto sign = static_cast<T>((r >> (nbits-1)) ? ~T(0) : T(0));
+            const auto d = static_cast<T>(static_cast<T>(r << 1) ^ sign);
+            p2 = p1;
+            p1 = v;
+            unsigned char b[es];
+            std::memcpy(b, &d, es);
+            for (std::size_t k = 0; k < es; ++k) {
+                dst[k*nelem+e] = b[k];
+            }
+        }
+    }
+
+    template <typename T>
+    void unshuffle_pred (unsigned char const* src, unsigned char* dst, std::size_t nelem)
+    {
+        constexpr std::size_t es = sizeof(T);
+        T p1 = 0, p2 = 0;
+        for (std::size_t e = 0; e < nelem; ++e) {
+            unsigned char b[es];
+            for (std::size_t k = 0; k < es; ++k) {
+                b[k] = src[k*nelem+e];
+            }
+            T d;
+            std::memcpy(&d, b, es);
+            const auto sign = static_cast<T>((d & T(1)) ? ~T(0) : T(0));
+            const auto r = static_cast<T>(static_cast<T>(d >> 1) ^ sign);
+            const auto v = static_cast<T>(r + static_cast<T>(2*p1 - p2));
+            p2 = p1;
+            p1 = v;
+            std::memcpy(dst+e*es, &v, es);
+        }
+    }
+}
+
+void
+shuffle (void const* a_src, void* a_dst, std::size_t nbytes, std::size_t elem_size)
+{
+    auto const* src = static_cast<unsigned char const*>(a_src);
+    auto* dst = static_cast<unsigned char*>(a_dst);
+    const std::size_t es = std::max(elem_size, std::size_t(1));
+    const std::size_t nelem = nbytes / es;
+    if (es == 8) {
+        shuffle_pred<std::uint64_t>(src, dst, nelem);
+    } else if (es == 4) {
+        shuffle_pred<std::uint32_t>(src, dst, nelem);
+    } else if (es == 2) {
+        shuffle_pred<std::uint16_t>(src, dst, nelem);
+    } else {
+        for (std::size_t e = 0; e < nelem; ++e) {
+            for (std::size_t k = 0; k < es; ++k) {
+                dst[k*nelem+e] = src[e*es+k];
+            }
+        }
+    }
+    std::memcpy(dst+nelem*es, src+nelem*es, nbytes-nelem*es);
+}
+
+void
+unshuffle (void const* a_src, void* a_dst, std::size_t nbytes, std::size_t elem_size)
+{
+    auto const* src = static_cast<unsigned char const*>(a_src);
+    auto* dst = static_cast<unsigned char*>(a_dst);
+    const std::size_t es = std::max(elem_size, std::size_t(1));
+    const std::size_t nelem = nbytes / es;
+    if (es == 8) {
+        unshuffle_pred<std::uint64_t>(src, dst, nelem);
+    } else if (es == 4) {
+        unshuffle_pred<std::uint32_t>(src, dst, nelem);
+    } else if (es == 2) {
+        unshuffle_pred<std::uint16_t>(src, dst, nelem);
+    } else {
+        for (std::size_t e = 0; e < nelem; ++e) {
+            for (std::size_t k = 0; k < es; ++k) {
+                dst[e*es+k] = src[k*nelem+e];
+            }
+        }
+    }
+    std::memcpy(dst+nelem*es, src+nelem*es, nbytes-nelem*es);
+}
+
+// The compressed data are a sequence of (token, literals, match).  The
+// high 4 bits of the token byte are the number of literals and the low
+// 4 bits are the match length minus 4, with 15 meaning that more bytes
+// follow.  The match is a 2-byte offset followed by the extra length
+// bytes.  The last sequence only has literals.
+std::size_t
+lz_compress (void const* a_src, std::size_t nbytes, void* a_dst, std::size_t dst_capacity)
+{
+    auto const* in = static_cast<unsigned char const*>(a_src);
+    auto* out = static_cast<unsigned char*>(a_dst);
+    std::size_t op = 0;
+    std::size_t anchor = 0;
+
+    auto nextra = [] (std::size_t len) -> std::size_t {
+        return (len >= 15) ? (len-15)/255 + 1 : 0;
+    };
+
+    auto put_extra = [&] (std::size_t len) {
+        if (len >= 15) {
+            len -= 15;
+            for (; len >= 255; len -= 255) { out[op++] = 255; }
+            out[op++] = static_cast<unsigned char>(len);
+        }
+    };
+
+    auto emit = [&] (std::size_t nlit, std::size_t offset, std::size_t mlen) -> bool
+    {
+        std::size_t need = 1 + nextra(nlit) + nlit;
+        if (mlen > 0) { need += 2 + nextra(mlen-min_match); }
+        if (op + need > dst_capacity) { return false; }
+        const std::size_t itoken = op++;
+        unsigned token = static_cast<unsigned>(std::min(nlit, std::size_t(15))) << 4;
+        put_extra(nlit);
+        std::memcpy(out+op, in+anchor, nlit);
+        op += nlit;
+        if (mlen > 0) {
+            out[op++] = static_cast<unsigned char>(offset & 0xff);
+            out[op++] = static_cast<unsigned char>(offset >> 8);
+            token |= static_cast<unsigned>(std::min(mlen-min_match, std::size_t(15)));
+            put_extra(mlen-min_match);
+        }
+        out[itoken] = static_cast<unsigned char>(token);
+        return true;
+    };
+
+    if (nbytes >= 2*min_match)
+    {
+        std::vector<std::size_t> table(std::size_t(1) << hash_log, 0);
+        std::size_t ip = 1;
+        table[hash32(read32(in))] = 0;
+        while (ip + min_match <= nbytes)
+        {
+            const std::uint32_t seq = read32(in+ip);
+            const std::uint32_t h = hash32(seq);
+            const std::size_t ref = table[h];
+            table[h] = ip;
+            if (ip - ref <= max_offset && read32(in+ref) == seq)
+            {
+                std::size_t mlen = min_match;
+                while (ip+mlen < nbytes && in[ref+mlen] == in[ip+mlen]) { ++mlen; }
+                if (!emit(ip-anchor, ip-ref, mlen)) { return 0; }
+                ip += mlen;
+                anchor = ip;
+            }
+            else
+            {
+                // Skip faster through data that do not compress.
+                ip += std::min(std::size_t(1) + ((ip-anchor) >> 6), std::size_t(32));
+            }
+        }
+    }
+
+    if (!emit(nbytes-anchor, 0, 0)) { return 0; }
+    return op;
+}
+
+bool
+lz_decompress (void const* a_src, std::size_t zbytes, void* a_dst, std::size_t dst_nbytes)
+{
+    auto const* in = static_cast<unsigned char const*>(a_src);
+    auto* out = static_cast<unsigned char*>(a_dst);
+    std::size_t ip = 0;
+    std::size_t op = 0;
+
+    auto get_extra = [&] (std::size_t& len) -> bool {
+        if (len == 15) {
+            unsigned char b;
+            do {
+                if (ip >= zbytes) { return false; }
+                b = in[ip++];
+                len += b;
+            } while (b == 255);
+        }
+        return true;
+    };
+
+    while (true)
+    {
+        if (ip >= zbytes) { return false; }
+        const unsigned token = in[ip++];
+
+        std::size_t nlit = token >> 4;
+        if (!get_extra(nlit)) { return false; }
+        if (nlit > zbytes-ip || nlit > dst_nbytes-op) { return false; }
+        std::memcpy(out+op, in+ip, nlit);
+        ip += nlit;
+        op += nlit;
+
+        if (ip == zbytes) { return op == dst_nbytes; }
+
+        if (zbytes-ip < 2) { return false; }
+        const std::size_t offset = std::size_t(in[ip]) | (std::size_t(in[ip+1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) { return false; }
+
+        std::size_t mlen = token & 15U;
+        if (!get_extra(mlen)) { return false; }
+        mlen += min_match;
+        if (mlen > dst_nbytes-op) { return false; }
+
+        unsigned char* d = out+op;
+        unsigned char const* s = d-offset;
+        if (offset == 1) {
+            std::memset(d, *s, mlen);
+        } else if (offset >= mlen) {
+            std::memcpy(d, s, mlen);
+        } else {
+            for (std::size_t k = 0; k < mlen; ++k) { d[k] = s[k]; }
+        }
+        op += mlen;
+    }
+}
+
+std::size_t
+compress (void const* src, std::size_t nbytes, std::size_t elem_size,
+          void* a_dst, std::size_t dst_capacity)
+{
+    if (dst_capacity < header_size) { return 0; }
+
+    auto* dst = static_cast<unsigned char*>(a_dst);
+    const auto es = static_cast<std::uint32_t>(elem_size);
+    const auto n = static_cast<std::uint64_t>(nbytes);
+    std::memcpy(dst  , &magic, 4);
+    std::memcpy(dst+4, &es, 4);
+    std::memcpy(dst+8, &n, 8);
+
+    std::unique_ptr<unsigned char[]> tmp(new unsigned char[nbytes]);
+    shuffle(src, tmp.get(), nbytes, elem_size);
+    const std::size_t zbytes = lz_compress(tmp.get(), nbytes, dst+header_size,
+                                           dst_capacity-header_size);
+    return (zbytes > 0) ? zbytes+header_size : 0;
+}
+
+bool
+decompress (void const* a_src, std::size_t zbytes, void* dst, std::size_t dst_nbytes)
+{
+    if (zbytes < header_size) { return false; }
+
+    auto const* src = static_cast<unsigned char const*>(a_src);
+    std::uint32_t m, es;
+    std::uint64_t n;
+    std::memcpy(&m , src  , 4);
+    std::memcpy(&es, src+4, 4);
+    std::memcpy(&n , src+8, 8);
+    if (m != magic || n != dst_nbytes) { return false; }
+
+    std::unique_ptr<unsigned char[]> tmp(new unsigned char[dst_nbytes]);
+    if (!lz_decompress(src+header_size, zbytes-header_size, tmp.get(), dst_nbytes)) {
+        return false;
+    }
+    unshuffle(tmp.get(), dst, dst_nbytes, es);
+    return true;
+}
+
+}
@@ -9,6 +9,7 @@
 #include <AMReX_VisMF.H>
 #include <AMReX_Utility.H>
 #include <AMReX_Morton.H>
+#include <AMReX_Machine.H>
 
 #include <iostream>
 #include <fstream>
@@ -17,11 +18,13 @@
 #include <map>
 #include <vector>
 #include <queue>
+#include <set>
 #include <algorithm>
 #include <numeric>
 #include <string>
 #include <cstring>
 #include <iomanip>
+#include <tuple>
 
 namespace {
 int flag_verbose_mapper;
@@ -37,6 +40,8 @@ namespace amrex {
     int    sfc_threshold;
     Real   max_efficiency;
     int    node_size;
+    int    graph_ngrow;
+    Real   graph_imbalance;
 
 // We default to SFC.
 DistributionMapping::Strategy DistributionMapping::m_Strategy = DistributionMapping::SFC;
@@ -74,6 +79,12 @@ DistributionMapping::strategy (DistributionMapping::Strategy how)
     case RRSFC:
         m_BuildMap = &DistributionMapping::RRSFCProcessorMap;
         break;
+    case HILBERT:
+        m_BuildMap = &DistributionMapping::SFCProcessorMap;
+        break;
+    case GRAPH:
+        m_BuildMap = &DistributionMapping::GraphProcessorMap;
+        break;
     default:
         amrex::Error("Bad DistributionMapping::Strategy");
     }
@@ -114,6 +125,8 @@ DistributionMapping::Initialize ()
     sfc_threshold    = 0;
     max_efficiency   = 0.9_rt;
     node_size        = 0;
+    graph_ngrow      = 1;
+    graph_imbalance  = 0.05_rt;
     flag_verbose_mapper = 0;
 
     ParmParse pp("DistributionMapping");
@@ -124,6 +137,8 @@ DistributionMapping::Initialize ()
     pp.query("efficiency",          max_efficiency);
     pp.query("sfc_threshold",       sfc_threshold);
     pp.query("node_size",           node_size);
+    pp.query("graph_ngrow",         graph_ngrow);
+    pp.query("graph_imbalance",     graph_imbalance);
     pp.query("verbose_mapper",      flag_verbose_mapper);
 
     std::string theStrategy("SFC");
@@ -146,6 +161,14 @@ DistributionMapping::Initialize ()
         {
             strategy(RRSFC);
         }
+        else if (theStrategy == "HILBERT")
+        {
+            strategy(HILBERT);
+        }
+        else if (theStrategy == "GRAPH")
+        {
+            strategy(GRAPH);
+        }
         else
         {
             std::string msg("Unknown strategy: ");
@@ -1082,7 +1105,7 @@ namespace
                               const SFCToken& rhs) const;
         };
         int m_box;
-        Array<uint32_t,AMREX_SPACEDIM> m_morton;
+        Array<uint32_t,AMREX_SPACEDIM> m_key;
     };
 
     AMREX_FORCE_INLINE
@@ -1091,17 +1114,17 @@ namespace
                                     const SFCToken& rhs) const
     {
     #if (AMREX_SPACEDIM == 1)
-            return lhs.m_morton[0] < rhs.m_morton[0];
+            return lhs.m_key[0] < rhs.m_key[0];
     #elif (AMREX_SPACEDIM == 2)
-            return (lhs.m_morton[1] <  rhs.m_morton[1]) ||
-                  ((lhs.m_morton[1] == rhs.m_morton[1]) &&
-                   (lhs.m_morton[0] <  rhs.m_morton[0]));
+            return (lhs.m_key[1] <  rhs.m_key[1]) ||
+                  ((lhs.m_key[1] == rhs.m_key[1]) &&
+                   (lhs.m_key[0] <  rhs.m_key[0]));
     #else
-            return (lhs.m_morton[2] <  rhs.m_morton[2]) ||
-                  ((lhs.m_morton[2] == rhs.m_morton[2]) &&
-                  ((lhs.m_morton[1] <  rhs.m_morton[1]) ||
-                  ((lhs.m_morton[1] == rhs.m_morton[1]) &&
-                   (lhs.m_morton[0] <  rhs.m_morton[0]))));
+            return (lhs.m_key[2] <  rhs.m_key[2]) ||
+                  ((lhs.m_key[2] == rhs.m_key[2]) &&
+                  ((lhs.m_key[1] <  rhs.m_key[1]) ||
+                  ((lhs.m_key[1] == rhs.m_key[1]) &&
+                   (lhs.m_key[0] <  rhs.m_key[0]))));
     #endif
     }
 }
@@ -1125,19 +1148,19 @@ namespace {
         uint32_t y = iv[1] - imin;
         uint32_t z = iv[2] - imin;
         // extract lowest 10 bits and make space for interleaving
-        token.m_morton[0] = Morton::makeSpace(x & 0x3FF)
+        token.m_key[0] = Morton::makeSpace(x & 0x3FF)
                          | (Morton::makeSpace(y & 0x3FF) << 1)
                          | (Morton::makeSpace(z & 0x3FF) << 2);
         x = x >> 10;
         y = y >> 10;
         z = z >> 10;
-        token.m_morton[1] = Morton::makeSpace(x & 0x3FF)
+        token.m_key[1] = Morton::makeSpace(x & 0x3FF)
                          | (Morton::makeSpace(y & 0x3FF) << 1)
                          | (Morton::makeSpace(z & 0x3FF) << 2);
         x = x >> 10;
         y = y >> 10;
         z = z >> 10;
-        token.m_morton[2] = Morton::makeSpace(x & 0x3FF)
+        token.m_key[2] = Morton::makeSpace(x & 0x3FF)
                          | (Morton::makeSpace(y & 0x3FF) << 1)
                          | (Morton::makeSpace(z & 0x3FF) << 2);
 
@@ -1151,18 +1174,18 @@ namespace {
         uint32_t y = (iv[1] >= 0) ? static_cast<uint32_t>(iv[1]) + offset
             : static_cast<uint32_t>(iv[1]-std::numeric_limits<int>::lowest());
         // extract lowest 16 bits and make sapce for interleaving
-        token.m_morton[0] = Morton::makeSpace(x & 0xFFFF)
+        token.m_key[0] = Morton::makeSpace(x & 0xFFFF)
                          | (Morton::makeSpace(y & 0xFFFF) << 1);
         x = x >> 16;
         y = y >> 16;
-        token.m_morton[1] = Morton::makeSpace(x) | (Morton::makeSpace(y) << 1);
+        token.m_key[1] = Morton::makeSpace(x) | (Morton::makeSpace(y) << 1);
 
 #elif (AMREX_SPACEDIM == 1)
 
         constexpr uint32_t offset = 1U << 31;
         static_assert(static_cast<uint32_t>(std::numeric_limits<int>::max())+1 == offset,
                       "INT_MAX != (1<<31)-1");
-        token.m_morton[0] = (iv[0] >= 0) ? static_cast<uint32_t>(iv[0]) + offset
+        token.m_key[0] = (iv[0] >= 0) ? static_cast<uint32_t>(iv[0]) + offset
             : static_cast<uint32_t>(iv[0]-std::numeric_limits<int>::lowest());
 
 #else
@@ -1171,6 +1194,82 @@ namespace {
 
         return token;
     }
+
+    //
+    // The Hilbert index is computed with the transpose algorithm of
+    // J. Skilling, "Programming the Hilbert curve", AIP Conf. Proc. 707, 381 (2004).
+    // The index has AMREX_SPACEDIM*nbits bits stored in AMREX_SPACEDIM words
+    // of nbits bits each, so that SFCToken::Compare can be used.
+    //
+    AMREX_FORCE_INLINE
+    SFCToken makeHilbertToken (int box_index, IntVect const& iv)
+    {
+#if (AMREX_SPACEDIM == 1)
+        // The Hilbert curve in 1D is just the line.
+        return makeSFCToken(box_index, iv);
+#else
+        SFCToken token;
+        token.m_box = box_index;
+
+#if (AMREX_SPACEDIM == 3)
+        constexpr int nbits = 30;
+        constexpr int imin = -(1 << 29);
+        AMREX_ASSERT_WITH_MESSAGE(iv[0] >= imin && iv[0] < -imin &&
+                                  iv[1] >= imin && iv[1] < -imin &&
+                                  iv[2] >= imin && iv[2] < -imin,
+                                  "SFCToken: index out of range");
+        Array<uint32_t,AMREX_SPACEDIM> x{static_cast<uint32_t>(iv[0] - imin),
+                                         static_cast<uint32_t>(iv[1] - imin),
+                                         static_cast<uint32_t>(iv[2] - imin)};
+#else
+        constexpr int nbits = 32;
+        constexpr uint32_t offset = 1U << 31;
+        Array<uint32_t,AMREX_SPACEDIM> x;
+        for (int i = 0; i < AMREX_SPACEDIM; ++i) {
+            x[i] = (iv[i] >= 0) ? static_cast<uint32_t>(iv[i]) + offset
+                : static_cast<uint32_t>(iv[i]-std::numeric_limits<int>::lowest());
+        }
+#endif
+
+        constexpr uint32_t M = 1U << (nbits-1);
+        // inverse undo
+        for (uint32_t Q = M; Q > 1; Q >>= 1) {
+            const uint32_t P = Q - 1;
+            for (int i = 0; i < AMREX_SPACEDIM; ++i) {
+                if (x[i] & Q) {
+                    x[0] ^= P; // invert
+                } else {
+                    const uint32_t t = (x[0] ^ x[i]) & P; // exchange
+                    x[0] ^= t;
+                    x[i] ^= t;
+                }
+            }
+        }
+        // Gray encode
+        for (int i = 1; i < AMREX_SPACEDIM; ++i) {
+            x[i] ^= x[i-1];
+        }
+        uint32_t t = 0;
+        for (uint32_t Q = M; Q > 1; Q >>= 1) {
+            if (x[AMREX_SPACEDIM-1] & Q) { t ^= Q - 1; }
+        }
+        for (auto& xi : x) {
+            xi ^= t;
+        }
+
+        // interleave the bits with x[0] being the most significant
+        token.m_key.fill(0);
+        int pos = AMREX_SPACEDIM*nbits;
+        for (int q = nbits-1; q >= 0; --q) {
+            for (int i = 0; i < AMREX_SPACEDIM; ++i) {
+                --pos;
+                token.m_key[pos/nbits] |= ((x[i] >> q) & 1U) << (pos%nbits);
+            }
+        }
+
+        return token;
+#endif
+    }
 }
 
 namespace {
@@ -1192,7 +1291,7 @@ Distribute (const std::vector<SFCToken>&     tokens,
         for (const auto &t : tokens) {
             Print() << "    " << idx++ << ": "
                     << t.m_box << ": "
-                    << t.m_morton << '\n';
+                    << t.m_key << '\n';
         }
     }
 
@@ -1240,7 +1339,7 @@ Distribute (const std::vector<SFCToken>&     tokens,
                 BL_ASSERT(box == t.m_box);
                 Print() << "    " << idx << ": "
                         << t.m_box << ": "
-                        << t.m_morton << '\n';
+                        << t.m_key << '\n';
                 rank_vol += static_cast<Real>(wgts[t.m_box]);
                 idx++;
             }
@@ -1294,16 +1393,18 @@ DistributionMapping::SFCProcessorMapDoIt (const BoxArray&          boxes,
                 << nprocs << ", " << nteams << ", " << nworkers << ")\n";
     }
 
+    const bool hilbert = (m_Strategy == HILBERT);
     const int N = static_cast<int>(boxes.size());
     std::vector<SFCToken> tokens;
     tokens.reserve(N);
     for (int i = 0; i < N; ++i)
     {
         const Box& bx = boxes[i];
-        tokens.push_back(makeSFCToken(i, bx.smallEnd()));
+        tokens.push_back(hilbert ? makeHilbertToken(i, bx.smallEnd())
+                                 : makeSFCToken(i, bx.smallEnd()));
     }
     //
-    // Put'm in Morton space filling curve order.
+    // Put'm in Morton or Hilbert space filling curve order.
     //
     std::sort(tokens.begin(), tokens.end(), SFCToken::Compare());
     //
@@ -1574,6 +1675,548 @@ DistributionMapping::RRSFCProcessorMap (const BoxArray&          boxes,
     RRSFCDoIt(boxes,nprocs);
 }
 
+namespace {
+
+    //
+    // Box adjacency graph in compressed sparse row format.  The vertices
+    // are the boxes weighted by their costs, and the edges are weighted by
+    // the number of ghost cells the two boxes exchange.
+    //
+    struct BoxGraph
+    {
+        [[nodiscard]] int nvtx () const { return static_cast<int>(vwgt.size()); }
+
+        std::vector<int>  xadj{0};
+        std::vector<int>  adjncy;
+        std::vector<Long> adjwgt;
+        std::vector<Long> vwgt;
+        std::vector<Array<double,AMREX_SPACEDIM>> vpos; // used for the initial partition
+    };
+
+    BoxGraph
+    makeBoxGraph (const BoxArray& ba, const std::vector<Long>& wgts, int ngrow)
+    {
+        BL_PROFILE("makeBoxGraph()");
+
+        const int N = static_cast<int>(ba.size());
+
+        // Ghost cells of box i in box j, keyed by (min(i,j),max(i,j)).
+        std::vector<std::tuple<int,int,Long>> edges;
+        std::vector<std::pair<int,Box> > isects;
+        for (int i = 0; i < N; ++i) {
+            ba.intersections(amrex::grow(ba[i],ngrow), isects);
+            for (auto const& is : isects) {
+                if (is.first != i) {
+                    edges.emplace_back(std::min(i,is.first), std::max(i,is.first),
+                                       is.second.numPts());
+                }
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+
+        std::vector<std::tuple<int,int,Long>> merged;
+        for (auto const& e : edges) {
+            if (!merged.empty() && std::get<0>(merged.back()) == std::get<0>(e)
+                                && std::get<1>(merged.back()) == std::get<1>(e)) {
+                std::get<2>(merged.back()) += std::get<2>(e);
+            } else {
+                merged.push_back(e);
+            }
+        }
+
+        BoxGraph g;
+        g.vwgt = wgts;
+        g.vpos.resize(N);
+        std::vector<int> degree(N, 0);
+        for (int i = 0; i < N; ++i) {
+            const Box& bx = ba[i];
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                g.vpos[i][idim] = 0.5*(bx.smallEnd(idim)+bx.bigEnd(idim));
+            }
+        }
+        for (auto const& e : merged) {
+            ++degree[std::get<0>(e)];
+            ++degree[std::get<1>(e)];
+        }
+        g.xadj.resize(N+1);
+        for (int i = 0; i < N; ++i) {
+            g.xadj[i+1] = g.xadj[i] + degree[i];
+        }
+        g.adjncy.resize(g.xadj[N]);
+        g.adjwgt.resize(g.xadj[N]);
+        std::vector<int> pos(g.xadj.begin(), g.xadj.end()-1);
+        for (auto const& e : merged) {
+            auto [i, j, w] = e;
+            g.adjncy[pos[i]] = j;
+            g.adjwgt[pos[i]++] = w;
+            g.adjncy[pos[j]] = i;
+            g.adjwgt[pos[j]++] = w;
+        }
+        return g;
+    }
+
+    // Subgraph induced by the given vertices
+    BoxGraph
+    makeSubGraph (const BoxGraph& g, const std::vector<int>& verts)
+    {
+        std::vector<int> g2l(g.nvtx(), -1);
+        for (int lv = 0, n = static_cast<int>(verts.size()); lv < n; ++lv) {
+            g2l[verts[lv]] = lv;
+        }
+        BoxGraph sg;
+        for (int v : verts) {
+            for (int e = g.xadj[v]; e < g.xadj[v+1]; ++e) {
+                if (g2l[g.adjncy[e]] >= 0) {
+                    sg.adjncy.push_back(g2l[g.adjncy[e]]);
+                    sg.adjwgt.push_back(g.adjwgt[e]);
+                }
+            }
+            sg.xadj.push_back(static_cast<int>(sg.adjncy.size()));
+            sg.vwgt.push_back(g.vwgt[v]);
+            sg.vpos.push_back(g.vpos[v]);
+        }
+        return sg;
+    }
+
+    //
+    // Coarsen the graph by heavy edge matching.  cmap maps the vertices of
+    // g to the vertices of the returned graph.
+    //
+    BoxGraph
+    coarsenGraph (const BoxGraph& g, Long maxvwgt, std::vector<int>& cmap)
+    {
+        const int n = g.nvtx();
+
+        // Visit the vertices with few neighbors first so that they can find a match.
+        std::vector<int> perm(n);
+        std::iota(perm.begin(), perm.end(), 0);
+        std::stable_sort(perm.begin(), perm.end(), [&] (int a, int b) {
+            return (g.xadj[a+1]-g.xadj[a]) < (g.xadj[b+1]-g.xadj[b]);
+        });
+
+        std::vector<int> match(n, -1);
+        for (int v : perm) {
+            if (match[v] >= 0) { continue; }
+            int best = -1;
+            Long best_w = -1;
+            for (int e = g.xadj[v]; e < g.xadj[v+1]; ++e) {
+                const int u = g.adjncy[e];
+                if (match[u] < 0 && g.vwgt[v]+g.vwgt[u] <= maxvwgt && g.adjwgt[e] > best_w) {
+                    best = u;
+                    best_w = g.adjwgt[e];
+                }
+            }
+            if (best >= 0) {
+                match[v] = best;
+                match[best] = v;
+            } else {
+                match[v] = v;
+            }
+        }
+
+        cmap.assign(n, -1);
+        int nc = 0;
+        for (int v = 0; v < n; ++v) {
+            if (cmap[v] < 0) {
+                cmap[v] = nc;
+                cmap[match[v]] = nc;
+                ++nc;
+            }
+        }
+
+        BoxGraph cg;
+        cg.vwgt.resize(nc, 0);
+        cg.vpos.resize(nc);
+        std::vector<int> htable(nc, -1);
+        for (int v = 0; v < n; ++v) {
+            const int u = match[v];
+            if (u < v) { continue; } // already done as part of u
+            const int c = cmap[v];
+            const auto start = cg.adjncy.size();
+            const Long w = g.vwgt[v] + ((u != v) ? g.vwgt[u] : Long(0));
+            cg.vwgt[c] = w;
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                cg.vpos[c][idim] = (u == v) ? g.vpos[v][idim]
+                    : (static_cast<double>(g.vwgt[v])*g.vpos[v][idim] +
+                       static_cast<double>(g.vwgt[u])*g.vpos[u][idim])
+                    / static_cast<double>(std::max(w,Long(1)));
+            }
+            for (int w2 : {v, u}) {
+                for (int e = g.xadj[w2]; e < g.xadj[w2+1]; ++e) {
+                    const int cu = cmap[g.adjncy[e]];
+                    if (cu == c) { continue; }
+                    if (htable[cu] < 0) {
+                        htable[cu] = static_cast<int>(cg.adjncy.size());
+                        cg.adjncy.push_back(cu);
+                        cg.adjwgt.push_back(g.adjwgt[e]);
+                    } else {
+                        cg.adjwgt[htable[cu]] += g.adjwgt[e];
+                    }
+                }
+                if (u == v) { break; }
+            }
+            for (auto e = start; e < cg.adjncy.size(); ++e) {
+                htable[cg.adjncy[e]] = -1;
+            }
+            cg.xadj.push_back(static_cast<int>(cg.adjncy.size()));
+        }
+        return cg;
+    }
+
+    //
+    // Split the vertices in Hilbert curve order of their positions into
+    // contiguous pieces with the target weights.
+    //
+    std::vector<int>
+    initialPartition (const BoxGraph& g, const std::vector<Long>& tpw)
+    {
+        const int n = g.nvtx();
+        const int nparts = static_cast<int>(tpw.size());
+
+        std::vector<SFCToken> tokens;
+        tokens.reserve(n);
+        for (int v = 0; v < n; ++v) {
+            IntVect iv(AMREX_D_DECL(static_cast<int>(std::lround(g.vpos[v][0])),
+                                    static_cast<int>(std::lround(g.vpos[v][1])),
+                                    static_cast<int>(std::lround(g.vpos[v][2]))));
+            tokens.push_back(makeHilbertToken(v, iv));
+        }
+        std::sort(tokens.begin(), tokens.end(), SFCToken::Compare());
+
+        std::vector<int> part(n);
+        int k = 0;
+        Long cum = 0, bound = tpw[0], acc = 0;
+        for (auto const& t : tokens) {
+            const Long w = g.vwgt[t.m_box];
+            if (k < nparts-1 && acc > 0 && cum + w/2 > bound) {
+                ++k;
+                bound += tpw[k];
+                acc = 0;
+            }
+            part[t.m_box] = k;
+            cum += w;
+            acc += w;
+        }
+        return part;
+    }
+
+    //
+    // Greedy k-way refinement.  A boundary vertex is moved to the
+    // neighboring part that reduces the edge cut the most without making
+    // that part heavier than (1+imbalance) times its target weight.  Moves
+    // that do not change the cut are made if they improve the balance.  A
+    // part that is too heavy may give vertices to any neighboring part
+    // that is still within the limit or is less loaded afterwards.
+    //
+    void
+    refinePartition (const BoxGraph& g, const std::vector<Long>& tpw, Real imbalance,
+                     std::vector<int>& part)
+    {
+        BL_PROFILE("refinePartition()");
+
+        const int n = g.nvtx();
+        const int nparts = static_cast<int>(tpw.size());
+
+        std::vector<Long> pw(nparts, 0);
+        std::vector<int> cnt(nparts, 0);
+        for (int v = 0; v < n; ++v) {
+            pw[part[v]] += g.vwgt[v];
+            ++cnt[part[v]];
+        }
+        std::vector<Long> maxpw(nparts);
+        for (int k = 0; k < nparts; ++k) {
+            maxpw[k] = static_cast<Long>((1.0+imbalance)*static_cast<double>(tpw[k]));
+        }
+        auto load = [&] (int k, Long w) {
+            return static_cast<double>(w) / static_cast<double>(std::max(tpw[k],Long(1)));
+        };
+
+        std::vector<std::pair<int,Long>> conn;
+        constexpr int max_passes = 20;
+        for (int pass = 0; pass < max_passes; ++pass)
+        {
+            int nmoves = 0;
+            for (int v = 0; v < n; ++v)
+            {
+                const int a = part[v];
+                const Long vw = g.vwgt[v];
+                if (cnt[a] == 1) { continue; }
+
+                Long internal = 0;
+                conn.clear();
+                for (int e = g.xadj[v]; e < g.xadj[v+1]; ++e) {
+                    const int p = part[g.adjncy[e]];
+                    if (p == a) {
+                        internal += g.adjwgt[e];
+                    } else {
+                        auto it = std::find_if(conn.begin(), conn.end(),
+                                               [p] (auto const& x) { return x.first == p; });
+                        if (it == conn.end()) {
+                            conn.emplace_back(p, g.adjwgt[e]);
+                        } else {
+                            it->second += g.adjwgt[e];
+                        }
+                    }
+                }
+
+                const bool too_heavy = pw[a] > maxpw[a];
+                int best = -1;
+                Long best_gain = std::numeric_limits<Long>::lowest();
+                for (auto const& [p, external] : conn) {
+                    const Long gain = external - internal;
+                    const bool fits = pw[p] + vw <= maxpw[p];
+                    const bool better_balance = load(p, pw[p]+vw) < load(a, pw[a]);
+                    const bool ok = too_heavy ? (fits || better_balance)
+                        : (fits && (gain > 0 || (gain == 0 && better_balance)));
+                    if (ok && (gain > best_gain || (gain == best_gain && pw[p] < pw[best]))) {
+                        best = p;
+                        best_gain = gain;
+                    }
+                }
+
+                if (best >= 0) {
+                    part[v] = best;
+                    pw[a] -= vw;
+                    pw[best] += vw;
+                    --cnt[a];
+                    ++cnt[best];
+                    ++nmoves;
+                }
+            }
+            if (nmoves == 0) { break; }
+        }
+    }
+
+    Long
+    edgeCut (const BoxGraph& g, const std::vector<int>& part)
+    {
+        Long cut = 0;
+        for (int v = 0; v < g.nvtx(); ++v) {
+            for (int e = g.xadj[v]; e < g.xadj[v+1]; ++e) {
+                if (part[g.adjncy[e]] != part[v]) { cut += g.adjwgt[e]; }
+            }
+        }
+        return cut/2;
+    }
+
+    // Max over the parts of the weight relative to the target weight
+    double
+    maxLoad (const BoxGraph& g, const std::vector<Long>& tpw, const std::vector<int>& part)
+    {
+        std::vector<Long> pw(tpw.size(), 0);
+        for (int v = 0; v < g.nvtx(); ++v) {
+            pw[part[v]] += g.vwgt[v];
+        }
+        double r = 0.0;
+        for (int k = 0, nparts = static_cast<int>(tpw.size()); k < nparts; ++k) {
+            r = std::max(r, static_cast<double>(pw[k])/static_cast<double>(std::max(tpw[k],Long(1))));
+        }
+        return r;
+    }
+
+    //
+    // Multilevel partitioning of the graph into parts with the target
+    // weights.  The graph is coarsened, the coarsest graph is split along
+    // the Hilbert curve, and the partition is refined on the way back to
+    // the original graph.  The coarse levels may exceed the imbalance by
+    // up to half of their largest vertex, so that clusters of boxes can be
+    // moved, and the finest level brings the balance back.  The result is
+    // compared with the refined Hilbert curve partition of the original
+    // graph, and the one with the smaller cut is returned.
+    //
+    std::vector<int>
+    partitionGraph (const BoxGraph& g, const std::vector<Long>& tpw, Real imbalance)
+    {
+        BL_PROFILE("partitionGraph()");
+
+        const int nparts = static_cast<int>(tpw.size());
+        if (nparts == 1) { return std::vector<int>(g.nvtx(), 0); }
+
+        const Long total = std::accumulate(g.vwgt.begin(), g.vwgt.end(), Long(0));
+        const Long avgpw = std::max(total/nparts, Long(1));
+        const int coarsen_to = std::max(8*nparts, 64);
+        const Long maxvwgt = std::max(static_cast<Long>(1.5*static_cast<double>(total)/coarsen_to),
+                                      Long(1));
+
+        std::vector<BoxGraph> graphs;
+        std::vector<std::vector<int>> cmaps;
+        while (true) {
+            const BoxGraph& fg = graphs.empty() ? g : graphs.back();
+            if (fg.nvtx() <= coarsen_to) { break; }
+            std::vector<int> cmap;
+            BoxGraph cg = coarsenGraph(fg, maxvwgt, cmap);
+            if (cg.nvtx() > static_cast<int>(0.95*fg.nvtx())) { break; }
+            graphs.push_back(std::move(cg));
+            cmaps.push_back(std::move(cmap));
+        }
+
+        std::vector<int> part = initialPartition(graphs.empty() ? g : graphs.back(), tpw);
+
+        for (int lev = static_cast<int>(graphs.size())-1; lev >= 0; --lev) {
+            const Long lev_maxvwgt = *std::max_element(graphs[lev].vwgt.begin(),
+                                                       graphs[lev].vwgt.end());
+            const Real lev_imbalance = imbalance + Real(0.5)*static_cast<Real>(lev_maxvwgt)
+                                                            / static_cast<Real>(avgpw);
+            refinePartition(graphs[lev], tpw, lev_imbalance, part);
+            std::vector<int> fpart(cmaps[lev].size());
+            for (int v = 0, n = static_cast<int>(fpart.size()); v < n; ++v) {
+                fpart[v] = part[cmaps[lev][v]];
+            }
+            std::swap(part, fpart);
+        }
+        refinePartition(g, tpw, imbalance, part);
+
+        if (!graphs.empty()) {
+            std::vector<int> part2 = initialPartition(g, tpw);
+            refinePartition(g, tpw, imbalance, part2);
+            const double maxload = 1.0 + imbalance;
+            const double load1 = maxLoad(g, tpw, part);
+            const double load2 = maxLoad(g, tpw, part2);
+            const bool balanced1 = load1 <= maxload;
+            const bool balanced2 = load2 <= maxload;
+            if (balanced1 == balanced2) {
+                if (edgeCut(g, part2) < edgeCut(g, part)) { std::swap(part, part2); }
+            } else if (balanced2) {
+                std::swap(part, part2);
+            }
+        }
+
+        return part;
+    }
+
+    // Node of each of the nprocs processes in the current ParallelContext
+    std::vector<int>
+    nodeOfProcs (int nprocs)
+    {
+        std::vector<int> r(nprocs, 0);
+        if (node_size > 0) {
+            for (int i = 0; i < nprocs; ++i) {
+                r[i] = i / node_size;
+            }
+        } else if (nprocs == ParallelContext::NProcsSub() &&
+                   (machine::has_node_of_rank() ||
+                    ParallelContext::NProcsSub() == ParallelContext::NProcsAll())) {
+            const auto& node = machine::node_of_rank();
+            for (int i = 0; i < nprocs; ++i) {
+                r[i] = node[ParallelContext::local_to_global_rank(i)];
+            }
+        }
+        return r;
+    }
+
+    //
+    // Returns the process (in [0,nprocs)) of each box.  The box graph is
+    // first partitioned among the nodes, and then the part of each node is
+    // partitioned among its processes, so that heavy edges stay on the node.
+    //
+    std::vector<int>
+    graphPartition (const BoxArray& ba, const std::vector<Long>& wgts, int nprocs)
+    {
+        BL_PROFILE("DistributionMapping::graphPartition()");
+
+        const BoxGraph g = makeBoxGraph(ba, wgts, graph_ngrow);
+        const Long total = std::accumulate(wgts.begin(), wgts.end(), Long(0));
+
+        std::map<int,std::vector<int>> node_procs_map;
+        {
+            auto const& node = nodeOfProcs(nprocs);
+            for (int i = 0; i < nprocs; ++i) {
+                node_procs_map[node[i]].push_back(i);
+            }
+        }
+        std::vector<std::vector<int>> node_procs;
+        for (auto& kv : node_procs_map) {
+            node_procs.push_back(std::move(kv.second));
+        }
+        const int nnodes = static_cast<int>(node_procs.size());
+
+        if (nnodes == 1 || nnodes == nprocs) {
+            std::vector<Long> tpw(nprocs, total/nprocs);
+            auto part = partitionGraph(g, tpw, graph_imbalance);
+            if (nnodes > 1) {
+                for (auto& p : part) { p = node_procs[p][0]; }
+            }
+            return part;
+        }
+
+        // The balance among the nodes is made tight, because the extra load
+        // of a node is shared by its processes only if it is a multiple of
+        // the box sizes.
+        std::size_t max_node_procs = 0;
+        for (auto const& procs : node_procs) {
+            max_node_procs = std::max(max_node_procs, procs.size());
+        }
+        const Real node_imbalance = graph_imbalance / static_cast<Real>(max_node_procs);
+
+        std::vector<Long> tpw(nnodes);
+        for (int k = 0; k < nnodes; ++k) {
+            tpw[k] = static_cast<Long>(static_cast<double>(total)*node_procs[k].size()/nprocs);
+        }
+        auto node_part = partitionGraph(g, tpw, node_imbalance);
+
+        std::vector<std::vector<int>> node_verts(nnodes);
+        for (int v = 0; v < g.nvtx(); ++v) {
+            node_verts[node_part[v]].push_back(v);
+        }
+
+        std::vector<int> r(g.nvtx());
+        for (int k = 0; k < nnodes; ++k) {
+            if (node_verts[k].empty()) { continue; }
+            const BoxGraph sg = makeSubGraph(g, node_verts[k]);
+            const int np = static_cast<int>(node_procs[k].size());
+            const Long subtotal = std::accumulate(sg.vwgt.begin(), sg.vwgt.end(), Long(0));
+            auto sub_part = partitionGraph(sg, std::vector<Long>(np, subtotal/np), graph_imbalance);
+            for (int lv = 0, n = sg.nvtx(); lv < n; ++lv) {
+                r[node_verts[k][lv]] = node_procs[k][sub_part[lv]];
+            }
+        }
+        return r;
+    }
+}
+
+void
+DistributionMapping::GraphProcessorMap (const BoxArray& boxes, int nprocs)
+{
+    std::vector<Long> wgts;
+    wgts.reserve(boxes.size());
+    for (int i = 0, N = static_cast<int>(boxes.size()); i < N; ++i) {
+        wgts.push_back(boxes[i].numPts());
+    }
+    GraphProcessorMap(boxes, wgts, nprocs);
+}
+
+void
+DistributionMapping::GraphProcessorMap (const BoxArray&          boxes,
+                                        const std::vector<Long>& wgts,
+                                        int                      nprocs)
+{
+    BL_PROFILE("DistributionMapping::GraphProcessorMap()");
+
+    BL_ASSERT( ! boxes.empty());
+    BL_ASSERT(boxes.size() == static_cast<int>(wgts.size()));
+
+    m_ref->clear();
+    m_ref->m_pmap.resize(wgts.size());
+
+    auto const& part = graphPartition(boxes, wgts, nprocs);
+
+    for (int i = 0, N = static_cast<int>(part.size()); i < N; ++i) {
+        m_ref->m_pmap[i] = ParallelContext::local_to_global_rank(part[i]);
+    }
+
+    if (verbose)
+    {
+        std::vector<Long> pw(nprocs, 0);
+        for (int i = 0, N = static_cast<int>(part.size()); i < N; ++i) {
+            pw[part[i]] += wgts[i];
+        }
+        const Long sum_wgt = std::accumulate(pw.begin(), pw.end(), Long(0));
+        const Long max_wgt = *std::max_element(pw.begin(), pw.end());
+        Real efficiency = static_cast<Real>(sum_wgt)/static_cast<Real>(nprocs*max_wgt);
+        amrex::Print() << "GRAPH efficiency: " << efficiency << '\n';
+    }
+}
+
 DistributionMapping
 DistributionMapping::makeKnapSack (const Vector<Real>& rcost, int nmax)
 {
@@ -1892,6 +2535,7 @@ DistributionMapping::makeSFC (const BoxArray& ba, bool use_box_vol, int nprocs)
 {
     BL_PROFILE("makeSFC");
 
+    const bool hilbert = (m_Strategy == HILBERT);
     const int N = static_cast<int>(ba.size());
     std::vector<SFCToken> tokens;
     std::vector<Long> wgts;
@@ -1901,13 +2545,14 @@ DistributionMapping::makeSFC (const BoxArray& ba, bool use_box_vol, int nprocs)
     for (int i = 0; i < N; ++i)
     {
         const Box& bx = ba[i];
-        tokens.push_back(makeSFCToken(i, bx.smallEnd()));
+        tokens.push_back(hilbert ? makeHilbertToken(i, bx.smallEnd())
+                                 : makeSFCToken(i, bx.smallEnd()));
         const Long v = use_box_vol ? bx.numPts() : Long(1);
         vol_sum += v;
         wgts.push_back(v);
     }
     //
-    // Put'm in Morton space filling curve order.
+    // Put'm in Morton or Hilbert space filling curve order.
     //
     std::sort(tokens.begin(), tokens.end(), SFCToken::Compare());
 
@@ -1920,6 +2565,270 @@ DistributionMapping::makeSFC (const BoxArray& ba, bool use_box_vol, int nprocs)
     return r;
 }
 
+DistributionMapping
+DistributionMapping::makeGraph (const MultiFab& weight)
+{
+    BL_PROFILE("makeGraph");
+    Vector<Long> cost = gather_weights(weight);
+    int nprocs = ParallelContext::NProcsSub();
+    DistributionMapping r;
+    r.GraphProcessorMap(weight.boxArray(), cost, nprocs);
+    return r;
+}
+
+DistributionMapping
+DistributionMapping::makeGraph (const Vector<Real>& rcost, const BoxArray& ba)
+{
+    BL_PROFILE("makeGraph");
+
+    DistributionMapping r;
+
+    Vector<Long> cost(rcost.size());
+
+    Real wmax = *std::max_element(rcost.begin(), rcost.end());
+    Real scale = (wmax == 0) ? 1.e9_rt : 1.e9_rt/wmax;
+
+    for (int i = 0; i < rcost.size(); ++i) {
+        cost[i] = Long(rcost[i]*scale) + 1L;
+    }
+
+    int nprocs = ParallelContext::NProcsSub();
+
+    r.GraphProcessorMap(ba, cost, nprocs);
+
+    return r;
+}
+
+std::vector<std::vector<int> >
+DistributionMapping::makeGraph (const BoxArray& ba, bool use_box_vol, int nprocs)
+{
+    BL_PROFILE("makeGraph");
+
+    const int N = static_cast<int>(ba.size());
+    std::vector<Long> wgts(N);
+    for (int i = 0; i < N; ++i) {
+        wgts[i] = use_box_vol ? ba[i].numPts() : Long(1);
+    }
+
+    auto const& part = graphPartition(ba, wgts, nprocs);
+
+    std::vector< std::vector<int> > r(nprocs);
+    for (int i = 0; i < N; ++i) {
+        r[part[i]].push_back(i);
+    }
+
+    return r;
+}
+
+namespace {
+
+    //
+    // Greedy rebalancing of the boxes among nprocs processes.  proc is the
+    // process of each box on entry and on exit.  Returns the bytes moved.
+    //
+    Long
+    rebalanceDoIt (std::vector<int>& proc, const std::vector<Long>& wgts,
+                   const Vector<Long>& bytes, int nprocs, Real migration_weight)
+    {
+        BL_PROFILE("DistributionMapping::rebalanceDoIt()");
+
+        const int N = static_cast<int>(proc.size());
+        const std::vector<int> home = proc;
+
+        std::vector<Long> load(nprocs, 0);
+        std::vector<std::vector<int>> boxes(nprocs);
+        Long total_wgt = 0, total_bytes = 0;
+        for (int i = 0; i < N; ++i) {
+            load[proc[i]] += wgts[i];
+            boxes[proc[i]].push_back(i);
+            total_wgt += wgts[i];
+            total_bytes += bytes[i];
+        }
+        const double avg = std::max(static_cast<double>(total_wgt)/nprocs, 1.0);
+        const double tb = static_cast<double>(std::max(total_bytes, Long(1)));
+        const auto alpha = static_cast<double>(migration_weight);
+
+        std::set<std::pair<Long,int>> by_load;
+        for (int p = 0; p < nprocs; ++p) {
+            by_load.emplace(load[p], p);
+        }
+
+        // change of the moved bytes if box i moves from process a to b
+        auto migration = [&] (int i, int a, int b) -> Long {
+            if (a == home[i]) { return bytes[i]; }
+            if (b == home[i]) { return -bytes[i]; }
+            return 0;
+        };
+
+        auto move_box = [&] (int i, int a, int b) {
+            by_load.erase({load[a],a});
+            by_load.erase({load[b],b});
+            load[a] -= wgts[i];
+            load[b] += wgts[i];
+            by_load.emplace(load[a],a);
+            by_load.emplace(load[b],b);
+            auto& ba = boxes[a];
+            ba.erase(std::find(ba.begin(), ba.end(), i));
+            boxes[b].push_back(i);
+            proc[i] = b;
+        };
+
+        struct Move { int i; int a; int b; };
+        std::vector<Move> moves;
+        Long moved = 0;
+        double best_obj = static_cast<double>(by_load.rbegin()->first) / avg;
+        std::size_t best_nmoves = 0;
+
+        constexpr int ncandidates = 4; // the least loaded processes tried
+        for (int step = 0; step < 2*N; ++step)
+        {
+            const int p = by_load.rbegin()->second;
+            const Long Lp = load[p];
+
+            double best_score = std::numeric_limits<double>::lowest();
+            int bi = -1, bj = -1, bq = -1;
+            int ic = 0;
+            for (auto it = by_load.begin(); it != by_load.end() && ic < ncandidates; ++it, ++ic)
+            {
+                const int q = it->second;
+                if (q == p) { break; }
+                const Long Lq = load[q];
+                for (int i : boxes[p]) {
+                    // move i from p to q
+                    const Long wi = wgts[i];
+                    if (Lq + wi < Lp) {
+                        const Long red = Lp - std::max(Lp-wi, Lq+wi);
+                        const double score = static_cast<double>(red)/avg
+                            - alpha*static_cast<double>(migration(i,p,q))/tb;
+                        if (score > best_score) {
+                            best_score = score; bi = i; bj = -1; bq = q;
+                        }
+                    }
+                    // swap i on p with j on q
+                    for (int j : boxes[q]) {
+                        const Long d = wi - wgts[j];
+                        if (d > 0 && Lq + d < Lp) {
+                            const Long red = Lp - std::max(Lp-d, Lq+d);
+                            const double score = static_cast<double>(red)/avg
+                                - alpha*static_cast<double>(migration(i,p,q)+migration(j,q,p))/tb;
+                            if (score > best_score) {
+                                best_score = score; bi = i; bj = j; bq = q;
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (bi < 0) { break; } // no move reduces the max load
+
+            moved += migration(bi,p,bq);
+            move_box(bi, p, bq);
+            moves.push_back({bi,p,bq});
+            if (bj >= 0) {
+                moved += migration(bj,bq,p);
+                move_box(bj, bq, p);
+                moves.push_back({bj,bq,p});
+            }
+
+            const double obj = static_cast<double>(by_load.rbegin()->first)/avg
+                + alpha*static_cast<double>(moved)/tb;
+            if (obj < best_obj) {
+                best_obj = obj;
+                best_nmoves = moves.size();
+            }
+        }
+
+        // Undo the moves after the best point.
+        while (moves.size() > best_nmoves) {
+            auto const& m = moves.back();
+            moved -= migration(m.i, m.a, m.b);
+            move_box(m.i, m.b, m.a);
+            moves.pop_back();
+        }
+
+        return moved;
+    }
+}
+
+DistributionMapping
+DistributionMapping::makeRebalance (const DistributionMapping& olddm,
+                                    const Vector<Real>& rcost,
+                                    const Vector<Long>& bytes,
+                                    Real migration_weight,
+                                    Real& currentEfficiency,
+                                    Real& proposedEfficiency,
+                                    Real* movedFraction)
+{
+    BL_PROFILE("makeRebalance");
+
+    const int N = static_cast<int>(rcost.size());
+    AMREX_ALWAYS_ASSERT(olddm.size() == N && bytes.size() == N);
+
+    std::vector<Long> cost(N);
+    Real wmax = *std::max_element(rcost.begin(), rcost.end());
+    Real scale = (wmax == 0) ? 1.e9_rt : 1.e9_rt/wmax;
+    for (int i = 0; i < N; ++i) {
+        cost[i] = Long(rcost[i]*scale) + 1L;
+    }
+
+    const int nprocs = ParallelContext::NProcsSub();
+    std::vector<int> proc(N);
+    for (int i = 0; i < N; ++i) {
+        proc[i] = ParallelContext::global_to_local_rank(olddm[i]);
+        AMREX_ALWAYS_ASSERT(proc[i] >= 0 && proc[i] < nprocs);
+    }
+
+    ComputeDistributionMappingEfficiency(olddm, cost, &currentEfficiency);
+
+    const Long moved = rebalanceDoIt(proc, cost, bytes, nprocs, migration_weight);
+
+    Vector<int> pmap(N);
+    for (int i = 0; i < N; ++i) {
+        pmap[i] = ParallelContext::local_to_global_rank(proc[i]);
+    }
+    DistributionMapping r(std::move(pmap));
+
+    ComputeDistributionMappingEfficiency(r, cost, &proposedEfficiency);
+
+    const Long total_bytes = std::accumulate(bytes.begin(), bytes.end(), Long(0));
+    const Real moved_fraction = static_cast<Real>(moved)
+        / static_cast<Real>(std::max(total_bytes,Long(1)));
+    if (movedFraction) { *movedFraction = moved_fraction; }
+
+    if (verbose) {
+        amrex::Print() << "Rebalance efficiency: " << currentEfficiency << " -> "
+                       << proposedEfficiency << ", fraction of data moved: "
+                       << moved_fraction << '\n';
+    }
+
+    return r;
+}
+
+DistributionMapping
+DistributionMapping::makeRebalance (const LayoutData<Real>& rcost_local,
+                                    Real migration_weight,
+                                    Real& currentEfficiency,
+                                    Real& proposedEfficiency,
+                                    Real* movedFraction)
+{
+    BL_PROFILE("makeRebalance");
+
+    // Every process computes the same mapping from the gathered costs.
+    const int root = ParallelContext::IOProcessorNumberSub();
+    Vector<Real> rcost(rcost_local.size());
+    ParallelDescriptor::GatherLayoutDataToVector<Real>(rcost_local, rcost, root);
+    ParallelDescriptor::Bcast(rcost.data(), rcost.size(), root);
+
+    const BoxArray& ba = rcost_local.boxArray();
+    Vector<Long> bytes(ba.size());
+    for (int i = 0, N = static_cast<int>(ba.size()); i < N; ++i) {
+        bytes[i] = ba[i].numPts();
+    }
+
+    return makeRebalance(rcost_local.DistributionMap(), rcost, bytes, migration_weight,
+                         currentEfficiency, proposedEfficiency, movedFraction);
+}
+
 const Vector<int>&
 DistributionMapping::getIndexArray ()
 {
@@ -8,6 +8,8 @@
 
 #include <AMReX_BArena.H>
 #include <AMReX_CArena.H>
+#include <AMReX_Compression.H>
+#include <AMReX_IOFormat.H>
 
 #ifdef AMREX_USE_GPU
 #include <AMReX_MFParallelForG.H>
@@ -17,12 +19,24 @@
 #include <AMReX_MemProfiler.H>
 #endif
 
+#ifdef AMREX_TINY_PROFILING
+#include <AMReX_TinyProfiler.H>
+#endif
+
 #ifdef AMREX_USE_EB
 #include <AMReX_EB2.H>
 #include <AMReX_EBFabFactory.H>
 #endif
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <list>
+#include <map>
+#include <numeric>
+#include <string>
 #include <utility>
 
 namespace amrex {
@@ -68,6 +82,7 @@ FabArrayBase::CFinfoCache          FabArrayBase::m_TheCrseFineCache;
 
 #ifdef AMREX_USE_GPU
 std::multimap<FabArrayBase::BDKey,FabArrayBase::ParForInfo*> FabArrayBase::m_TheParForCache;
+FabArrayBase::CacheStats           FabArrayBase::m_ParFor_stats("ParForCache");
 #endif
 
 FabArrayBase::CacheStats           FabArrayBase::m_TAC_stats("TileArrayCache");
@@ -76,6 +91,9 @@ FabArrayBase::CacheStats           FabArrayBase::m_CPC_stats("CopyCache");
 FabArrayBase::CacheStats           FabArrayBase::m_FPinfo_stats("FillPatchCache");
 FabArrayBase::CacheStats           FabArrayBase::m_CFinfo_stats("CrseFineCache");
 
+Long                               FabArrayBase::cache_max_bytes = 0;
+Long                               FabArrayBase::m_cache_clock = 0;
+
 std::map<FabArrayBase::BDKey, int> FabArrayBase::m_BD_count;
 
 FabArrayBase::FabArrayStats        FabArrayBase::m_FA_stats;
@@ -84,10 +102,106 @@ std::map<std::string,FabArrayBase::meminfo> FabArrayBase::m_mem_usage;
 std::vector<std::string>                    FabArrayBase::m_region_tag;
 
 bool                               FabArrayBase::m_alloc_single_chunk = false;
+bool                               FabArrayBase::m_node_shared = false;
+
+bool                               FabArrayBase::use_persistent_comm = false;
+FabArrayBase::CommEngine           FabArrayBase::comm_engine = FabArrayBase::CommEngine::PointToPoint;
+int                                FabArrayBase::neighbor_comm_max = 128;
+
+bool                               FabArrayBase::comm_compress = false;
+Long                               FabArrayBase::comm_compress_threshold = 65536;
+FabArrayBase::CommCompressStats    FabArrayBase::m_FB_compress_stats("FillBoundary");
+FabArrayBase::CommCompressStats    FabArrayBase::m_PC_compress_stats("ParallelCopy");
+
+bool                               FabArrayBase::comm_stats = false;
 
 namespace
 {
     bool initialized = false;
+    bool cache_budget_warned = false;
+    std::map<std::pair<int,std::string>,FabArrayBase::CommStats> comm_stats_map;
+    int comm_stats_op = -1;
+#ifdef AMREX_USE_MPI
+    MPI_Comm persistent_comm = MPI_COMM_NULL;
+    int persistent_tag = -1;
+    MPI_Comm node_shared_comm = MPI_COMM_NULL;
+    Vector<int> node_shared_rank;
+
+    //! A distributed graph communicator shared by the plans with the same neighbors.
+    struct GraphComm
+    {
+        Long        id;
+        Vector<int> sources;
+        Vector<int> destinations;
+        MPI_Comm    comm;
+        int         nrefs;
+    };
+    std::list<GraphComm> graph_comms;
+    Long graph_comm_next_id = 0;
+    //! If set, released communicators are kept until free_released_graph_comms.
+    bool graph_comm_defer_free = false;
+
+    /*
+    * Return a graph communicator with these neighbors, or MPI_COMM_NULL if
+    * there are already FabArrayBase::neighbor_comm_max of them.  This is
+    * collective.  The communicators are created and freed in the same
+    * order on all processes, so their ids agree.
+    */
+    MPI_Comm acquire_graph_comm (Vector<int> const& sources, Vector<int> const& destinations)
+    {
+        auto it = std::find_if(graph_comms.begin(), graph_comms.end(),
+                               [&] (GraphComm const& gc) {
+                                   return gc.sources == sources && gc.destinations == destinations;
+                               });
+        const Long id = (it == graph_comms.end()) ? Long(-1) : it->id;
+        Long r[2] = {id, -id};
+        ParallelDescriptor::ReduceLongMax(r, 2);
+        if (r[0] >= 0 && r[0] == -r[1]) {
+            ++(it->nrefs);
+            return it->comm;
+        } else if (static_cast<int>(graph_comms.size()) >= FabArrayBase::neighbor_comm_max) {
+            return MPI_COMM_NULL;
+        }
+
+        MPI_Comm comm;
+        BL_MPI_REQUIRE( MPI_Dist_graph_create_adjacent(ParallelDescriptor::Communicator(),
+                                                       static_cast<int>(sources.size()),
+                                                       sources.data(), MPI_UNWEIGHTED,
+                                                       static_cast<int>(destinations.size()),
+                                                       destinations.data(), MPI_UNWEIGHTED,
+                                                       MPI_INFO_NULL, 0, &comm) );
+        graph_comms.push_back(GraphComm{graph_comm_next_id++, sources, destinations, comm, 1});
+        return comm;
+    }
+
+    void release_graph_comm (MPI_Comm comm)
+    {
+        auto it = std::find_if(graph_comms.begin(), graph_comms.end(),
+                               [&] (GraphComm const& gc) { return gc.comm == comm; });
+        AMREX_ASSERT(it != graph_comms.end());
+        if (--(it->nrefs) == 0 && !graph_comm_defer_free) {
+            MPI_Comm_free(&(it->comm));
+            graph_comms.erase(it);
+        }
+    }
+
+    /*
+    * Free the communicators released while graph_comm_defer_free was set.
+    * They are freed in the order of creation, which is the same on all
+    * processes, whatever the order they were released in.
+    */
+    void free_released_graph_comms ()
+    {
+        for (auto it = graph_comms.begin(); it != graph_comms.end(); ) {
+            if (it->nrefs == 0) {
+                MPI_Comm_free(&(it->comm));
+                it = graph_comms.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+#endif
 }
 
 void
@@ -128,11 +242,41 @@ FabArrayBase::Initialize ()
         MaxComp = 1;
     }
 
+    pp.queryAdd("cache_max_bytes", FabArrayBase::cache_max_bytes);
+
+    pp.queryAdd("persistent_comm", FabArrayBase::use_persistent_comm);
+
+    {
+        std::string engine("p2p");
+        pp.queryAdd("comm_engine", engine);
+        if (engine == "p2p") {
+            FabArrayBase::comm_engine = CommEngine::PointToPoint;
+        } else if (engine == "neighbor") {
+            FabArrayBase::comm_engine = CommEngine::Neighbor;
+        } else {
+            amrex::Abort("FabArrayBase: unknown fabarray.comm_engine " + engine);
+        }
+    }
+    pp.queryAdd("neighbor_comm_max", FabArrayBase::neighbor_comm_max);
+
+    pp.queryAdd("comm_compress", FabArrayBase::comm_compress);
+    pp.queryAdd("comm_compress_threshold", FabArrayBase::comm_compress_threshold);
+    pp.queryAdd("comm_stats", FabArrayBase::comm_stats);
+
     ParmParse ppmf("amrex.mf");
     ppmf.queryAdd("alloc_single_chunk", FabArrayBase::m_alloc_single_chunk);
+    ppmf.queryAdd("node_shared", FabArrayBase::m_node_shared);
 
     amrex::ExecOnFinalize(FabArrayBase::Finalize);
 
+#ifdef AMREX_TINY_PROFILING
+    if (FabArrayBase::cache_max_bytes > 0) {
+        TinyProfiler::RegisterReport(FabArrayBase::printCacheStats);
+    }
+    TinyProfiler::RegisterReport(FabArrayBase::printCommCompressStats);
+    TinyProfiler::RegisterReport(FabArrayBase::printCommStats);
+#endif
+
 #ifdef AMREX_MEM_PROFILING
     MemProfiler::add(m_TAC_stats.name, std::function<MemProfiler::MemInfo()>
                      ([] () -> MemProfiler::MemInfo {
@@ -269,6 +413,10 @@ FabArrayBase::FB::bytes () const
         cnt += FabArrayBase::bytesOfMapOfCopyComTagContainers(*m_RcvTags);
     }
 
+    for (auto const& kv : m_split) {
+        cnt += kv.second.m_interior.bytes() + kv.second.m_boundary.bytes();
+    }
+
     return cnt;
 }
 
@@ -536,9 +684,7 @@ FabArrayBase::flushCPC (bool no_assertion) const
             }
         }
 
-#ifdef AMREX_MEM_PROFILING
-        m_CPC_stats.bytes -= it->second->bytes();
-#endif
+        m_CPC_stats.bytes -= it->second->m_nbytes;
         m_CPC_stats.recordErase(it->second->m_nuse);
         delete it->second;
     }
@@ -565,9 +711,7 @@ FabArrayBase::flushCPCache ()
         delete c;
     }
     m_TheCPCache.clear();
-#ifdef AMREX_MEM_PROFILING
     m_CPC_stats.bytes = 0L;
-#endif
 }
 
 const FabArrayBase::CPC&
@@ -597,6 +741,7 @@ FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVe
             it->second->m_dstba  == boxArray())
         {
             ++(it->second->m_nuse);
+            it->second->m_last_use = ++m_cache_clock;
             m_CPC_stats.recordUse();
             return *(it->second);
         }
@@ -605,15 +750,16 @@ FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVe
     // Have to build a new one
     CPC* new_cpc = new CPC(*this, dstng, src, srcng, period, to_ghost_cells_only);
 
-#ifdef AMREX_MEM_PROFILING
-    m_CPC_stats.bytes += new_cpc->bytes();
-    m_CPC_stats.bytes_hwm = std::max(m_CPC_stats.bytes_hwm, m_CPC_stats.bytes);
-#endif
+    new_cpc->m_nbytes = new_cpc->bytes();
+    evictCaches(new_cpc->m_nbytes);
+    m_CPC_stats.recordBytes(new_cpc->m_nbytes);
 
     new_cpc->m_nuse = 1;
+    new_cpc->m_last_use = ++m_cache_clock;
     m_CPC_stats.recordBuild();
     m_CPC_stats.recordUse();
 
+    er_it = m_TheCPCache.equal_range(dstkey);
     m_TheCPCache.insert(er_it.second, CPCache::value_type(dstkey,new_cpc));
     if (srckey != dstkey) {
         m_TheCPCache.insert(          CPCache::value_type(srckey,new_cpc));
@@ -654,6 +800,82 @@ FabArrayBase::FB::FB (const FabArrayBase& fa, const IntVect& nghost,
     }
 }
 
+const FabArrayBase::FB::SplitTileArray&
+FabArrayBase::FB::getSplitTileArray (const FabArrayBase& fa, const IntVect& stencil,
+                                     const IntVect& tilesize) const
+{
+    SplitTileArray* p = nullptr;
+
+#ifdef AMREX_USE_OMP
+#pragma omp critical(getsplittilearray)
+#endif
+    {
+        auto key = std::make_pair(stencil, tilesize);
+        auto found = m_split.find(key);
+        if (found != m_split.end()) {
+            p = &(found->second);
+        } else {
+            BL_PROFILE("FabArrayBase::FB::getSplitTileArray()");
+
+            p = &m_split[key];
+
+            const BoxArray& ba = fa.boxArray();
+            const int N = static_cast<int>(fa.IndexArray().size());
+
+            // Cells whose stencil reaches ghost cells received from other
+            // processes.  For nodal data, node i is updated by cell i or,
+            // at the high end of the valid box, by cell i-1.
+            Vector<BoxList> dep(N);
+            for (auto const& kv : *m_RcvTags) {
+                for (auto const& tag : kv.second) {
+                    Box gbx = amrex::grow(tag.dbox, stencil);
+                    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                        if (m_typ.nodeCentered(d)) { gbx.growLo(d, 1); }
+                    }
+                    gbx.setType(IndexType::TheCellType());
+                    gbx &= ba.getCellCenteredBox(tag.dstIndex);
+                    if (gbx.ok()) {
+                        dep[fa.localindex(tag.dstIndex)].push_back(gbx);
+                    }
+                }
+            }
+
+            auto add_tiles = [&] (TileArray& ta, int K, int i, BoxList&& bl)
+            {
+                if (tilesize != IntVect::TheZeroVector()) {
+                    bl.maxSize(tilesize);
+                }
+                const int ntiles = static_cast<int>(bl.size());
+                int t = 0;
+                for (auto const& bx : bl) {
+                    ta.indexMap.push_back(K);
+                    ta.localIndexMap.push_back(i);
+                    ta.localTileIndexMap.push_back(t++);
+                    ta.numLocalTiles.push_back(ntiles);
+                    ta.tileArray.push_back(bx);
+                }
+            };
+
+            for (int i = 0; i < N; ++i) {
+                const int K = fa.IndexArray()[i];
+                const Box& vbx = ba.getCellCenteredBox(K);
+                if (dep[i].isEmpty()) {
+                    add_tiles(p->m_interior, K, i, BoxList(vbx));
+                } else {
+                    BoxList interior = amrex::complementIn(vbx, dep[i]);
+                    interior.simplify();
+                    BoxList boundary = amrex::complementIn(vbx, interior);
+                    boundary.simplify();
+                    add_tiles(p->m_interior, K, i, std::move(interior));
+                    add_tiles(p->m_boundary, K, i, std::move(boundary));
+                }
+            }
+        }
+    }
+
+    return *p;
+}
+
 void
 FabArrayBase::define_fb_metadata (CommMetaData& cmd, const IntVect& nghost,
                                   bool cross, const Periodicity& period,
@@ -1187,9 +1409,7 @@ FabArrayBase::flushFB (bool no_assertion) const
     std::pair<FBCacheIter,FBCacheIter> er_it = m_TheFBCache.equal_range(m_bdkey);
     for (auto it = er_it.first; it != er_it.second; ++it)
     {
-#ifdef AMREX_MEM_PROFILING
-        m_FBC_stats.bytes -= it->second->bytes();
-#endif
+        m_FBC_stats.bytes -= it->second->m_nbytes;
         m_FBC_stats.recordErase(it->second->m_nuse);
         delete it->second;
     }
@@ -1205,9 +1425,7 @@ FabArrayBase::flushFBCache ()
         delete it.second;
     }
     m_TheFBCache.clear();
-#ifdef AMREX_MEM_PROFILING
     m_FBC_stats.bytes = 0L;
-#endif
 }
 
 const FabArrayBase::FB&
@@ -1231,6 +1449,7 @@ FabArrayBase::getFB (const IntVect& nghost, const Periodicity& period,
             it->second->m_period     == period              )
         {
             ++(it->second->m_nuse);
+            it->second->m_last_use = ++m_cache_clock;
             m_FBC_stats.recordUse();
             return *(it->second);
         }
@@ -1240,20 +1459,592 @@ FabArrayBase::getFB (const IntVect& nghost, const Periodicity& period,
     FB* new_fb = new FB(*this, nghost, cross, period, enforce_periodicity_only,
                         override_sync, m_multi_ghost);
 
-#ifdef AMREX_MEM_PROFILING
-    m_FBC_stats.bytes += new_fb->bytes();
-    m_FBC_stats.bytes_hwm = std::max(m_FBC_stats.bytes_hwm, m_FBC_stats.bytes);
-#endif
+    new_fb->m_nbytes = new_fb->bytes();
+    evictCaches(new_fb->m_nbytes);
+    m_FBC_stats.recordBytes(new_fb->m_nbytes);
 
     new_fb->m_nuse = 1;
+    new_fb->m_last_use = ++m_cache_clock;
     m_FBC_stats.recordBuild();
     m_FBC_stats.recordUse();
 
+    er_it = m_TheFBCache.equal_range(m_bdkey);
     m_TheFBCache.insert(er_it.second, FBCache::value_type(m_bdkey,new_fb));
 
     return *new_fb;
 }
 
+#ifdef AMREX_USE_MPI
+
+namespace {
+    // The same datatype selection as ParallelDescriptor::Asend<char> and
+    // Arecv<char> so that CheckRcvStats works for persistent requests too.
+    std::pair<MPI_Datatype,int> persistent_comm_type (std::size_t nbytes)
+    {
+        const int comm_data_type = ParallelDescriptor::select_comm_data_type(nbytes);
+        if (comm_data_type == 1) {
+            return {ParallelDescriptor::Mpi_typemap<char>::type(),
+                    static_cast<int>(nbytes)};
+        } else if (comm_data_type == 2) {
+            return {ParallelDescriptor::Mpi_typemap<unsigned long long>::type(),
+                    static_cast<int>(nbytes/sizeof(unsigned long long))};
+        } else if (comm_data_type == 3) {
+            return {ParallelDescriptor::Mpi_typemap<ParallelDescriptor::lull_t>::type(),
+                    static_cast<int>(nbytes/sizeof(ParallelDescriptor::lull_t))};
+        } else {
+            amrex::Abort("FabArrayBase: a message of " + std::to_string(nbytes)
+                         + " bytes in a persistent or neighbor plan is too big for MPI");
+            return {MPI_DATATYPE_NULL, 0};
+        }
+    }
+
+    // Assign one buffer per process in tags.  The sizes are aligned to
+    // align(nbytes), and the offsets to max(alignof_buf,align(nbytes)).
+    // The total volume is returned.
+    template <typename F>
+    std::size_t layout_comm_buffers (FabArrayBase::MapOfCopyComTagContainers const& tags,
+                                     bool is_recv, int ncomp, std::size_t sizeof_buf,
+                                     std::size_t alignof_buf, F const& align,
+                                     Vector<int>& ranks, Vector<std::size_t>& sizes,
+                                     Vector<const FabArrayBase::CopyComTagsContainer*>& cctc,
+                                     Vector<std::size_t>& offset)
+    {
+        std::size_t total_volume = 0;
+        for (auto const& kv : tags)
+        {
+            std::size_t nbytes = 0;
+            for (auto const& cct : kv.second) {
+                nbytes += (is_recv ? cct.dbox.numPts() : cct.sbox.numPts()) * ncomp * sizeof_buf;
+            }
+            if (nbytes == 0) { continue; }
+
+            std::size_t acd = align(nbytes);
+            nbytes = amrex::aligned_size(acd, nbytes); // so that bytes are aligned
+
+            // Also need to align the offset properly
+            total_volume = amrex::aligned_size(std::max(alignof_buf, acd), total_volume);
+
+            offset.push_back(total_volume);
+            total_volume += nbytes;
+
+            ranks.push_back(kv.first);
+            sizes.push_back(nbytes);
+            cctc.push_back(&(kv.second));
+        }
+        return total_volume;
+    }
+}
+
+MPI_Comm
+FabArrayBase::persistentCommunicator ()
+{
+    return persistent_comm;
+}
+
+MPI_Comm
+FabArrayBase::nodeSharedCommunicator ()
+{
+    if (node_shared_comm == MPI_COMM_NULL) {
+        MPI_Comm comm = ParallelDescriptor::Communicator();
+        BL_MPI_REQUIRE( MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED,
+                                            ParallelDescriptor::MyProc(), MPI_INFO_NULL,
+                                            &node_shared_comm) );
+        const int nprocs = ParallelDescriptor::NProcs();
+        Vector<int> global(nprocs);
+        std::iota(global.begin(), global.end(), 0);
+        node_shared_rank.resize(nprocs);
+        MPI_Group global_group, node_group;
+        BL_MPI_REQUIRE( MPI_Comm_group(comm, &global_group) );
+        BL_MPI_REQUIRE( MPI_Comm_group(node_shared_comm, &node_group) );
+        BL_MPI_REQUIRE( MPI_Group_translate_ranks(global_group, nprocs, global.data(),
+                                                  node_group, node_shared_rank.data()) );
+        BL_MPI_REQUIRE( MPI_Group_free(&global_group) );
+        BL_MPI_REQUIRE( MPI_Group_free(&node_group) );
+        for (auto& r : node_shared_rank) {
+            if (r == MPI_UNDEFINED) { r = -1; }
+        }
+    }
+    return node_shared_comm;
+}
+
+int
+FabArrayBase::nodeSharedRank (int global_rank)
+{
+    nodeSharedCommunicator();
+    return node_shared_rank[global_rank];
+}
+
+void
+FabArrayBase::nodeSharedBarrier ()
+{
+    std::atomic_thread_fence(std::memory_order_release);
+    BL_MPI_REQUIRE( MPI_Barrier(nodeSharedCommunicator()) );
+    std::atomic_thread_fence(std::memory_order_acquire);
+}
+
+FabArrayBase::CommPlan::CommPlan (Kind kind, const MapOfCopyComTagContainers& SndTags,
+                                  const MapOfCopyComTagContainers& RcvTags, int ncomp,
+                                  std::size_t sizeof_buf)
+    : m_kind(kind), m_ncomp(ncomp), m_sizeof_buf(sizeof_buf)
+{
+    recv_from.reserve(RcvTags.size());
+    recv_size.reserve(RcvTags.size());
+    recv_cctc.reserve(RcvTags.size());
+    send_rank.reserve(SndTags.size());
+    send_size.reserve(SndTags.size());
+    send_cctc.reserve(SndTags.size());
+}
+
+FabArrayBase::CommPlan::~CommPlan ()
+{
+    if (the_recv_data) { The_Comms_Arena()->free(the_recv_data); }
+    if (the_send_data) { The_Comms_Arena()->free(the_send_data); }
+}
+
+Long
+FabArrayBase::CommPlan::bytes () const
+{
+    Long cnt = 0;
+    for (auto nbytes : recv_size) { cnt += static_cast<Long>(nbytes); }
+    for (auto nbytes : send_size) { cnt += static_cast<Long>(nbytes); }
+    cnt += amrex::bytesOf(recv_from) + amrex::bytesOf(recv_data) + amrex::bytesOf(recv_size)
+        +  amrex::bytesOf(recv_cctc) + amrex::bytesOf(send_rank) + amrex::bytesOf(send_data)
+        +  amrex::bytesOf(send_size) + amrex::bytesOf(send_cctc);
+    return cnt;
+}
+
+FabArrayBase::PersistentComm::PersistentComm (const MapOfCopyComTagContainers& SndTags,
+                                              const MapOfCopyComTagContainers& RcvTags,
+                                              int ncomp, std::size_t sizeof_buf,
+                                              std::size_t alignof_buf)
+    : CommPlan(CommPlan::Persistent, SndTags, RcvTags, ncomp, sizeof_buf)
+{
+    BL_PROFILE("FabArrayBase::PersistentComm()");
+
+    // Plans are built collectively in the same order on all processes.
+    // Therefore the communicator and the tags match across processes.
+    if (persistent_comm == MPI_COMM_NULL) {
+        BL_MPI_REQUIRE( MPI_Comm_dup(ParallelDescriptor::Communicator(), &persistent_comm) );
+    }
+    persistent_tag = (persistent_tag >= ParallelDescriptor::MinTag() &&
+                      persistent_tag <  ParallelDescriptor::MaxTag())
+        ? persistent_tag+1 : ParallelDescriptor::MinTag();
+    m_tag = persistent_tag;
+
+    auto align = [] (std::size_t nbytes) {
+        return ParallelDescriptor::sizeof_selected_comm_data_type(nbytes);
+    };
+
+    Vector<std::size_t> recv_offset;
+    std::size_t recv_volume = layout_comm_buffers(RcvTags, true, ncomp, sizeof_buf, alignof_buf,
+                                                  align, recv_from, recv_size, recv_cctc,
+                                                  recv_offset);
+    Vector<std::size_t> send_offset;
+    std::size_t send_volume = layout_comm_buffers(SndTags, false, ncomp, sizeof_buf, alignof_buf,
+                                                  align, send_rank, send_size, send_cctc,
+                                                  send_offset);
+
+    if (recv_volume > 0) {
+        the_recv_data = static_cast<char*>(The_Comms_Arena()->alloc(recv_volume));
+    }
+    if (send_volume > 0) {
+        the_send_data = static_cast<char*>(The_Comms_Arena()->alloc(send_volume));
+    }
+
+    const auto nrecv = static_cast<int>(recv_from.size());
+    recv_data.resize(nrecv);
+    recv_reqs.resize(nrecv, MPI_REQUEST_NULL);
+    recv_stat.resize(nrecv);
+    for (int i = 0; i < nrecv; ++i) {
+        recv_data[i] = the_recv_data + recv_offset[i];
+        auto [dtype, count] = persistent_comm_type(recv_size[i]);
+        BL_MPI_REQUIRE( MPI_Recv_init(recv_data[i], count, dtype, recv_from[i], m_tag,
+                                      persistent_comm, &(recv_reqs[i])) );
+    }
+
+    const auto nsend = static_cast<int>(send_rank.size());
+    send_data.resize(nsend);
+    send_reqs.resize(nsend, MPI_REQUEST_NULL);
+    send_stat.resize(nsend);
+    for (int i = 0; i < nsend; ++i) {
+        send_data[i] = the_send_data + send_offset[i];
+        auto [dtype, count] = persistent_comm_type(send_size[i]);
+        BL_MPI_REQUIRE( MPI_Send_init(send_data[i], count, dtype, send_rank[i], m_tag,
+                                      persistent_comm, &(send_reqs[i])) );
+    }
+}
+
+FabArrayBase::PersistentComm::~PersistentComm ()
+{
+    for (auto& req : recv_reqs) {
+        if (req != MPI_REQUEST_NULL) { MPI_Request_free(&req); }
+    }
+    for (auto& req : send_reqs) {
+        if (req != MPI_REQUEST_NULL) { MPI_Request_free(&req); }
+    }
+}
+
+Long
+FabArrayBase::PersistentComm::bytes () const
+{
+    return sizeof(PersistentComm) + CommPlan::bytes()
+        + amrex::bytesOf(recv_reqs) + amrex::bytesOf(recv_stat)
+        + amrex::bytesOf(send_reqs) + amrex::bytesOf(send_stat);
+}
+
+void
+FabArrayBase::PersistentComm::startRecvs ()
+{
+    if (!recv_reqs.empty()) {
+        BL_MPI_REQUIRE( MPI_Startall(static_cast<int>(recv_reqs.size()), recv_reqs.data()) );
+    }
+}
+
+void
+FabArrayBase::PersistentComm::startSends ()
+{
+    if (!send_reqs.empty()) {
+        BL_MPI_REQUIRE( MPI_Startall(static_cast<int>(send_reqs.size()), send_reqs.data()) );
+    }
+}
+
+void
+FabArrayBase::PersistentComm::testRecvs ()
+{
+#if !defined(AMREX_DEBUG)
+    // We only test if no DEBUG because in DEBUG we check the status later.
+    if (!recv_reqs.empty()) {
+        int flag;
+        ParallelDescriptor::Test(recv_reqs, flag, recv_stat);
+    }
+#endif
+}
+
+void
+FabArrayBase::PersistentComm::waitRecvs ()
+{
+    if (!recv_reqs.empty()) {
+        ParallelDescriptor::Waitall(recv_reqs, recv_stat);
+#ifdef AMREX_DEBUG
+        if (!CheckRcvStats(recv_stat, recv_size, m_tag))
+        {
+            amrex::Abort("PersistentComm::waitRecvs failed with wrong message size");
+        }
+#endif
+    }
+}
+
+void
+FabArrayBase::PersistentComm::waitSends ()
+{
+    if (!send_reqs.empty()) {
+        ParallelDescriptor::Waitall(send_reqs, send_stat);
+    }
+}
+
+FabArrayBase::NeighborComm::NeighborComm (const MapOfCopyComTagContainers& SndTags,
+                                          const MapOfCopyComTagContainers& RcvTags,
+                                          int ncomp, std::size_t sizeof_buf,
+                                          std::size_t alignof_buf)
+    : CommPlan(CommPlan::Neighbor, SndTags, RcvTags, ncomp, sizeof_buf)
+{
+    BL_PROFILE("FabArrayBase::NeighborComm()");
+
+    // Counts and displacements are int.  So we might have to use a bigger
+    // datatype.  All processes must agree on it.
+    Long max_volume = 0;
+    for (auto const* tags : {&RcvTags, &SndTags}) {
+        Long volume = 0;
+        for (auto const& kv : *tags) {
+            for (auto const& cct : kv.second) {
+                volume += cct.dbox.numPts() * ncomp * static_cast<Long>(sizeof_buf)
+                    + static_cast<Long>(std::max(alignof_buf,sizeof(ParallelDescriptor::lull_t)));
+            }
+        }
+        max_volume = std::max(max_volume, volume);
+    }
+    ParallelDescriptor::ReduceLongMax(max_volume);
+
+    std::size_t unit;
+    if (max_volume <= Long(std::numeric_limits<int>::max())) {
+        m_type = ParallelDescriptor::Mpi_typemap<char>::type();
+        unit = 1;
+    } else if (max_volume <= Long(sizeof(unsigned long long))*std::numeric_limits<int>::max()) {
+        m_type = ParallelDescriptor::Mpi_typemap<unsigned long long>::type();
+        unit = sizeof(unsigned long long);
+    } else {
+        m_type = ParallelDescriptor::Mpi_typemap<ParallelDescriptor::lull_t>::type();
+        unit = sizeof(ParallelDescriptor::lull_t);
+    }
+
+    auto align = [=] (std::size_t) { return unit; };
+
+    Vector<std::size_t> recv_offset;
+    std::size_t recv_volume = layout_comm_buffers(RcvTags, true, ncomp, sizeof_buf, alignof_buf,
+                                                  align, recv_from, recv_size, recv_cctc,
+                                                  recv_offset);
+    Vector<std::size_t> send_offset;
+    std::size_t send_volume = layout_comm_buffers(SndTags, false, ncomp, sizeof_buf, alignof_buf,
+                                                  align, send_rank, send_size, send_cctc,
+                                                  send_offset);
+
+    // The neighbors are in the same order as the buffers.
+    m_comm = acquire_graph_comm(recv_from, send_rank);
+    if (m_comm == MPI_COMM_NULL) { return; }
+
+    if (recv_volume > 0) {
+        the_recv_data = static_cast<char*>(The_Comms_Arena()->alloc(recv_volume));
+    }
+    if (send_volume > 0) {
+        the_send_data = static_cast<char*>(The_Comms_Arena()->alloc(send_volume));
+    }
+
+    const auto nrecv = static_cast<int>(recv_from.size());
+    recv_data.resize(nrecv);
+    recv_counts.resize(nrecv);
+    recv_displs.resize(nrecv);
+    for (int i = 0; i < nrecv; ++i) {
+        recv_data[i] = the_recv_data + recv_offset[i];
+        recv_counts[i] = static_cast<int>(recv_size[i] / unit);
+        recv_displs[i] = static_cast<int>(recv_offset[i] / unit);
+    }
+
+    const auto nsend = static_cast<int>(send_rank.size());
+    send_data.resize(nsend);
+    send_counts.resize(nsend);
+    send_displs.resize(nsend);
+    for (int i = 0; i < nsend; ++i) {
+        send_data[i] = the_send_data + send_offset[i];
+        send_counts[i] = static_cast<int>(send_size[i] / unit);
+        send_displs[i] = static_cast<int>(send_offset[i] / unit);
+    }
+
+#if defined(MPI_VERSION) && (MPI_VERSION >= 4)
+    BL_MPI_REQUIRE( MPI_Neighbor_alltoallv_init(the_send_data, send_counts.data(),
+                                                send_displs.data(), m_type,
+                                                the_recv_data, recv_counts.data(),
+                                                recv_displs.data(), m_type,
+                                                m_comm, MPI_INFO_NULL, &m_req) );
+    m_persistent = true;
+#endif
+}
+
+FabArrayBase::NeighborComm::~NeighborComm ()
+{
+    if (m_persistent && m_req != MPI_REQUEST_NULL) { MPI_Request_free(&m_req); }
+    if (m_comm != MPI_COMM_NULL) { release_graph_comm(m_comm); }
+}
+
+int
+FabArrayBase::numNeighborComms ()
+{
+    return static_cast<int>(graph_comms.size());
+}
+
+Long
+FabArrayBase::NeighborComm::bytes () const
+{
+    return sizeof(NeighborComm) + CommPlan::bytes()
+        + amrex::bytesOf(recv_counts) + amrex::bytesOf(recv_displs)
+        + amrex::bytesOf(send_counts) + amrex::bytesOf(send_displs);
+}
+
+void
+FabArrayBase::NeighborComm::startSends ()
+{
+    if (m_persistent) {
+        BL_MPI_REQUIRE( MPI_Start(&m_req) );
+    } else {
+        BL_MPI_REQUIRE( MPI_Ineighbor_alltoallv(the_send_data, send_counts.data(),
+                                                send_displs.data(), m_type,
+                                                the_recv_data, recv_counts.data(),
+                                                recv_displs.data(), m_type,
+                                                m_comm, &m_req) );
+    }
+}
+
+void
+FabArrayBase::NeighborComm::testRecvs ()
+{
+    int flag;
+    MPI_Status status;
+    BL_MPI_REQUIRE( MPI_Test(&m_req, &flag, &status) );
+}
+
+void
+FabArrayBase::NeighborComm::waitRecvs ()
+{
+    MPI_Status status;
+    BL_MPI_REQUIRE( MPI_Wait(&m_req, &status) );
+}
+
+FabArrayBase::CommPlan*
+FabArrayBase::CommMetaData::getCommPlan (CommPlan::Kind kind, int ncomp, std::size_t sizeof_buf,
+                                         std::size_t alignof_buf) const
+{
+    if (m_plan && m_plan->m_active) {
+        // e.g., FillBoundary_nowait on several FabArrays sharing this FB
+        return nullptr;
+    }
+    if (!m_plan || !m_plan->matches(kind, ncomp, sizeof_buf)) {
+        m_plan.reset();
+        if (kind == CommPlan::Neighbor) {
+            m_plan = std::make_unique<NeighborComm>(*m_SndTags, *m_RcvTags, ncomp,
+                                                    sizeof_buf, alignof_buf);
+        } else {
+            m_plan = std::make_unique<PersistentComm>(*m_SndTags, *m_RcvTags, ncomp,
+                                                      sizeof_buf, alignof_buf);
+        }
+    }
+    // An unusable plan is kept so that it is not rebuilt on every call.
+    return m_plan->usable() ? m_plan.get() : nullptr;
+}
+
+FabArrayBase::CommMetaData::NodeSplitTags const&
+FabArrayBase::CommMetaData::getNodeSplitTags () const
+{
+    if (!m_node_split) {
+        m_node_split = std::make_unique<NodeSplitTags>();
+        m_node_split->m_SndTags = std::make_unique<MapOfCopyComTagContainers>();
+        m_node_split->m_RcvTags = std::make_unique<MapOfCopyComTagContainers>();
+        for (auto const& kv : *m_SndTags) {
+            if (nodeSharedRank(kv.first) < 0) {
+                m_node_split->m_SndTags->insert(kv);
+            }
+        }
+        for (auto const& kv : *m_RcvTags) {
+            if (nodeSharedRank(kv.first) < 0) {
+                m_node_split->m_RcvTags->insert(kv);
+            } else {
+                m_node_split->m_NodeTags.insert(m_node_split->m_NodeTags.end(),
+                                                kv.second.begin(), kv.second.end());
+            }
+        }
+    }
+    return *m_node_split;
+}
+
+FabArrayBase::CommPlan*
+FabArrayBase::selectCommPlan (CommMetaData const& cmd, int ncomp, std::size_t sizeof_buf,
+                              std::size_t alignof_buf, bool allow_persistent)
+{
+    // The plans are built on ParallelDescriptor::Communicator() with global ranks.
+    // Compressed messages do not have the fixed sizes of the plans.
+    if (ParallelContext::CommunicatorSub() != ParallelDescriptor::Communicator() ||
+        comm_compress) {
+        return nullptr;
+    } else if (comm_engine == CommEngine::Neighbor) {
+        return cmd.getCommPlan(CommPlan::Neighbor, ncomp, sizeof_buf, alignof_buf);
+    } else if (use_persistent_comm && allow_persistent) {
+        return cmd.getCommPlan(CommPlan::Persistent, ncomp, sizeof_buf, alignof_buf);
+    } else {
+        return nullptr;
+    }
+}
+
+void
+FabArrayBase::compressSendBuffers (Vector<char*>& send_data, Vector<std::size_t>& send_size,
+                                   std::size_t sizeof_buf, char*& the_zdata,
+                                   CommCompressStats& stats)
+{
+    the_zdata = nullptr;
+
+    // Only messages sent as MPI_CHAR are compressed, so that the receiver
+    // can tell them from the others by their size.
+    Vector<int> imsg;
+    Vector<std::size_t> offset;
+    std::size_t total = 0;
+    for (int i = 0, N = static_cast<int>(send_size.size()); i < N; ++i) {
+        if (send_size[i] >= static_cast<std::size_t>(comm_compress_threshold) &&
+            ParallelDescriptor::select_comm_data_type(send_size[i]) == 1)
+        {
+            imsg.push_back(i);
+            offset.push_back(total);
+            total += send_size[i];
+        }
+    }
+    if (imsg.empty()) { return; }
+
+    BL_PROFILE("FabArrayBase::compressSendBuffers()");
+    const double t0 = amrex::second();
+
+    the_zdata = static_cast<char*>(The_Comms_Arena()->alloc(total));
+
+    const auto N = static_cast<int>(imsg.size());
+    Vector<std::size_t> zsize(N);
+#ifdef AMREX_USE_OMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int m = 0; m < N; ++m) {
+        const int i = imsg[m];
+        // Only accept results smaller than the original message.
+        zsize[m] = Compression::compress(send_data[i], send_size[i], sizeof_buf,
+                                         the_zdata+offset[m], send_size[i]-1);
+    }
+
+    ++stats.nexchanges;
+    for (int m = 0; m < N; ++m) {
+        const int i = imsg[m];
+        ++stats.nmsgs;
+        stats.raw_bytes += static_cast<Long>(send_size[i]);
+        if (zsize[m] > 0) {
+            ++stats.ncompressed;
+            send_data[i] = the_zdata + offset[m];
+            send_size[i] = zsize[m];
+        }
+        stats.sent_bytes += static_cast<Long>(send_size[i]);
+    }
+
+    stats.compress_time += amrex::second() - t0;
+}
+
+void
+FabArrayBase::decompressRecvBuffers (Vector<char*> const& recv_data,
+                                     Vector<std::size_t> const& recv_size,
+                                     Vector<MPI_Status> const& recv_stat,
+                                     CommCompressStats& stats)
+{
+    Vector<int> imsg;
+    for (int i = 0, N = static_cast<int>(recv_size.size()); i < N; ++i) {
+        if (recv_size[i] >= static_cast<std::size_t>(comm_compress_threshold) &&
+            ParallelDescriptor::select_comm_data_type(recv_size[i]) == 1)
+        {
+            int count = 0;
+            MPI_Get_count(const_cast<MPI_Status*>(&recv_stat[i]), MPI_CHAR, &count);
+            if (count != MPI_UNDEFINED && static_cast<std::size_t>(count) < recv_size[i]) {
+                imsg.push_back(i);
+            }
+        }
+    }
+    if (imsg.empty()) { return; }
+
+    BL_PROFILE("FabArrayBase::decompressRecvBuffers()");
+    const double t0 = amrex::second();
+
+    const auto N = static_cast<int>(imsg.size());
+    int nerrors = 0;
+#ifdef AMREX_USE_OMP
+#pragma omp parallel for schedule(dynamic) reduction(+:nerrors)
+#endif
+    for (int m = 0; m < N; ++m) {
+        const int i = imsg[m];
+        int count = 0;
+        MPI_Get_count(const_cast<MPI_Status*>(&recv_stat[i]), MPI_CHAR, &count);
+        // The compressed data occupy the beginning of the receive buffer.
+        Vector<char> zbuf(recv_data[i], recv_data[i]+count);
+        if (!Compression::decompress(zbuf.data(), zbuf.size(), recv_data[i], recv_size[i])) {
+            ++nerrors;
+        }
+    }
+    if (nerrors > 0) {
+        amrex::Abort("FabArrayBase::decompressRecvBuffers: invalid compressed message");
+    }
+
+    stats.decompress_time += amrex::second() - t0;
+}
+
+#endif
+
 FabArrayBase::RB90::RB90 (const FabArrayBase& fa, const IntVect& nghost, Box const& domain)
     : m_ngrow(nghost), m_domain(domain)
 {
@@ -2004,6 +2795,7 @@ FabArrayBase::TheFPinfo (const FabArrayBase& srcfa,
             it->second->m_coarsener->doit(it->second->m_dstdomain) == coarsener.doit(dstdomain))
         {
             ++(it->second->m_nuse);
+            it->second->m_last_use = ++m_cache_clock;
             m_FPinfo_stats.recordUse();
             return *(it->second);
         }
@@ -2013,15 +2805,16 @@ FabArrayBase::TheFPinfo (const FabArrayBase& srcfa,
     auto *new_fpc = new FPinfo(srcfa, dstfa, dstdomain, dstng, coarsener,
                               fgeom.Domain(), cgeom.Domain(), index_space);
 
-#ifdef AMREX_MEM_PROFILING
-    m_FPinfo_stats.bytes += new_fpc->bytes();
-    m_FPinfo_stats.bytes_hwm = std::max(m_FPinfo_stats.bytes_hwm, m_FPinfo_stats.bytes);
-#endif
+    new_fpc->m_nbytes = new_fpc->bytes();
+    evictCaches(new_fpc->m_nbytes);
+    m_FPinfo_stats.recordBytes(new_fpc->m_nbytes);
 
     new_fpc->m_nuse = 1;
+    new_fpc->m_last_use = ++m_cache_clock;
     m_FPinfo_stats.recordBuild();
     m_FPinfo_stats.recordUse();
 
+    er_it = m_TheFillPatchCache.equal_range(dstkey);
     m_TheFillPatchCache.insert(er_it.second, FPinfoCache::value_type(dstkey,new_fpc));
     if (srckey != dstkey) {
         m_TheFillPatchCache.insert(          FPinfoCache::value_type(srckey,new_fpc));
@@ -2060,9 +2853,7 @@ FabArrayBase::flushFPinfo (bool no_assertion) const
             }
         }
 
-#ifdef AMREX_MEM_PROFILING
-        m_FPinfo_stats.bytes -= it->second->bytes();
-#endif
+        m_FPinfo_stats.bytes -= it->second->m_nbytes;
         m_FPinfo_stats.recordErase(it->second->m_nuse);
         delete it->second;
     }
@@ -2166,6 +2957,7 @@ FabArrayBase::TheCFinfo (const FabArrayBase& finefa,
             it->second->m_ng          == ng)
         {
             ++(it->second->m_nuse);
+            it->second->m_last_use = ++m_cache_clock;
             m_CFinfo_stats.recordUse();
             return *(it->second);
         }
@@ -2174,15 +2966,16 @@ FabArrayBase::TheCFinfo (const FabArrayBase& finefa,
     // Have to build a new one
     auto *new_cfinfo = new CFinfo(finefa, finegm, ng, include_periodic, include_physbndry);
 
-#ifdef AMREX_MEM_PROFILING
-    m_CFinfo_stats.bytes += new_cfinfo->bytes();
-    m_CFinfo_stats.bytes_hwm = std::max(m_CFinfo_stats.bytes_hwm, m_CFinfo_stats.bytes);
-#endif
+    new_cfinfo->m_nbytes = new_cfinfo->bytes();
+    evictCaches(new_cfinfo->m_nbytes);
+    m_CFinfo_stats.recordBytes(new_cfinfo->m_nbytes);
 
     new_cfinfo->m_nuse = 1;
+    new_cfinfo->m_last_use = ++m_cache_clock;
     m_CFinfo_stats.recordBuild();
     m_CFinfo_stats.recordUse();
 
+    er_it = m_TheCrseFineCache.equal_range(key);
     m_TheCrseFineCache.insert(er_it.second, CFinfoCache::value_type(key,new_cfinfo));
 
     return *new_cfinfo;
@@ -2196,9 +2989,7 @@ FabArrayBase::flushCFinfo (bool no_assertion) const
     auto er_it = m_TheCrseFineCache.equal_range(m_bdkey);
     for (auto it = er_it.first; it != er_it.second; ++it)
     {
-#ifdef AMREX_MEM_PROFILING
-        m_CFinfo_stats.bytes -= it->second->bytes();
-#endif
+        m_CFinfo_stats.bytes -= it->second->m_nbytes;
         m_CFinfo_stats.recordErase(it->second->m_nuse);
         delete it->second;
     }
@@ -2213,6 +3004,20 @@ FabArrayBase::Finalize ()
     FabArrayBase::flushRB90Cache();
     FabArrayBase::flushRB180Cache();
     FabArrayBase::flushPolarBCache();
+#ifdef AMREX_USE_MPI
+    // All persistent requests are owned by the caches and have been freed.
+    if (persistent_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&persistent_comm);
+        persistent_comm = MPI_COMM_NULL;
+    }
+    persistent_tag = -1;
+    // The FabArrays in node shared memory have been destroyed.
+    if (node_shared_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&node_shared_comm);
+        node_shared_comm = MPI_COMM_NULL;
+    }
+    node_shared_rank.clear();
+#endif
     FabArrayBase::flushTileArrayCache();
 
 #ifdef AMREX_USE_GPU
@@ -2226,6 +3031,9 @@ FabArrayBase::Finalize ()
         m_CPC_stats.print();
         m_FPinfo_stats.print();
         m_CFinfo_stats.print();
+#ifdef AMREX_USE_GPU
+        m_ParFor_stats.print();
+#endif
     }
 
     if (amrex::system::verbose > 1) {
@@ -2238,6 +3046,22 @@ FabArrayBase::Finalize ()
     m_CPC_stats = CacheStats("CopyCache");
     m_FPinfo_stats = CacheStats("FillPatchCache");
     m_CFinfo_stats = CacheStats("CrseFineCache");
+#ifdef AMREX_USE_GPU
+    m_ParFor_stats = CacheStats("ParForCache");
+#endif
+    m_cache_clock = 0;
+    cache_budget_warned = false;
+
+    m_FB_compress_stats = CommCompressStats("FillBoundary");
+    m_PC_compress_stats = CommCompressStats("ParallelCopy");
+
+#ifndef AMREX_TINY_PROFILING
+    if (comm_stats) {
+        printCommStats(ParallelDescriptor::IOProcessor() ? &amrex::OutStream() : nullptr);
+    }
+#endif
+    comm_stats_map.clear();
+    comm_stats_op = -1;
 
     m_BD_count.clear();
 
@@ -2246,6 +3070,475 @@ FabArrayBase::Finalize ()
     initialized = false;
 }
 
+Long
+FabArrayBase::cacheBytes ()
+{
+    Long r = m_FBC_stats.bytes + m_CPC_stats.bytes + m_FPinfo_stats.bytes
+        +    m_CFinfo_stats.bytes;
+#ifdef AMREX_USE_GPU
+    r += m_ParFor_stats.bytes;
+#endif
+    return r;
+}
+
+void
+FabArrayBase::evictCaches (Long nbytes, bool warn)
+{
+    if (cache_max_bytes <= 0) { return; }
+
+    Long total = cacheBytes() + nbytes;
+    if (total <= cache_max_bytes) { return; }
+
+    BL_PROFILE("FabArrayBase::evictCaches()");
+
+    // Entries that can be evicted, with the function that does it.  Entries
+    // owning a communication plan are kept because rebuilding a plan must be
+    // done on all processes at the same time, whereas eviction is local.
+    struct Victim {
+        Long last_use;
+        Long nbytes;
+        std::function<void()> evict;
+    };
+    Vector<Victim> victims;
+
+    auto is_free = [] (CacheEntry const& e, CommMetaData const* cmd)
+    {
+        amrex::ignore_unused(cmd);
+#ifdef AMREX_USE_MPI
+        if (cmd && cmd->m_plan) { return false; }
+#endif
+        return e.m_npin == 0;
+    };
+
+    // Erase the map entries under the given keys pointing to p.
+    auto erase_from = [] (auto& cache, auto p, std::initializer_list<BDKey> keys)
+    {
+        for (auto const& key : keys) {
+            auto er_it = cache.equal_range(key);
+            for (auto it = er_it.first; it != er_it.second; ) {
+                if (it->second == p) {
+                    it = cache.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    };
+
+    for (auto const& kv : m_TheFBCache) {
+        FB* p = kv.second;
+        if (is_free(*p, p)) {
+            BDKey key = kv.first;
+            victims.push_back({p->m_last_use, p->m_nbytes, [=] () {
+                erase_from(m_TheFBCache, p, {key});
+                m_FBC_stats.bytes -= p->m_nbytes;
+                m_FBC_stats.recordEvict(p->m_nuse);
+                delete p;
+            }});
+        }
+    }
+
+    for (auto const& kv : m_TheCPCache) {
+        CPC* p = kv.second;
+        if (kv.first == p->m_srcbdk && is_free(*p, p)) {
+            victims.push_back({p->m_last_use, p->m_nbytes, [=] () {
+                erase_from(m_TheCPCache, p, {p->m_srcbdk, p->m_dstbdk});
+                m_CPC_stats.bytes -= p->m_nbytes;
+                m_CPC_stats.recordEvict(p->m_nuse);
+                delete p;
+            }});
+        }
+    }
+
+    for (auto const& kv : m_TheFillPatchCache) {
+        FPinfo* p = kv.second;
+        if (kv.first == p->m_srcbdk && is_free(*p, nullptr)) {
+            victims.push_back({p->m_last_use, p->m_nbytes, [=] () {
+                erase_from(m_TheFillPatchCache, p, {p->m_srcbdk, p->m_dstbdk});
+                m_FPinfo_stats.bytes -= p->m_nbytes;
+                m_FPinfo_stats.recordEvict(p->m_nuse);
+                delete p;
+            }});
+        }
+    }
+
+    for (auto const& kv : m_TheCrseFineCache) {
+        CFinfo* p = kv.second;
+        if (is_free(*p, nullptr)) {
+            BDKey key = kv.first;
+            victims.push_back({p->m_last_use, p->m_nbytes, [=] () {
+                erase_from(m_TheCrseFineCache, p, {key});
+                m_CFinfo_stats.bytes -= p->m_nbytes;
+                m_CFinfo_stats.recordEvict(p->m_nuse);
+                delete p;
+            }});
+        }
+    }
+
+#ifdef AMREX_USE_GPU
+    for (auto const& kv : m_TheParForCache) {
+        ParForInfo* p = kv.second;
+        if (is_free(*p, nullptr)) {
+            BDKey key = kv.first;
+            victims.push_back({p->m_last_use, p->m_nbytes, [=] () {
+                erase_from(m_TheParForCache, p, {key});
+                m_ParFor_stats.bytes -= p->m_nbytes;
+                m_ParFor_stats.recordEvict(0);
+                delete p;
+            }});
+        }
+    }
+#endif
+
+    std::sort(victims.begin(), victims.end(),
+              [] (Victim const& a, Victim const& b) { return a.last_use < b.last_use; });
+
+    for (auto const& v : victims) {
+        if (total <= cache_max_bytes) { break; }
+        total -= v.nbytes;
+        v.evict();
+    }
+
+    if (warn && total > cache_max_bytes && !cache_budget_warned) {
+        cache_budget_warned = true;
+        amrex::Warning("FabArrayBase: the caches exceed fabarray.cache_max_bytes, because the "
+                       "entries left are in use or own communication plans, which only "
+                       "FabArrayBase::trimCaches evicts");
+    }
+}
+
+void
+FabArrayBase::trimCaches ()
+{
+    if (cache_max_bytes <= 0) { return; }
+
+#ifdef AMREX_USE_MPI
+    evictCaches(0, false);
+
+    bool over_budget = cacheBytes() > cache_max_bytes;
+    ParallelDescriptor::ReduceBoolOr(over_budget);
+    if (!over_budget) { return; }
+
+    BL_PROFILE("FabArrayBase::trimCaches()");
+
+    // Whether a plan exists and is in use is the same on all processes,
+    // so they all free the same plans.
+    auto free_plan = [] (CommMetaData const* p)
+    {
+        if (p->m_plan && !p->m_plan->m_active) { p->m_plan.reset(); }
+    };
+
+    graph_comm_defer_free = true;
+    for (auto const& kv : m_TheFBCache) {
+        free_plan(kv.second);
+    }
+    for (auto const& kv : m_TheCPCache) {
+        if (kv.first == kv.second->m_srcbdk) { free_plan(kv.second); }
+    }
+    graph_comm_defer_free = false;
+    free_released_graph_comms();
+#endif
+
+    evictCaches(0);
+}
+
+void
+FabArrayBase::printCacheStats (std::ostream* os)
+{
+    if (cache_max_bytes <= 0) { return; }
+
+    Vector<CacheStats const*> stats{&m_FBC_stats, &m_CPC_stats, &m_FPinfo_stats,
+                                    &m_CFinfo_stats};
+#ifdef AMREX_USE_GPU
+    stats.push_back(&m_ParFor_stats);
+#endif
+
+    const int N = static_cast<int>(stats.size());
+    Vector<Long> sums, maxs;
+    for (auto const* p : stats) {
+        sums.push_back(p->nhit());
+        sums.push_back(p->nmiss());
+        sums.push_back(p->nevict);
+        maxs.push_back(p->bytes);
+        maxs.push_back(p->bytes_hwm);
+    }
+
+    const int ioproc = ParallelDescriptor::IOProcessorNumber();
+    ParallelReduce::Sum(sums.data(), static_cast<int>(sums.size()), ioproc,
+                        ParallelDescriptor::Communicator());
+    ParallelReduce::Max(maxs.data(), static_cast<int>(maxs.size()), ioproc,
+                        ParallelDescriptor::Communicator());
+
+    if (os && ParallelDescriptor::IOProcessor()) {
+        const int wn = 16;
+        const int wc = 14;
+        *os << "\nFabArrayBase caches (hits, misses and evictions summed over processes,"
+            << " bytes max over processes)\n";
+        if (cache_max_bytes > 0) {
+            *os << "Per-process budget (fabarray.cache_max_bytes): " << cache_max_bytes << "\n";
+        }
+        *os << std::setfill('-') << std::setw(wn+5*wc) << "" << std::setfill(' ') << "\n"
+            << std::left << std::setw(wn) << "Name" << std::right
+            << std::setw(wc) << "Hits" << std::setw(wc) << "Misses"
+            << std::setw(wc) << "Evictions" << std::setw(wc) << "Bytes"
+            << std::setw(wc) << "Max Bytes" << "\n"
+            << std::setfill('-') << std::setw(wn+5*wc) << "" << std::setfill(' ') << "\n";
+        for (int i = 0; i < N; ++i) {
+            *os << std::left << std::setw(wn) << stats[i]->name << std::right
+                << std::setw(wc) << sums[3*i] << std::setw(wc) << sums[3*i+1]
+                << std::setw(wc) << sums[3*i+2] << std::setw(wc) << maxs[2*i]
+                << std::setw(wc) << maxs[2*i+1] << "\n";
+        }
+        *os << std::setfill('-') << std::setw(wn+5*wc) << "" << std::setfill(' ') << "\n";
+    }
+}
+
+void
+FabArrayBase::printCommCompressStats (std::ostream* os)
+{
+    Vector<CommCompressStats const*> stats{&m_FB_compress_stats, &m_PC_compress_stats};
+    const int N = static_cast<int>(stats.size());
+
+    Vector<Long> sums;
+    Vector<double> tsums, maxs;
+    for (auto const* p : stats) {
+        sums.push_back(p->nexchanges);
+        sums.push_back(p->nmsgs);
+        sums.push_back(p->ncompressed);
+        sums.push_back(p->raw_bytes);
+        sums.push_back(p->sent_bytes);
+        tsums.push_back(p->compress_time + p->decompress_time);
+        maxs.push_back(p->compress_time);
+        maxs.push_back(p->decompress_time);
+    }
+
+    const int ioproc = ParallelDescriptor::IOProcessorNumber();
+    ParallelReduce::Sum(sums.data(), static_cast<int>(sums.size()), ioproc,
+                        ParallelDescriptor::Communicator());
+    ParallelReduce::Sum(tsums.data(), static_cast<int>(tsums.size()), ioproc,
+                        ParallelDescriptor::Communicator());
+    ParallelReduce::Max(maxs.data(), static_cast<int>(maxs.size()), ioproc,
+                        ParallelDescriptor::Communicator());
+
+    Long nmsgs = 0;
+    for (int i = 0; i < N; ++i) { nmsgs += sums[5*i+1]; }
+
+    if (os && ParallelDescriptor::IOProcessor() && nmsgs > 0) {
+        const int wn = 16;
+        const int wc = 14;
+        *os << "\nFabArrayBase message compression (counts and bytes summed over processes,"
+            << " times max over processes)\n"
+            << "Threshold (fabarray.comm_compress_threshold): " << comm_compress_threshold << "\n"
+            << std::setfill('-') << std::setw(wn+7*wc) << "" << std::setfill(' ') << "\n"
+            << std::left << std::setw(wn) << "Name" << std::right
+            << std::setw(wc) << "Exchanges" << std::setw(wc) << "Messages"
+            << std::setw(wc) << "Compressed" << std::setw(wc) << "Raw Bytes"
+            << std::setw(wc) << "Sent Bytes" << std::setw(wc) << "Compr. Time"
+            << std::setw(wc) << "Decompr. Time" << "\n"
+            << std::setfill('-') << std::setw(wn+7*wc) << "" << std::setfill(' ') << "\n";
+        for (int i = 0; i < N; ++i) {
+            *os << std::left << std::setw(wn) << stats[i]->name << std::right
+                << std::setw(wc) << sums[5*i] << std::setw(wc) << sums[5*i+1]
+                << std::setw(wc) << sums[5*i+2] << std::setw(wc) << sums[5*i+3]
+                << std::setw(wc) << sums[5*i+4] << std::setw(wc) << maxs[2*i]
+                << std::setw(wc) << maxs[2*i+1] << "\n";
+        }
+        *os << std::setfill('-') << std::setw(wn+7*wc) << "" << std::setfill(' ') << "\n";
+        for (int i = 0; i < N; ++i) {
+            if (sums[5*i] > 0) {
+                *os << stats[i]->name << ": compression ratio "
+                    << (sums[5*i+4] > 0 ? double(sums[5*i+3])/double(sums[5*i+4]) : 1.0)
+                    << ", average time per exchange per process "
+                    << tsums[i]/double(sums[5*i]) << "\n";
+            }
+        }
+    }
+}
+
+int
+FabArrayBase::CommStats::bin (std::size_t nbytes) noexcept
+{
+    int b = 0;
+    for (std::size_t limit = 1024; b < nbins-1 && nbytes >= limit; limit *= 8) { ++b; }
+    return b;
+}
+
+void
+FabArrayBase::CommStats::recordMsgs (Vector<std::size_t> const& send_size) noexcept
+{
+    for (auto nbytes : send_size) {
+        if (nbytes > 0) {
+            ++nmsgs;
+            msg_bytes += static_cast<Long>(nbytes);
+            ++msg_hist[bin(nbytes)];
+        }
+    }
+}
+
+void
+FabArrayBase::CommStats::recordLocal (CopyComTagsContainer const& tags, int ncomp,
+                                      std::size_t sizeof_value) noexcept
+{
+    Long npts = 0;
+    for (auto const& tag : tags) {
+        npts += tag.dbox.numPts();
+    }
+    local_bytes += npts * ncomp * static_cast<Long>(sizeof_value);
+}
+
+FabArrayBase::CommStatsTimer::CommStatsTimer (double* t) noexcept
+    : m_t(t)
+{
+    if (m_t) { m_t0 = amrex::second(); }
+}
+
+FabArrayBase::CommStatsTimer::~CommStatsTimer ()
+{
+    if (m_t) { *m_t += amrex::second() - m_t0; }
+}
+
+FabArrayBase::CommStatsScope::CommStatsScope (CommOp op) noexcept
+    : m_prev(comm_stats_op)
+{
+    comm_stats_op = static_cast<int>(op);
+}
+
+FabArrayBase::CommStatsScope::~CommStatsScope ()
+{
+    comm_stats_op = m_prev;
+}
+
+FabArrayBase::CommStats*
+FabArrayBase::recordCommStats (CommOp op)
+{
+    if (!comm_stats) { return nullptr; }
+    if (comm_stats_op >= 0) { op = static_cast<CommOp>(comm_stats_op); }
+#ifdef AMREX_TINY_PROFILING
+    std::string const& region = TinyProfiler::CurrentRegion();
+#else
+    static const std::string region("main");
+#endif
+    auto& st = comm_stats_map[std::make_pair(static_cast<int>(op), region)];
+    ++st.ncalls;
+    return &st;
+}
+
+void
+FabArrayBase::printCommStats (std::ostream* os)
+{
+    if (!comm_stats) { return; }
+
+    const char* opname[] = {"FillBoundary", "ParallelCopy", "SumBoundary"};
+
+    // The records must be in the same order on all processes.
+    Vector<std::string> local_names, names;
+    std::map<std::string,CommStats const*> local_stats;
+    for (auto const& kv : comm_stats_map) {
+        local_names.push_back(std::string(opname[kv.first.first]) + "|" + kv.first.second);
+        local_stats[local_names.back()] = &(kv.second);
+    }
+    bool synced;
+    amrex::SyncStrings(local_names, names, synced);
+    std::sort(names.begin(), names.end());
+    const int N = static_cast<int>(names.size());
+    if (N == 0) { return; }
+
+    constexpr int nl = 4 + CommStats::nbins;
+    constexpr int nt = 4;
+    Vector<Long> lsums(N*nl, 0);
+    Vector<Long> lmaxs(N, 0);
+    Vector<double> tsums(N*nt, 0.0);
+    Vector<double> tmaxs(N*nt, 0.0);
+    for (int i = 0; i < N; ++i) {
+        auto it = local_stats.find(names[i]);
+        if (it != local_stats.end()) {
+            CommStats const& st = *(it->second);
+            Long* l = lsums.data() + i*nl;
+            l[0] = st.ncalls;
+            l[1] = st.nmsgs;
+            l[2] = st.msg_bytes;
+            l[3] = st.local_bytes;
+            for (int b = 0; b < CommStats::nbins; ++b) { l[4+b] = st.msg_hist[b]; }
+            lmaxs[i] = st.ncalls;
+            const double t[nt] = {st.pack_time, st.unpack_time, st.local_time, st.wait_time};
+            for (int k = 0; k < nt; ++k) {
+                tsums[i*nt+k] = t[k];
+                tmaxs[i*nt+k] = t[k];
+            }
+        }
+    }
+
+    const int ioproc = ParallelDescriptor::IOProcessorNumber();
+    MPI_Comm comm = ParallelDescriptor::Communicator();
+    ParallelReduce::Sum(lsums.data(), static_cast<int>(lsums.size()), ioproc, comm);
+    ParallelReduce::Max(lmaxs.data(), static_cast<int>(lmaxs.size()), ioproc, comm);
+    ParallelReduce::Sum(tsums.data(), static_cast<int>(tsums.size()), ioproc, comm);
+    ParallelReduce::Max(tmaxs.data(), static_cast<int>(tmaxs.size()), ioproc, comm);
+
+    if (os && ParallelDescriptor::IOProcessor()) {
+        const double nprocs = ParallelDescriptor::NProcs();
+        const int wn = 16;
+        const int wr = 20;
+        const int wc = 14;
+        IOFormatSaver iofmtsaver(*os);
+        auto line = [&] (int w) { *os << std::setfill('-') << std::setw(w) << "" << std::setfill(' ') << "\n"; };
+        auto name = [&] (int i) {
+            auto pos = names[i].find('|');
+            *os << std::left << std::setw(wn) << names[i].substr(0,pos)
+                << std::setw(wr) << names[i].substr(pos+1) << std::right;
+        };
+
+        *os << "\nFabArrayBase communication statistics (calls max over processes,"
+            << " counts and bytes summed over processes)\n";
+        line(wn+wr+4*wc);
+        *os << std::left << std::setw(wn) << "Name" << std::setw(wr) << "Region" << std::right
+            << std::setw(wc) << "Calls" << std::setw(wc) << "Messages"
+            << std::setw(wc) << "Msg Bytes" << std::setw(wc) << "Local Bytes" << "\n";
+        line(wn+wr+4*wc);
+        for (int i = 0; i < N; ++i) {
+            name(i);
+            *os << std::setw(wc) << lmaxs[i] << std::setw(wc) << lsums[i*nl+1]
+                << std::setw(wc) << lsums[i*nl+2] << std::setw(wc) << lsums[i*nl+3] << "\n";
+        }
+        line(wn+wr+4*wc);
+
+        const char* binname[CommStats::nbins] = {"< 1K", "< 8K", "< 64K", "< 512K",
+                                                  "< 4M", "< 32M", ">= 32M"};
+        const int wb = 9;
+        *os << "\nMessage sizes (# of messages in bytes)\n";
+        line(wn+wr+CommStats::nbins*wb);
+        *os << std::left << std::setw(wn) << "Name" << std::setw(wr) << "Region" << std::right;
+        for (auto const* b : binname) { *os << std::setw(wb) << b; }
+        *os << "\n";
+        line(wn+wr+CommStats::nbins*wb);
+        for (int i = 0; i < N; ++i) {
+            name(i);
+            for (int b = 0; b < CommStats::nbins; ++b) { *os << std::setw(wb) << lsums[i*nl+4+b]; }
+            *os << "\n";
+        }
+        line(wn+wr+CommStats::nbins*wb);
+
+        const int wt = 11;
+        *os << "\nCommunication time per process in seconds [avg max]\n";
+        line(wn+wr+2*nt*wt);
+        *os << std::left << std::setw(wn) << "Name" << std::setw(wr) << "Region" << std::right;
+        for (auto const* t : {"Pack", "Unpack", "Local", "Wait"}) {
+            *os << std::setw(wt) << std::string(t)+" avg" << std::setw(wt) << std::string(t)+" max";
+        }
+        *os << "\n";
+        line(wn+wr+2*nt*wt);
+        os->precision(4);
+        for (int i = 0; i < N; ++i) {
+            name(i);
+            for (int k = 0; k < nt; ++k) {
+                *os << std::setw(wt) << tsums[i*nt+k]/nprocs << std::setw(wt) << tmaxs[i*nt+k];
+            }
+            *os << "\n";
+        }
+        line(wn+wr+2*nt*wt);
+    }
+}
+
 const FabArrayBase::TileArray*
 FabArrayBase::getTileArray (const IntVect& tilesize) const
 {
@@ -2281,6 +3574,27 @@ FabArrayBase::getTileArray (const IntVect& tilesize) const
     return p;
 }
 
+Vector<int>
+FabArrayBase::staticOwnerThreads (int nthreads) const
+{
+    Vector<int> r(indexArray.size(), 0);
+    if (nthreads <= 1) { return r; }
+
+    // This must be consistent with the static schedule in MFIter::Initialize.
+    const TileArray* ta = getTileArray(FabArrayBase::mfiter_tile_size);
+    const int ntot = static_cast<int>(ta->indexMap.size());
+    const int nr   = ntot / nthreads;
+    const int nlft = ntot - nr * nthreads;
+    auto thread_of_tile = [=] (int t) {
+        return (t < nlft*(nr+1)) ? t/(nr+1) : nlft + (t-nlft*(nr+1))/nr;
+    };
+
+    for (int t = 0; t < ntot; t += ta->numLocalTiles[t]) {
+        r[ta->localIndexMap[t]] = thread_of_tile(t + ta->numLocalTiles[t]/2);
+    }
+    return r;
+}
+
 void
 FabArrayBase::buildTileArray (const IntVect& tileSize, TileArray& ta) const
 {
@@ -2502,7 +3816,9 @@ CheckRcvStats (Vector<MPI_Status>& recv_stats, const Vector<std::size_t>& recv_s
                               &tmp_count);
                 count = sizeof(ParallelDescriptor::lull_t) * tmp_count;
             } else {
-                amrex::Abort("TODO: message size is too big");
+                amrex::Abort("CheckRcvStats: a message of " + std::to_string(recv_size[i])
+                             + " bytes from Proc. " + std::to_string(recv_stats[i].MPI_SOURCE)
+                             + " is too big for MPI");
             }
 
             if (count != recv_size[i]) {
@@ -2655,6 +3971,9 @@ FabArrayBase::ParForInfo::ParForInfo (const FabArrayBase& fa, const IntVect& ngh
         ncells.push_back(N);
     }
     detail::build_par_for_nblocks(m_hp, m_dp, m_nblocks_x, m_boxes, boxes, ncells, nthreads);
+    // The same data are in pinned and device memory.
+    m_nbytes = static_cast<Long>(sizeof(ParForInfo))
+        + 2 * static_cast<Long>(boxes.size() * (sizeof(int) + sizeof(BoxIndexer)));
 }
 
 FabArrayBase::ParForInfo::~ParForInfo ()
@@ -2672,11 +3991,22 @@ FabArrayBase::getParForInfo (const IntVect& nghost, int nthreads) const
             it->second->m_ng         == nghost                 &&
             it->second->m_nthreads   == nthreads)
         {
+            it->second->m_last_use = ++m_cache_clock;
+            m_ParFor_stats.recordUse();
             return *(it->second);
         }
     }
 
     ParForInfo* new_pfi = new ParForInfo(*this, nghost, nthreads);
+
+    evictCaches(new_pfi->m_nbytes);
+    m_ParFor_stats.recordBytes(new_pfi->m_nbytes);
+
+    new_pfi->m_last_use = ++m_cache_clock;
+    m_ParFor_stats.recordBuild();
+    m_ParFor_stats.recordUse();
+
+    er_it = m_TheParForCache.equal_range(m_bdkey);
     m_TheParForCache.insert(er_it.second,
                             std::multimap<BDKey,ParForInfo*>::value_type(m_bdkey,new_pfi));
     return *new_pfi;
@@ -2689,6 +4019,8 @@ FabArrayBase::flushParForInfo (bool no_assertion) const
     AMREX_ASSERT(no_assertion || getBDKey() == m_bdkey);
     auto er_it = m_TheParForCache.equal_range(m_bdkey);
     for (auto it = er_it.first; it != er_it.second; ++it) {
+        m_ParFor_stats.bytes -= it->second->m_nbytes;
+        m_ParFor_stats.recordErase(0);
         delete it->second;
     }
     m_TheParForCache.erase(er_it.first, er_it.second);
@@ -2698,9 +4030,11 @@ void
 FabArrayBase::flushParForCache ()
 {
     for (auto it = m_TheParForCache.begin(); it != m_TheParForCache.end(); ++it) {
+        m_ParFor_stats.recordErase(0);
         delete it->second;
     }
     m_TheParForCache.clear();
+    m_ParFor_stats.bytes = 0L;
 }
 
 #endif
@@ -2751,6 +4085,58 @@ namespace detail {
     bool SingleChunkArena::isPinned () const {
         return m_dallocator.arena()->isPinned();
     }
+
+#ifdef AMREX_USE_MPI
+    NodeSharedArena::NodeSharedArena (std::size_t a_size)
+        : m_size(a_size)
+    {
+        MPI_Comm comm = FabArrayBase::nodeSharedCommunicator();
+        MPI_Info info;
+        BL_MPI_REQUIRE( MPI_Info_create(&info) );
+        BL_MPI_REQUIRE( MPI_Info_set(info, "alloc_shared_noncontig", "true") );
+        BL_MPI_REQUIRE( MPI_Win_allocate_shared(static_cast<MPI_Aint>(a_size), 1, info, comm,
+                                                &m_root, &m_win) );
+        BL_MPI_REQUIRE( MPI_Info_free(&info) );
+        m_free = m_root;
+
+        int nranks;
+        BL_MPI_REQUIRE( MPI_Comm_size(comm, &nranks) );
+        m_bases.resize(nranks);
+        for (int r = 0; r < nranks; ++r) {
+            MPI_Aint sz;
+            int disp_unit;
+            BL_MPI_REQUIRE( MPI_Win_shared_query(m_win, r, &sz, &disp_unit, &m_bases[r]) );
+        }
+    }
+
+    NodeSharedArena::~NodeSharedArena ()
+    {
+        if (m_win != MPI_WIN_NULL) {
+            MPI_Win_free(&m_win);
+        }
+    }
+
+    void* NodeSharedArena::alloc (std::size_t sz)
+    {
+        amrex::ignore_unused(m_size);
+        auto* p = (void*)m_free;
+        AMREX_ASSERT(sz <= m_size && ((m_free-m_root)+sz <= m_size));
+        m_free += sz;
+        return p;
+    }
+
+    void NodeSharedArena::free (void* /*pt*/) {}
+
+    bool NodeSharedArena::isDeviceAccessible () const { return false; }
+
+    bool NodeSharedArena::isHostAccessible () const { return true; }
+
+    bool NodeSharedArena::isManaged () const { return false; }
+
+    bool NodeSharedArena::isDevice () const { return false; }
+
+    bool NodeSharedArena::isPinned () const { return false; }
+#endif
 }
 
 int nComp (FabArrayBase const& fa)
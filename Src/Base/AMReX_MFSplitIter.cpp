@@ -0,0 +1,86 @@
+#include <AMReX_MFSplitIter.H>
+
+#ifdef AMREX_USE_OMP
+#include <omp.h>
+#endif
+
+namespace amrex {
+
+void
+MFSplitIter::beginInterior ()
+{
+    if (m_sta) {
+        setTiles(m_sta->m_interior);
+    }
+
+#ifdef AMREX_USE_OMP
+    // No thread may finish FillBoundary before all have seen it in progress.
+#pragma omp barrier
+#endif
+
+    if (m_sta && currentIndex >= endIndex) {
+        beginBoundary();
+    }
+}
+
+void
+MFSplitIter::setTiles (const FabArrayBase::TileArray& ta)
+{
+    index_map            = &(ta.indexMap);
+    local_index_map      = &(ta.localIndexMap);
+    tile_array           = &(ta.tileArray);
+    local_tile_index_map = &(ta.localTileIndexMap);
+    num_local_tiles      = &(ta.numLocalTiles);
+
+    beginIndex = 0;
+    endIndex = static_cast<int>(index_map->size());
+
+#ifdef AMREX_USE_OMP
+    int nthreads = omp_get_num_threads();
+    if (nthreads > 1)
+    {
+        int tid = omp_get_thread_num();
+        int ntot = endIndex;
+        int nr   = ntot / nthreads;
+        int nlft = ntot - nr * nthreads;
+        if (tid < nlft) {  // get nr+1 items
+            beginIndex = tid * (nr + 1);
+            endIndex = beginIndex + nr + 1;
+        } else {           // get nr items
+            beginIndex = tid * nr + nlft;
+            endIndex = beginIndex + nr;
+        }
+    }
+#endif
+
+    currentIndex = beginIndex;
+
+#ifdef AMREX_USE_GPU
+    Gpu::Device::setStreamIndex(currentIndex%streams);
+#endif
+}
+
+void
+MFSplitIter::beginBoundary ()
+{
+#ifdef AMREX_USE_OMP
+#pragma omp barrier
+#pragma omp single
+#endif
+    m_finish();
+
+    m_interior = false;
+    setTiles(m_sta->m_boundary);
+}
+
+void
+MFSplitIter::operator++ () noexcept
+{
+    MFIter::operator++();
+
+    if (m_interior && m_sta && currentIndex >= endIndex) {
+        beginBoundary();
+    }
+}
+
+}
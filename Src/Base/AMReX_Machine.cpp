@@ -2,12 +2,22 @@
 
 #ifndef AMREX_USE_MPI
 
+#include <AMReX_Machine.H>
+
 namespace amrex::machine {
     void Initialize () {}
+
+    const Vector<int>& node_of_rank () {
+        static const Vector<int> r{0};
+        return r;
+    }
+
+    bool has_node_of_rank () { return true; }
 }
 
 #else
 
+#include <AMReX_DistributionMapping.H>
 #include <AMReX_Print.H>
 #include <AMReX_ParmParse.H>
 #include <AMReX_ParallelReduce.H>
@@ -216,8 +226,26 @@ class Machine
         get_params();
         get_machine_envs();
         node_ids = get_node_ids();
+        // the GRAPH strategy is the only user of the shared memory nodes,
+        // and it does not need them if the node size is given
+        int node_size = 0;
+        ParmParse("DistributionMapping").query("node_size", node_size);
+        if (DistributionMapping::strategy() == DistributionMapping::GRAPH && node_size <= 0) {
+            shared_node_ids = get_shared_node_ids();
+        }
     }
 
+    // node of every rank in the job indexed by global rank
+    // the first call is collective over ALL ranks in the job if it was not done in Initialize
+    const Vector<int>& node_of_rank () {
+        if (shared_node_ids.empty()) {
+            shared_node_ids = get_shared_node_ids();
+        }
+        return shared_node_ids;
+    }
+
+    [[nodiscard]] bool has_node_of_rank () const { return !shared_node_ids.empty(); }
+
     // find a compact neighborhood of size rank_n in the current ParallelContext subgroup
     Vector<int> find_best_nbh (int nbh_rank_n, bool flag_local_ranks)
     {
@@ -322,6 +350,7 @@ class Machine
     bool flag_nersc_df;
     // int my_node_id;
     Vector<int> node_ids;
+    Vector<int> shared_node_ids;
 
     NeighborhoodCache nbh_cache;
 
@@ -431,6 +460,46 @@ class Machine
         return ids;
     }
 
+    // get the shared memory node of all ranks in this job, indexed by job rank,
+    // numbered contiguously in the order of the lowest rank on each node
+    // this is collective over ALL ranks in the job
+    static Vector<int> get_shared_node_ids ()
+    {
+        MPI_Comm comm = ParallelContext::CommunicatorAll();
+        int rank_n = ParallelContext::NProcsAll();
+        int leader = 0;
+        if (rank_n > 1) {
+#if defined(OPEN_MPI)
+            int split_type = OMPI_COMM_TYPE_NODE;
+#else
+            int split_type = MPI_COMM_TYPE_SHARED;
+#endif
+            MPI_Comm node_comm;
+            BL_MPI_REQUIRE(MPI_Comm_split_type(comm, split_type, 0, MPI_INFO_NULL, &node_comm));
+            // the lowest rank on the node, because the key is 0 for all
+            int rank_in_node;
+            BL_MPI_REQUIRE(MPI_Comm_rank(node_comm, &rank_in_node));
+            leader = (rank_in_node == 0) ? ParallelContext::MyProcAll() : 0;
+            BL_MPI_REQUIRE(MPI_Bcast(&leader, 1, MPI_INT, 0, node_comm));
+            BL_MPI_REQUIRE(MPI_Comm_free(&node_comm));
+        }
+        Vector<int> leaders(rank_n, 0);
+        ParallelAllGather::AllGather(leader, leaders.data(), comm);
+        std::map<int,int> leader_to_node;
+        for (auto l : leaders) {
+            leader_to_node.emplace(l, 0);
+        }
+        int inode = 0;
+        for (auto& kv : leader_to_node) {
+            kv.second = inode++;
+        }
+        Vector<int> ids(rank_n);
+        for (int i = 0; i < rank_n; ++i) {
+            ids[i] = leader_to_node[leaders[i]];
+        }
+        return ids;
+    }
+
     // do a local search starting at current node
     std::pair<Vector<int>, double>
     baseline_score(const Vector<int> & sg_node_ids, int nbh_rank_n) const
@@ -594,6 +663,15 @@ Vector<int> find_best_nbh (int rank_n, bool flag_local_ranks) {
     return the_machine->find_best_nbh(rank_n, flag_local_ranks);
 }
 
+const Vector<int>& node_of_rank () {
+    AMREX_ASSERT(the_machine);
+    return the_machine->node_of_rank();
+}
+
+bool has_node_of_rank () {
+    return the_machine && the_machine->has_node_of_rank();
+}
+
 }
 
 #endif
@@ -0,0 +1,322 @@
+
+#include <AMReX_NArena.H>
+#include <AMReX.H>
+#include <AMReX_OpenMP.H>
+#include <AMReX_ParallelReduce.H>
+#include <AMReX_Print.H>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace amrex {
+
+namespace {
+
+#ifdef __linux__
+    // From linux/mempolicy.h
+    constexpr int mpol_preferred = 1;
+
+    // Parse a list like "0-3,8-11".
+    std::vector<int> parse_list (std::string const& s)
+    {
+        std::vector<int> r;
+        std::istringstream is(s);
+        std::string range;
+        while (std::getline(is, range, ',')) {
+            if (range.empty() || range == "\n") { continue; }
+            auto dash = range.find('-');
+            int lo = std::stoi(range.substr(0,dash));
+            int hi = (dash == std::string::npos) ? lo : std::stoi(range.substr(dash+1));
+            for (int i = lo; i <= hi; ++i) { r.push_back(i); }
+        }
+        return r;
+    }
+
+    std::string read_line (std::string const& filename)
+    {
+        std::ifstream ifs(filename);
+        std::string line;
+        std::getline(ifs, line);
+        return line;
+    }
+#endif
+
+    struct Topology
+    {
+        //! The node number of each domain.
+        std::vector<int> node;
+        //! The domain of each CPU.
+        std::vector<int> cpu_domain;
+
+        Topology ()
+        {
+#ifdef __linux__
+            const std::string path("/sys/devices/system/node/");
+            std::vector<int> nodes;
+            try {
+                nodes = parse_list(read_line(path+"has_memory"));
+                if (nodes.empty()) {
+                    nodes = parse_list(read_line(path+"online"));
+                }
+                for (int inode : nodes) {
+                    auto cpus = parse_list(read_line(path+"node"+std::to_string(inode)+"/cpulist"));
+                    for (int cpu : cpus) {
+                        if (cpu >= static_cast<int>(cpu_domain.size())) {
+                            cpu_domain.resize(cpu+1, 0);
+                        }
+                        cpu_domain[cpu] = static_cast<int>(node.size());
+                    }
+                    node.push_back(inode);
+                }
+            } catch (std::exception const&) {
+                node.clear();
+                cpu_domain.clear();
+            }
+#endif
+            if (node.empty()) { node.push_back(0); }
+        }
+    };
+
+    Topology const& topology ()
+    {
+        static Topology t;
+        return t;
+    }
+}
+
+namespace NUMA {
+
+int NumDomains ()
+{
+    return static_cast<int>(topology().node.size());
+}
+
+int CurrentDomain ()
+{
+#ifdef __linux__
+    auto const& t = topology();
+    int cpu = sched_getcpu();
+    if (cpu >= 0 && cpu < static_cast<int>(t.cpu_domain.size())) {
+        return t.cpu_domain[cpu];
+    }
+#endif
+    return 0;
+}
+
+void* Allocate (std::size_t nbytes, int domain)
+{
+#ifdef __linux__
+    void* p = mmap(nullptr, nbytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        amrex::Abort("NUMA::Allocate: mmap failed");
+    }
+    Bind(p, nbytes, domain);
+    return p;
+#else
+    amrex::ignore_unused(domain);
+    void* p = std::malloc(nbytes);
+    if (p == nullptr) { amrex::Abort("Sorry, malloc failed"); }
+    return p;
+#endif
+}
+
+void Bind (void* p, std::size_t nbytes, int domain)
+{
+#ifdef __linux__
+    auto const& t = topology();
+    if (t.node.size() > 1 && domain >= 0 && domain < static_cast<int>(t.node.size())) {
+        constexpr int nbits = 8*sizeof(unsigned long);
+        const int inode = t.node[domain];
+        std::vector<unsigned long> mask(inode/nbits+1, 0UL);
+        mask[inode/nbits] = 1UL << (inode%nbits);
+        // This only fails without kernel support, and the memory is still usable.
+        syscall(SYS_mbind, p, nbytes, mpol_preferred, mask.data(), mask.size()*nbits+1, 0);
+    }
+#else
+    amrex::ignore_unused(p, nbytes, domain);
+#endif
+}
+
+void Deallocate (void* p, std::size_t nbytes)
+{
+#ifdef __linux__
+    munmap(p, nbytes);
+#else
+    amrex::ignore_unused(nbytes);
+    std::free(p);
+#endif
+}
+
+}
+
+NArena::NArena (std::size_t hunk_size, ArenaInfo info)
+{
+    arena_info = info.SetCpuMemory();
+
+    const int ndomains = NUMA::NumDomains();
+    for (int d = 0; d < ndomains; ++d) {
+        m_pools.push_back(std::make_unique<CArena>(hunk_size, ArenaInfo(info).SetNumaDomain(d)));
+    }
+
+    m_thread_domain.resize(OpenMP::get_max_threads(), 0);
+#ifdef AMREX_USE_OMP
+#pragma omp parallel
+#endif
+    {
+        m_thread_domain[OpenMP::get_thread_num()] = NUMA::CurrentDomain();
+    }
+}
+
+NArena::~NArena () = default;
+
+void
+NArena::registerForProfiling (const std::string& memory_name)
+{
+    for (auto& pool : m_pools) {
+        pool->registerForProfiling(memory_name);
+    }
+}
+
+int
+NArena::threadDomain (int tid) const noexcept
+{
+    return (tid >= 0 && tid < static_cast<int>(m_thread_domain.size()))
+        ? m_thread_domain[tid] : 0;
+}
+
+void*
+NArena::alloc (std::size_t nbytes)
+{
+    const int tid = ThreadHint::get();
+    int d = (tid >= 0) ? threadDomain(tid) : NUMA::CurrentDomain();
+    d = std::min(d, numDomains()-1);
+    void* p = m_pools[d]->alloc(nbytes);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_domain.emplace(p, d);
+    return p;
+}
+
+void
+NArena::free (void* vp)
+{
+    if (vp == nullptr) { return; }
+    int d;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_domain.find(vp);
+        if (it == m_domain.end()) {
+            amrex::Abort("NArena::free: unknown pointer");
+            return;
+        }
+        d = it->second;
+        m_domain.erase(it);
+    }
+    m_pools[d]->free(vp);
+}
+
+void*
+NArena::relocate (void* pt)
+{
+    if (pt == nullptr) { return nullptr; }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_domain.find(pt);
+    if (it == m_domain.end()) {
+        amrex::Abort("NArena::relocate: unknown pointer");
+        return nullptr;
+    }
+    const int d = it->second;
+    void* p = m_pools[d]->relocate(pt);
+    if (p != pt) {
+        m_domain.erase(it);
+        m_domain.emplace(p, d);
+    }
+    return p;
+}
+
+std::size_t
+NArena::freeUnused ()
+{
+    std::size_t r = 0;
+    for (auto& pool : m_pools) {
+        r += pool->freeUnused();
+    }
+    return r;
+}
+
+std::size_t
+NArena::heap_space_used (int domain) const noexcept
+{
+    return m_pools[domain]->heap_space_used();
+}
+
+std::size_t
+NArena::heap_space_actually_used (int domain) const noexcept
+{
+    return m_pools[domain]->heap_space_actually_used();
+}
+
+Arena::HugePageUsage
+NArena::hugePageUsage () const
+{
+    HugePageUsage r;
+    for (auto const& pool : m_pools) {
+        auto usage = pool->hugePageUsage();
+        r.hugetlb_bytes += usage.hugetlb_bytes;
+        r.transparent_bytes += usage.transparent_bytes;
+        r.regular_bytes += usage.regular_bytes;
+    }
+    return r;
+}
+
+void
+NArena::PrintUsage (std::string const& name) const
+{
+    // The number of domains may differ between nodes.
+    int ndomains = numDomains();
+    ParallelDescriptor::ReduceIntMax(ndomains);
+    Vector<Long> min_megabytes(2*ndomains, 0);
+    for (int d = 0; d < numDomains(); ++d) {
+        min_megabytes[2*d  ] = static_cast<Long>(heap_space_used(d) / (1024*1024));
+        min_megabytes[2*d+1] = static_cast<Long>(heap_space_actually_used(d) / (1024*1024));
+    }
+    Vector<Long> max_megabytes = min_megabytes;
+    const int IOProc = ParallelDescriptor::IOProcessorNumber();
+    ParallelReduce::Min<Long>(min_megabytes.data(), 2*ndomains, IOProc,
+                              ParallelDescriptor::Communicator());
+    ParallelReduce::Max<Long>(max_megabytes.data(), 2*ndomains, IOProc,
+                              ParallelDescriptor::Communicator());
+    for (int d = 0; d < ndomains; ++d) {
+        std::string dname = name + "] [domain " + std::to_string(d);
+#ifdef AMREX_USE_MPI
+        amrex::Print() << "[" << dname << "] space (MB) allocated spread across MPI: ["
+                       << min_megabytes[2*d] << " ... " << max_megabytes[2*d] << "]\n"
+                       << "[" << dname << "] space (MB) used      spread across MPI: ["
+                       << min_megabytes[2*d+1] << " ... " << max_megabytes[2*d+1] << "]\n";
+#else
+        amrex::Print() << "[" << dname << "] space allocated (MB): " << min_megabytes[2*d] << "\n"
+                       << "[" << dname << "] space used      (MB): " << min_megabytes[2*d+1] << "\n";
+#endif
+    }
+    if (arena_info.use_huge_pages) {
+        PrintHugePageUsage(name);
+    }
+}
+
+void
+NArena::PrintUsage (std::ostream& os, std::string const& name, std::string const& space) const
+{
+    for (int d = 0; d < numDomains(); ++d) {
+        m_pools[d]->PrintUsage(os, name + "] [domain " + std::to_string(d), space);
+    }
+}
+
+}
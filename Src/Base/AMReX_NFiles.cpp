@@ -1,14 +1,76 @@
 
 #include <AMReX_NFiles.H>
+#include <AMReX_FabArrayBase.H>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <deque>
+#include <functional>
+#include <memory>
 #include <set>
 #include <utility>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace amrex {
 
 int NFilesIter::currentDeciderIndex(-1);
 int NFilesIter::minDigits(5);
 
+namespace {
+#ifdef BL_USE_MPI
+  MPI_Comm aggregatorComm(MPI_COMM_NULL);
+  int aggregatorCommNAggregators(0);
+  int aggregatorIndex(0);
+
+  // ---- the communicator of the group of ranks sharing an aggregator
+  MPI_Comm AggregatorCommunicator(int naggregators)
+  {
+    if(aggregatorComm != MPI_COMM_NULL && aggregatorCommNAggregators == naggregators) {
+      return aggregatorComm;
+    }
+    if(aggregatorComm == MPI_COMM_NULL) {
+      amrex::ExecOnFinalize([] () {
+        if(aggregatorComm != MPI_COMM_NULL) {
+          MPI_Comm_free(&aggregatorComm);
+        }
+        aggregatorCommNAggregators = 0;
+        aggregatorIndex = 0;
+      });
+    } else {
+      MPI_Comm_free(&aggregatorComm);
+    }
+
+    // ---- the node communicator of the node shared FabArrays is split,
+    // ---- so that no other node communicator is created and freed
+    MPI_Comm nodeComm(FabArrayBase::nodeSharedCommunicator());
+    int nodeRank(0), nodeSize(1);
+    MPI_Comm_rank(nodeComm, &nodeRank);
+    MPI_Comm_size(nodeComm, &nodeSize);
+    const int group(static_cast<int>(static_cast<Long>(nodeRank) * naggregators / nodeSize));
+    BL_MPI_REQUIRE( MPI_Comm_split(nodeComm, group, nodeRank, &aggregatorComm) );
+    aggregatorCommNAggregators = naggregators;
+
+    // ---- number the aggregators of all nodes consecutively in rank order
+    int groupRank(0);
+    MPI_Comm_rank(aggregatorComm, &groupRank);
+    int isAggregator(groupRank == 0 ? 1 : 0);
+    aggregatorIndex = 0;
+    BL_MPI_REQUIRE( MPI_Exscan(&isAggregator, &aggregatorIndex, 1, MPI_INT, MPI_SUM,
+                               ParallelDescriptor::Communicator()) );
+    if(ParallelDescriptor::MyProc() == 0) {
+      aggregatorIndex = 0;   // ---- undefined on the first rank
+    }
+    BL_MPI_REQUIRE( MPI_Bcast(&aggregatorIndex, 1, MPI_INT, 0, aggregatorComm) );
+    return aggregatorComm;
+  }
+#endif
+}
+
 
 NFilesIter::NFilesIter(int noutfiles, std::string fileprefix,
                        bool groupsets, bool setBuf)
@@ -495,6 +557,45 @@ std::streampos NFilesIter::SeekPos() {
 }
 
 
+bool NFilesIter::WriteDirect(const char *data, Long nbytes) {
+#if defined(_WIN32) || ! defined(O_DIRECT)
+  amrex::ignore_unused(data, nbytes);
+  return false;
+#else
+  fileStream.flush();
+  int fd(::open(fullFileName.c_str(), O_WRONLY | O_DIRECT));
+  if(fd < 0) {
+    if(errno == EINVAL) {   // ---- not supported by this file system
+      return false;
+    }
+    amrex::FileOpenFailed(fullFileName);
+  }
+  struct stat st;
+  if(::fstat(fd, &st) != 0) {
+    amrex::Error("NFilesIter::WriteDirect: fstat failed for " + fullFileName);
+  }
+  Long offset(st.st_size), nwritten(0);
+  while(nwritten < nbytes) {
+    ssize_t n(::pwrite(fd, data + nwritten, static_cast<std::size_t>(nbytes - nwritten),
+                       static_cast<off_t>(offset + nwritten)));
+    if(n < 0 && errno == EINTR) {
+      continue;
+    }
+    if(n < 0 && errno == EINVAL && nwritten == 0) {   // ---- alignment not accepted
+      ::close(fd);
+      return false;
+    }
+    if(n <= 0) {
+      amrex::Error("NFilesIter::WriteDirect: write failed for " + fullFileName);
+    }
+    nwritten += n;
+  }
+  ::close(fd);
+  return true;
+#endif
+}
+
+
 bool NFilesIter::CheckNFiles(int nProcs, int nOutFiles, bool groupSets)
 {
   if(ParallelDescriptor::IOProcessor()) {
@@ -549,6 +650,107 @@ Vector<int> NFilesIter::FileNumbersWritten()
 
 
 
+std::pair<int, Long> NFilesIter::AggregatedWrite(Long nbytes,
+                                                 const std::function<void(char *, Long, Long)> &pack,
+                                                 const std::string &filePrefix,
+                                                 int naggregators,
+                                                 Long stripeSize, Long bufferSize)
+{
+  BL_PROFILE("NFilesIter::AggregatedWrite()");
+
+  stripeSize = std::max(stripeSize, Long(1));
+  // ---- a whole number of stripes that fits in an mpi message
+  bufferSize = std::min(std::max(bufferSize, stripeSize), Long(1) << 30);
+  bufferSize = std::max(bufferSize / stripeSize, Long(1)) * stripeSize;
+
+  int fileNumber(0);
+  Long myOffset(0);
+  int groupRank(0), groupSize(1);
+  Vector<Long> sizes(1, nbytes);
+
+#ifdef BL_USE_MPI
+  MPI_Comm comm(AggregatorCommunicator(std::max(naggregators, 1)));
+  MPI_Comm_rank(comm, &groupRank);
+  MPI_Comm_size(comm, &groupSize);
+  fileNumber = aggregatorIndex;
+
+  sizes.resize(groupSize);
+  BL_MPI_REQUIRE( MPI_Allgather(&nbytes, 1, ParallelDescriptor::Mpi_typemap<Long>::type(),
+                                sizes.dataPtr(), 1, ParallelDescriptor::Mpi_typemap<Long>::type(),
+                                comm) );
+  for(int r(0); r < groupRank; ++r) {
+    myOffset += sizes[r];
+  }
+  const int tag(ParallelDescriptor::SeqNum());
+
+  if(groupRank != 0) {
+    std::unique_ptr<char[]> piece(new char[std::max(std::min(bufferSize, nbytes), Long(1))]);
+    for(Long pos(0); pos < nbytes; pos += bufferSize) {
+      const Long n(std::min(bufferSize, nbytes - pos));
+      pack(piece.get(), pos, n);
+      ParallelDescriptor::Send(piece.get(), static_cast<std::size_t>(n), 0, tag, comm);
+    }
+    return {fileNumber, myOffset};
+  }
+#else
+  amrex::ignore_unused(naggregators);
+#endif
+
+  Long totalBytes(0);
+  for(Long sz : sizes) {
+    totalBytes += sz;
+  }
+  if(totalBytes == 0) {
+    return {fileNumber, myOffset};
+  }
+
+  const std::string fileName(FileName(fileNumber, filePrefix));
+  std::ofstream ofs;
+  ofs.rdbuf()->pubsetbuf(nullptr, 0);
+  ofs.open(fileName.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+  if( ! ofs.good()) {
+    amrex::FileOpenFailed(fileName);
+  }
+
+  // ---- only whole stripes are written until the end
+  const Long capacity(bufferSize + stripeSize);
+  std::unique_ptr<char[]> buffer(new char[capacity]);
+  Long used(0);
+  auto flush = [&] (bool all) {
+    const Long nwrite(all ? used : (used / stripeSize) * stripeSize);
+    ofs.write(buffer.get(), nwrite);
+    std::memmove(buffer.get(), buffer.get() + nwrite, used - nwrite);
+    used -= nwrite;
+  };
+
+  for(int r(0); r < groupSize; ++r) {
+    for(Long pos(0); pos < sizes[r]; pos += bufferSize) {
+      const Long n(std::min(bufferSize, sizes[r] - pos));
+      if(used + n > capacity) {
+        flush(false);
+      }
+      if(r == 0) {
+        pack(buffer.get() + used, pos, n);
+      } else {
+#ifdef BL_USE_MPI
+        ParallelDescriptor::Recv(buffer.get() + used, static_cast<std::size_t>(n), r, tag, comm);
+#endif
+      }
+      used += n;
+    }
+  }
+  flush(true);
+
+  ofs.close();
+  if( ! ofs.good()) {
+    amrex::Error("NFilesIter::AggregatedWrite:  failed to write " + fileName);
+  }
+
+  return {fileNumber, myOffset};
+}
+
+
+
 void NFilesIter::CleanUpMessages() {
 #ifdef BL_USE_MPI
   BL_PROFILE("NFI::CleanUpMessages");
@@ -147,4 +147,32 @@ PlotFileDataImpl::get (int level, std::string const& varname) noexcept
     return mf;
 }
 
+FArrayBox
+PlotFileDataImpl::get (int level, Box const& region, Vector<std::string> const& varnames) noexcept
+{
+    const auto ncomp = static_cast<int>(varnames.size());
+    Vector<int> icomp(ncomp);
+    for (int n = 0; n < ncomp; ++n) {
+        auto r = std::find(std::begin(m_var_names), std::end(m_var_names), varnames[n]);
+        if (r == std::end(m_var_names)) {
+            amrex::Abort("PlotFileDataImpl::get: varname not found "+varnames[n]);
+        }
+        icomp[n] = static_cast<int>(std::distance(std::begin(m_var_names), r));
+    }
+
+    FArrayBox fab(region, ncomp, The_Pinned_Arena());
+    fab.setVal<RunOn::Host>(0.0);
+
+    for (auto const& is : m_ba[level].intersections(region)) {
+        // Variables that are consecutive in the plotfile are read together.
+        for (int n = 0; n < ncomp; ) {
+            int nc = 1;
+            while (n+nc < ncomp && icomp[n+nc] == icomp[n]+nc) { ++nc; }
+            m_vismf[level]->readFABRegion(fab, n, is.first, icomp[n], nc);
+            n += nc;
+        }
+    }
+    return fab;
+}
+
 }
@@ -4,6 +4,7 @@
 #include <AMReX_PlotFileUtil.H>
 #include <AMReX_FPC.H>
 #include <AMReX_FabArrayUtility.H>
+#include <AMReX_ParmParse.H>
 
 #ifdef AMREX_USE_EB
 #include <AMReX_EBFabFactory.H>
@@ -14,6 +15,42 @@
 
 namespace amrex {
 
+namespace {
+    // Absolute error bounds for the lossy compression of the components of
+    // mf, or an empty Vector if all components are written without loss.
+    // A relative error bound is relative to the range of the component.
+    Vector<Real> PlotfileErrorBounds (const MultiFab& mf, const Vector<std::string>& varnames)
+    {
+        Real abs_error = 0.0, rel_error = 0.0;
+        ParmParse pp("amrex");
+        pp.query("plotfile_abs_error", abs_error);
+        pp.query("plotfile_rel_error", rel_error);
+        ParmParse ppabs("amrex.plotfile_abs_error");
+        ParmParse pprel("amrex.plotfile_rel_error");
+
+        Vector<Real> error_bounds(mf.nComp(), 0.0);
+        bool lossy = false;
+        for (int n = 0; n < static_cast<int>(varnames.size()) && n < mf.nComp(); ++n) {
+            Real a = abs_error, r = rel_error;
+            ppabs.query(varnames[n].c_str(), a);
+            pprel.query(varnames[n].c_str(), r);
+            Real e = a;
+            if (r > 0.0) {
+                const Real range = mf.max(n) - mf.min(n);
+                if (range > 0.0) {
+                    e = (e > 0.0) ? std::min(e, r*range) : r*range;
+                }
+            }
+            if (e > 0.0) {
+                error_bounds[n] = e;
+                lossy = true;
+            }
+        }
+        if (!lossy) { error_bounds.clear(); }
+        return error_bounds;
+    }
+}
+
 std::string LevelPath (int level, const std::string &levelPrefix)
 {
     return Concatenate(levelPrefix, level, 1);  // e.g., Level_5
@@ -234,7 +271,8 @@ WriteMultiLevelPlotfile (const std::string& plotfilename, int nlevels,
             } else {
                 data = mf[level];
             }
-            VisMF::Write(*data, MultiFabFileFullPrefix(level, plotfilename, levelPrefix, mfPrefix));
+            VisMF::Write(*data, MultiFabFileFullPrefix(level, plotfilename, levelPrefix, mfPrefix),
+                         VisMF::NFiles, false, PlotfileErrorBounds(*data, varnames));
         }
     }
 }
@@ -450,7 +488,10 @@ EB_WriteMultiLevelPlotfile (const std::string& plotfilename, int nlevels,
         MultiFab::Copy(mf_tmp, *mf[level], 0, 0, nc, 0);
         auto const& factory = dynamic_cast<EBFArrayBoxFactory const&>(mf[level]->Factory());
         MultiFab::Copy(mf_tmp, factory.getVolFrac(), 0, nc, 1, 0);
-        VisMF::Write(mf_tmp, MultiFabFileFullPrefix(level, plotfilename, levelPrefix, mfPrefix));
+        Vector<std::string> vn = varnames;
+        vn.push_back("vfrac");
+        VisMF::Write(mf_tmp, MultiFabFileFullPrefix(level, plotfilename, levelPrefix, mfPrefix),
+                     VisMF::NFiles, false, PlotfileErrorBounds(mf_tmp, vn));
     }
 
 //    VisMF::SetNOutFiles(saveNFiles);
@@ -0,0 +1,362 @@
+
+#include <AMReX_SArena.H>
+#include <AMReX.H>
+#include <AMReX_ParallelReduce.H>
+#include <AMReX_Print.H>
+
+#include <algorithm>
+#include <iostream>
+
+namespace amrex {
+
+namespace {
+    std::size_t next_pow2 (std::size_t n) noexcept
+    {
+        std::size_t r = 1;
+        while (r < n) { r *= 2; }
+        return r;
+    }
+}
+
+SArena::SArena (ArenaInfo info, std::size_t max_block_size, std::size_t slab_size)
+    : m_min_block_size(Arena::align_size),
+      m_max_block_size(std::max(next_pow2(max_block_size), Arena::align_size)),
+      m_slab_size(std::max(next_pow2(slab_size), next_pow2(max_block_size))),
+      m_large(0, info)
+{
+    arena_info = info;
+
+    m_nclasses = 1;
+    while (class_size(m_nclasses-1) < m_max_block_size) { ++m_nclasses; }
+
+    m_partial.resize(m_nclasses, nullptr);
+    m_class_slabs.resize(m_nclasses, 0);
+    m_class_blocks.resize(m_nclasses, 0);
+}
+
+SArena::~SArena ()
+{
+    for (auto const& chunk : m_chunks) {
+        deallocate_system(chunk.p, chunk.nbytes);
+    }
+}
+
+int
+SArena::size_class (std::size_t nbytes) const noexcept
+{
+    int c = 0;
+    while (class_size(c) < nbytes) { ++c; }
+    return c;
+}
+
+SArena::Slab*
+SArena::find_slab (void* p)
+{
+    auto key = reinterpret_cast<std::uintptr_t>(p) & ~(std::uintptr_t(m_slab_size)-1);
+    auto it = m_slabs.find(key);
+    return (it == m_slabs.end()) ? nullptr : &(it->second);
+}
+
+SArena::Slab const*
+SArena::find_slab (void* p) const
+{
+    auto key = reinterpret_cast<std::uintptr_t>(p) & ~(std::uintptr_t(m_slab_size)-1);
+    auto it = m_slabs.find(key);
+    return (it == m_slabs.end()) ? nullptr : &(it->second);
+}
+
+void
+SArena::push_partial (Slab* s) noexcept
+{
+    auto& head = m_partial[s->size_class];
+    s->prev = nullptr;
+    s->next = head;
+    if (head) { head->prev = s; }
+    head = s;
+}
+
+void
+SArena::erase_partial (Slab* s) noexcept
+{
+    if (s->prev) {
+        s->prev->next = s->next;
+    } else {
+        m_partial[s->size_class] = s->next;
+    }
+    if (s->next) { s->next->prev = s->prev; }
+    s->prev = nullptr;
+    s->next = nullptr;
+}
+
+SArena::Slab*
+SArena::new_slab (int c)
+{
+    if (m_free_slabs.empty()) {
+        // Allocate one more slab so that the slabs can be aligned to their size.
+        Chunk chunk;
+        chunk.nbytes = (SlabsPerChunk+1) * m_slab_size;
+        chunk.p = allocate_system(chunk.nbytes);
+        m_chunks.push_back(chunk);
+        m_stats.system_bytes += chunk.nbytes;
+        Chunk* pc = &m_chunks.back();
+        char* base = static_cast<char*>(chunk.p)
+            + (amrex::aligned_size(m_slab_size, reinterpret_cast<std::uintptr_t>(chunk.p))
+               - reinterpret_cast<std::uintptr_t>(chunk.p));
+        // In reverse order so that the slabs are used from low addresses.
+        for (int i = SlabsPerChunk-1; i >= 0; --i) {
+            m_free_slabs.emplace_back(base + i*m_slab_size, pc);
+        }
+    }
+
+    auto [base, chunk] = m_free_slabs.back();
+    m_free_slabs.pop_back();
+    ++chunk->nslabs_used;
+
+    Slab& s = m_slabs[reinterpret_cast<std::uintptr_t>(base)];
+    s.base = base;
+    s.chunk = chunk;
+    s.size_class = c;
+    auto nblocks = static_cast<std::uint32_t>(m_slab_size / class_size(c));
+    s.free_blocks.resize(nblocks);
+    for (std::uint32_t i = 0; i < nblocks; ++i) {
+        s.free_blocks[i] = nblocks-1-i;
+    }
+    push_partial(&s);
+
+    ++m_class_slabs[c];
+    m_stats.slab_bytes += m_slab_size;
+    return &s;
+}
+
+void
+SArena::release_slab (Slab* s)
+{
+    erase_partial(s);
+    --m_class_slabs[s->size_class];
+    m_stats.slab_bytes -= m_slab_size;
+    --s->chunk->nslabs_used;
+    m_free_slabs.emplace_back(s->base, s->chunk);
+    m_slabs.erase(reinterpret_cast<std::uintptr_t>(s->base));
+}
+
+void*
+SArena::alloc_small (std::size_t nbytes)
+{
+    const int c = size_class(nbytes);
+    Slab* s = m_partial[c];
+    if (s == nullptr) {
+        s = new_slab(c);
+    }
+
+    std::uint32_t i = s->free_blocks.back();
+    s->free_blocks.pop_back();
+    if (s->free_blocks.empty()) {
+        erase_partial(s);
+    }
+
+    ++m_class_blocks[c];
+    ++m_stats.nalloc;
+    m_stats.requested_bytes += nbytes;
+    m_stats.rounded_bytes += class_size(c);
+    m_stats.block_bytes += class_size(c);
+    return s->base + i*class_size(c);
+}
+
+bool
+SArena::free_small (void* p)
+{
+    Slab* s = find_slab(p);
+    if (s == nullptr) { return false; }
+
+    const int c = s->size_class;
+    auto offset = static_cast<std::size_t>(static_cast<char*>(p) - s->base);
+    AMREX_ASSERT(offset % class_size(c) == 0);
+    const bool was_full = s->free_blocks.empty();
+    s->free_blocks.push_back(static_cast<std::uint32_t>(offset / class_size(c)));
+
+    --m_class_blocks[c];
+    ++m_stats.nfree;
+    m_stats.block_bytes -= class_size(c);
+
+    if (was_full) {
+        push_partial(s);
+    }
+    // An empty slab is kept if it is the only one of its size class with
+    // free blocks, so that alternating allocs and frees do not churn.
+    if (s->free_blocks.size() == m_slab_size / class_size(c) &&
+        (s->prev != nullptr || s->next != nullptr)) {
+        release_slab(s);
+    }
+    return true;
+}
+
+void*
+SArena::alloc (std::size_t nbytes)
+{
+    nbytes = (nbytes == 0) ? 1 : nbytes;
+    void* p;
+    if (nbytes > m_max_block_size) {
+        p = m_large.alloc(nbytes);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.nlarge;
+    } else {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        p = alloc_small(nbytes);
+    }
+    m_profiler.profile_alloc(p, nbytes);
+    return p;
+}
+
+std::pair<void*,std::size_t>
+SArena::alloc_in_place (void* pt, std::size_t szmin, std::size_t szmax)
+{
+    szmax = (szmax == 0) ? 1 : szmax;
+    if (pt != nullptr) {
+        std::size_t bsize = sizeOf(pt);
+        if (bsize > 0 && bsize >= szmax) {
+            return std::make_pair(pt, bsize);
+        }
+        if (bsize == 0 && szmax > m_max_block_size) {
+            return m_large.alloc_in_place(pt, szmin, szmax);
+        }
+    }
+    void* p = alloc(szmax);
+    return std::make_pair(p, (szmax > m_max_block_size) ? szmax : class_size(size_class(szmax)));
+}
+
+void*
+SArena::shrink_in_place (void* pt, std::size_t new_size)
+{
+    if ((pt == nullptr) || (new_size == 0)) { return nullptr; }
+    std::size_t bsize = sizeOf(pt);
+    if (bsize > 0) {
+        if (new_size > bsize) {
+            amrex::Abort("SArena::shrink_in_place: wrong size. Cannot shrink to a larger size.");
+        }
+        return (size_class(new_size) == size_class(bsize)) ? pt : alloc(new_size);
+    } else if (new_size > m_max_block_size) {
+        return m_large.shrink_in_place(pt, new_size);
+    } else {
+        return alloc(new_size);
+    }
+}
+
+void
+SArena::free (void* vp)
+{
+    if (vp == nullptr) { return; }
+    m_profiler.profile_free(vp);
+    bool small;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        small = free_small(vp);
+    }
+    if (!small) {
+        m_large.free(vp);
+    }
+}
+
+std::size_t
+SArena::freeUnused ()
+{
+    std::size_t r = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int c = 0; c < m_nclasses; ++c) {
+            const std::size_t nblocks = m_slab_size / class_size(c);
+            for (Slab* s = m_partial[c]; s != nullptr; ) {
+                Slab* next = s->next;
+                if (s->free_blocks.size() == nblocks) {
+                    release_slab(s);
+                }
+                s = next;
+            }
+        }
+        m_free_slabs.erase(std::remove_if(m_free_slabs.begin(), m_free_slabs.end(),
+                                          [] (auto const& x) { return x.second->nslabs_used == 0; }),
+                           m_free_slabs.end());
+        for (auto it = m_chunks.begin(); it != m_chunks.end(); ) {
+            if (it->nslabs_used == 0) {
+                deallocate_system(it->p, it->nbytes);
+                r += it->nbytes;
+                m_stats.system_bytes -= it->nbytes;
+                it = m_chunks.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    return r + m_large.freeUnused();
+}
+
+std::size_t
+SArena::sizeOf (void* p) const
+{
+    if (p == nullptr) { return 0; }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Slab const* s = find_slab(p);
+    return (s == nullptr) ? 0 : class_size(s->size_class);
+}
+
+SArena::Stats
+SArena::stats () const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void
+SArena::PrintUsage (std::string const& name) const
+{
+    auto st = stats();
+    Long rounding = (st.rounded_bytes > 0)
+        ? static_cast<Long>(100 - (100*st.requested_bytes)/st.rounded_bytes) : 0;
+    Long unused = (st.slab_bytes > 0)
+        ? static_cast<Long>(100 - (100*st.block_bytes)/st.slab_bytes) : 0;
+    Long min_megabytes = static_cast<Long>(st.system_bytes / (1024*1024));
+    Long max_megabytes = min_megabytes;
+    Long rounding_min = rounding, rounding_max = rounding;
+    Long unused_min = unused, unused_max = unused;
+    const int IOProc = ParallelDescriptor::IOProcessorNumber();
+    ParallelReduce::Min<Long>({min_megabytes, rounding_min, unused_min},
+                              IOProc, ParallelDescriptor::Communicator());
+    ParallelReduce::Max<Long>({max_megabytes, rounding_max, unused_max},
+                              IOProc, ParallelDescriptor::Communicator());
+#ifdef AMREX_USE_MPI
+    amrex::Print() << "[" << name << "] slab space (MB) allocated spread across MPI: ["
+                   << min_megabytes << " ... " << max_megabytes << "]\n"
+                   << "[" << name << "] bytes lost to rounding (%) spread across MPI: ["
+                   << rounding_min << " ... " << rounding_max << "]\n"
+                   << "[" << name << "] slab space unused      (%) spread across MPI: ["
+                   << unused_min << " ... " << unused_max << "]\n";
+#else
+    amrex::Print() << "[" << name << "] slab space allocated (MB): " << min_megabytes << "\n"
+                   << "[" << name << "] bytes lost to rounding (%): " << rounding_min << "\n"
+                   << "[" << name << "] slab space unused      (%): " << unused_min << "\n";
+#endif
+    m_large.PrintUsage(name + "] [large");
+}
+
+void
+SArena::PrintUsage (std::ostream& os, std::string const& name, std::string const& space) const
+{
+    auto st = stats();
+    os << space << "[" << name << "]: " << st.nalloc << " small allocs, " << st.nfree
+       << " small frees, " << st.nlarge << " large allocs\n";
+    os << space << "[" << name << "]: " << st.requested_bytes << " bytes requested in "
+       << st.rounded_bytes << " bytes of blocks\n";
+    os << space << "[" << name << "]: " << st.block_bytes << " bytes in use in "
+       << st.slab_bytes << " bytes of slabs, " << st.system_bytes << " bytes allocated\n";
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int c = 0; c < m_nclasses; ++c) {
+            if (m_class_slabs[c] > 0) {
+                os << space << "[" << name << "]   " << class_size(c) << " byte blocks: "
+                   << m_class_blocks[c] << " in use in " << m_class_slabs[c] << " slabs\n";
+            }
+        }
+    }
+    m_large.PrintUsage(os, name + "] [large", space);
+}
+
+}
@@ -0,0 +1,318 @@
+
+#include <AMReX_TCArena.H>
+#include <AMReX_OpenMP.H>
+#include <AMReX_ParallelReduce.H>
+#include <AMReX_Print.H>
+
+#include <algorithm>
+#include <iostream>
+
+namespace amrex {
+
+TCArena::TCArena (std::size_t hunk_size, ArenaInfo info,
+                  std::size_t max_cached_size, std::size_t thread_bytes)
+    : CArena(hunk_size, info),
+      m_thread_bytes(static_cast<Long>(thread_bytes)),
+      m_owner(std::this_thread::get_id())
+{
+    // Four size classes per power of two, i.e., at most 25% of a block is wasted.
+    max_cached_size = std::max(Arena::align(max_cached_size), Arena::align_size);
+    std::size_t sz = Arena::align_size;
+    while (sz < max_cached_size) {
+        m_class_size.push_back(sz);
+        std::size_t pow2 = Arena::align_size;
+        while (pow2*2 <= sz) { pow2 *= 2; }
+        sz += std::max(Arena::align_size, pow2/4);
+    }
+    m_class_size.push_back(max_cached_size);
+
+    for (auto csz : m_class_size) {
+        m_class_capacity.push_back(static_cast<int>(std::clamp(thread_bytes/(4*csz),
+                                                               std::size_t(2),
+                                                               std::size_t(1024))));
+    }
+
+    m_cache.resize(OpenMP::get_max_threads());
+    for (auto& tc : m_cache) {
+        tc.bins.resize(m_class_size.size());
+        tc.nrefill.resize(m_class_size.size(), 1);
+        tc.freed.reserve(max_freed);
+    }
+}
+
+TCArena::~TCArena ()
+{
+    // The hunks are released by ~CArena, but this keeps the profiling
+    // statistics of the CArena balanced.
+    auto lock = lock_mutex();
+    for (auto& tc : m_cache) {
+        flush_protected(tc);
+    }
+}
+
+int
+TCArena::size_class (std::size_t nbytes) const noexcept
+{
+    auto it = std::lower_bound(m_class_size.begin(), m_class_size.end(), nbytes);
+    return (it == m_class_size.end()) ? -1 : static_cast<int>(it - m_class_size.begin());
+}
+
+TCArena::ThreadCache*
+TCArena::thread_cache () noexcept
+{
+#ifdef AMREX_USE_OMP
+    // Thread numbers are not unique in nested parallel regions.
+    if (omp_get_level() == 1) {
+        auto tid = static_cast<std::size_t>(OpenMP::get_thread_num());
+        if (tid < m_cache.size()) {
+            return &m_cache[tid];
+        }
+    }
+#endif
+    return nullptr;
+}
+
+void*
+TCArena::alloc (std::size_t nbytes)
+{
+    nbytes = Arena::align(nbytes == 0 ? 1 : nbytes);
+    ThreadCache* tc = thread_cache();
+    if (tc == nullptr) {
+        if (m_pending.load(std::memory_order_relaxed) && owns_caches()) {
+            drain();
+        }
+        return CArena::alloc(nbytes);
+    }
+
+    int c = size_class(nbytes);
+    if (c < 0) {
+        void* p = CArena::alloc(nbytes);
+        tc->owned.erase(p);
+        return p;
+    }
+
+    ++tc->stats.nalloc;
+    auto& bin = tc->bins[c];
+    if (bin.empty()) {
+        auto lock = lock_mutex();
+        ++tc->stats.nrefills;
+        sort_freed(*tc);
+        // The batch size starts at one and grows for the sizes that keep
+        // missing, up to half of the capacity so that frees have room.
+        // Beyond thread_bytes, only the requested block is fetched.
+        auto& nrefill = tc->nrefill[c];
+        const auto csz = static_cast<Long>(m_class_size[c]);
+        while (static_cast<int>(bin.size()) < nrefill &&
+               (bin.empty() || tc->stats.cached_bytes + csz <= m_thread_bytes))
+        {
+            bin.push_back(alloc_protected(m_class_size[c]));
+            tc->stats.cached_bytes += csz;
+        }
+        nrefill = std::min({2*nrefill, m_class_capacity[c]/2, 64});
+        nrefill = std::max(nrefill, 1);
+    } else {
+        ++tc->stats.nhits;
+    }
+
+    void* p = bin.back();
+    bin.pop_back();
+    tc->stats.cached_bytes -= static_cast<Long>(m_class_size[c]);
+    tc->owned[p] = c;
+    return p;
+}
+
+void
+TCArena::free (void* vp)
+{
+    if (vp == nullptr) { return; }
+
+    ThreadCache* tc = thread_cache();
+    if (tc == nullptr) {
+        if (m_pending.load(std::memory_order_relaxed) && owns_caches()) {
+            drain();
+        }
+        CArena::free(vp);
+        return;
+    }
+
+    // Only the blocks handed out by this thread's bins have a known size
+    // class.  The others, e.g., big blocks and blocks of other threads,
+    // go to the CArena at once.  The size is checked again when the
+    // freed blocks are sorted with the mutex locked, because the class
+    // recorded for a block freed elsewhere may be stale until the next
+    // drain().
+    auto it = tc->owned.find(vp);
+    if (it == tc->owned.end()) {
+        ++tc->stats.nfree_direct;
+        CArena::free(vp);
+        return;
+    }
+    const int c = it->second;
+    tc->owned.erase(it);
+
+    ++tc->stats.nfree;
+    tc->freed.push_back(vp);
+    tc->freed_bytes += static_cast<Long>(m_class_size[c]);
+    m_pending.store(true, std::memory_order_relaxed);
+    if (static_cast<int>(tc->freed.size()) >= max_freed || 4*tc->freed_bytes >= m_thread_bytes) {
+        auto lock = lock_mutex();
+        ++tc->stats.nrefills;
+        sort_freed(*tc);
+    }
+}
+
+void
+TCArena::sort_freed (ThreadCache& tc)
+{
+    for (auto* p : tc.freed) {
+        auto busy_it = m_busylist.find(Node(p,nullptr,0));
+        if (busy_it == m_busylist.end()) {
+            amrex::Abort("TCArena::free: unknown pointer");
+        }
+        int c = size_class(busy_it->size());
+        if (c >= 0 && m_class_size[c] == busy_it->size() &&
+            static_cast<int>(tc.bins[c].size()) < m_class_capacity[c] &&
+            tc.stats.cached_bytes + static_cast<Long>(m_class_size[c]) <= m_thread_bytes)
+        {
+            tc.bins[c].push_back(p);
+            tc.stats.cached_bytes += static_cast<Long>(m_class_size[c]);
+        } else {
+            if (c >= 0) {
+                tc.nrefill[c] = std::max(tc.nrefill[c]/2, 1);
+            }
+            free_protected(p);
+        }
+    }
+    tc.freed.clear();
+    tc.freed_bytes = 0;
+}
+
+void
+TCArena::prune_owned (ThreadCache& tc)
+{
+    for (auto it = tc.owned.begin(); it != tc.owned.end(); ) {
+        auto busy_it = m_busylist.find(Node(it->first,nullptr,0));
+        if (busy_it == m_busylist.end() || busy_it->size() != m_class_size[it->second]) {
+            it = tc.owned.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool
+TCArena::owns_caches () const noexcept
+{
+    // Other threads may run while a parallel region of the owner uses the
+    // caches, e.g., the thread of AsyncOut.
+    return std::this_thread::get_id() == m_owner && !OpenMP::in_parallel();
+}
+
+void
+TCArena::drain ()
+{
+    AMREX_ASSERT(owns_caches());
+    auto lock = lock_mutex();
+    for (auto& tc : m_cache) {
+        sort_freed(tc);
+        prune_owned(tc);
+    }
+    m_pending.store(false, std::memory_order_relaxed);
+}
+
+void
+TCArena::flush_protected (ThreadCache& tc)
+{
+    for (auto* p : tc.freed) {
+        free_protected(p);
+    }
+    tc.freed.clear();
+    tc.freed_bytes = 0;
+    prune_owned(tc);
+    for (auto& bin : tc.bins) {
+        for (auto* p : bin) {
+            free_protected(p);
+        }
+        bin.clear();
+    }
+    tc.stats.cached_bytes = 0;
+}
+
+void
+TCArena::flush ()
+{
+    AMREX_ASSERT(owns_caches());
+    auto lock = lock_mutex();
+    for (auto& tc : m_cache) {
+        flush_protected(tc);
+    }
+    m_pending.store(false, std::memory_order_relaxed);
+}
+
+std::size_t
+TCArena::freeUnused ()
+{
+    if (!owns_caches()) {
+        return CArena::freeUnused();
+    } else {
+        auto lock = lock_mutex();
+        for (auto& tc : m_cache) {
+            flush_protected(tc);
+        }
+        m_pending.store(false, std::memory_order_relaxed);
+        return freeUnused_protected();
+    }
+}
+
+TCArena::CacheStats
+TCArena::cacheStats () const
+{
+    CacheStats r;
+    for (auto const& tc : m_cache) {
+        r.nalloc += tc.stats.nalloc;
+        r.nhits += tc.stats.nhits;
+        r.nfree += tc.stats.nfree;
+        r.nfree_direct += tc.stats.nfree_direct;
+        r.nrefills += tc.stats.nrefills;
+        r.cached_bytes += tc.stats.cached_bytes;
+    }
+    return r;
+}
+
+void
+TCArena::PrintUsage (std::string const& name) const
+{
+    CArena::PrintUsage(name);
+
+    auto stats = cacheStats();
+    Long hit_percent = (stats.nalloc > 0) ? (100*stats.nhits)/stats.nalloc : 0;
+    Long contended_percent = (numLocks() > 0) ? (100*numContendedLocks())/numLocks() : 0;
+    Long hit_min = hit_percent, hit_max = hit_percent;
+    Long contended_min = contended_percent, contended_max = contended_percent;
+    const int IOProc = ParallelDescriptor::IOProcessorNumber();
+    ParallelReduce::Min<Long>({hit_min, contended_min}, IOProc, ParallelDescriptor::Communicator());
+    ParallelReduce::Max<Long>({hit_max, contended_max}, IOProc, ParallelDescriptor::Communicator());
+#ifdef AMREX_USE_MPI
+    amrex::Print() << "[" << name << "] thread cache hit rate (%) spread across MPI: ["
+                   << hit_min << " ... " << hit_max << "]\n"
+                   << "[" << name << "] contended locks  (%) spread across MPI: ["
+                   << contended_min << " ... " << contended_max << "]\n";
+#else
+    amrex::Print() << "[" << name << "] thread cache hit rate (%): " << hit_min << "\n"
+                   << "[" << name << "] contended locks  (%): " << contended_min << "\n";
+#endif
+}
+
+void
+TCArena::PrintUsage (std::ostream& os, std::string const& name, std::string const& space) const
+{
+    CArena::PrintUsage(os, name, space);
+
+    auto stats = cacheStats();
+    os << space << "[" << name << "] thread cache: " << stats.nalloc << " allocs, "
+       << stats.nhits << " hits, " << stats.nfree << " deferred and " << stats.nfree_direct
+       << " direct frees, " << stats.nrefills
+       << " refills, " << stats.cached_bytes << " bytes cached\n";
+}
+
+}
@@ -42,6 +42,7 @@ std::vector<TinyProfiler::aligned_deque> TinyProfiler::mem_stack_thread_private;
 #endif
 std::vector<std::map<std::string, MemStat>*> TinyProfiler::all_memstats;
 std::vector<std::string> TinyProfiler::all_memnames;
+std::vector<std::function<void(std::ostream*)>> TinyProfiler::all_reports;
 
 std::vector<std::string>          TinyProfiler::regionstack;
 std::deque<std::tuple<double,double,std::string*> > TinyProfiler::ttstack;
@@ -353,7 +354,10 @@ TinyProfiler::MemoryInitialize () noexcept
 void
 TinyProfiler::Finalize (bool bFlushing) noexcept
 {
-    if (!enabled) { return; }
+    if (!enabled) {
+        if (!bFlushing) { all_reports.clear(); }
+        return;
+    }
 
     if (!bFlushing) {                // If flushing, don't make this the last time!
         if (finalized) {
@@ -436,10 +440,15 @@ TinyProfiler::Finalize (bool bFlushing) noexcept
         }
     }
 
+    for (auto const& f : all_reports) {
+        f(os);
+    }
+
     if (!bFlushing) {
         regionstack.clear();
         ttstack.clear();
         statsmap.clear();
+        all_reports.clear();
     }
 }
 
@@ -491,6 +500,12 @@ TinyProfiler::MemoryFinalize (bool bFlushing) noexcept
     if(os) { os->precision(oldprec); }
 }
 
+void
+TinyProfiler::RegisterReport (std::function<void(std::ostream*)> f)
+{
+    all_reports.push_back(std::move(f));
+}
+
 bool
 TinyProfiler::RegisterArena (const std::string& memory_name,
                              std::map<std::string, MemStat>& memstats) noexcept
@@ -957,6 +972,13 @@ TinyProfiler::PrintCallStack (std::ostream& os)
     }
 }
 
+std::string const&
+TinyProfiler::CurrentRegion () noexcept
+{
+    static const std::string main_name(mainregion);
+    return regionstack.empty() ? main_name : regionstack.back();
+}
+
 std::string const&
 TinyProfiler::get_output_file ()
 {
@@ -1,5 +1,8 @@
 
+#include <AMReX_CArena.H>
+#include <AMReX_Compression.H>
 #include <AMReX_FabArrayUtility.H>
+#include <AMReX_FileSystem.H>
 #include <AMReX_FPC.H>
 #include <AMReX_IOFormat.H>
 #include <AMReX_ParmParse.H>
@@ -7,15 +10,121 @@
 #include <AMReX_VisMF.H>
 
 #include <cerrno>
+#include <cmath>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <limits>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <type_traits>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace amrex {
 
 namespace {
     const char *TheMultiFabHdrFileSuffix = "_H";
     const char *FabFileSuffix = "_D_";
+    const char *FabHashFileSuffix = "_Hashes";
     const char *TheFabOnDiskPrefix = "FabOnDisk:";
+
+    std::unique_ptr<Arena> directIOArena;
+
+    std::uint64_t rotl64 (std::uint64_t x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    // ---- a 64-bit hash of n bytes built like xxHash64
+    std::uint64_t hash_bytes (const char *p, std::size_t n)
+    {
+        constexpr std::uint64_t p1 = 0x9E3779B185EBCA87ULL;
+        constexpr std::uint64_t p2 = 0xC2B2AE3D27D4EB4FULL;
+        constexpr std::uint64_t p3 = 0x165667B19E3779F9ULL;
+        constexpr std::uint64_t p4 = 0x85EBCA77C2B2AE63ULL;
+        auto round = [&] (std::uint64_t acc, const char *q) {
+            std::uint64_t w;
+            std::memcpy(&w, q, sizeof(w));
+            return rotl64(acc + w * p2, 31) * p1;
+        };
+
+        std::size_t i(0);
+        std::uint64_t h(p3 + n);
+        if(n >= 32) {
+            std::uint64_t v[4] = {p1 + p2, p2, 0, 0 - p1};
+            for( ; i + 32 <= n; i += 32) {
+                for(int k(0); k < 4; ++k) {
+                    v[k] = round(v[k], p + i + 8*k);
+                }
+            }
+            h = rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) + rotl64(v[3], 18) + n;
+        }
+        for( ; i + 8 <= n; i += 8) {
+            h ^= round(0, p + i);
+            h = rotl64(h, 27) * p1 + p4;
+        }
+        for( ; i < n; ++i) {
+            h ^= static_cast<unsigned char>(p[i]) * p3;
+            h = rotl64(h, 11) * p1;
+        }
+        h ^= h >> 33;
+        h *= p2;
+        h ^= h >> 29;
+        h *= p3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    // ---- the components of path, made absolute, without "." and "dir/.."
+    Vector<std::string> path_components (const std::string &path)
+    {
+        std::string abspath(path);
+        if(abspath.empty() || abspath[0] != '/') {
+            abspath = FileSystem::CurrentPath() + '/' + abspath;
+        }
+        Vector<std::string> parts;
+        std::istringstream iss(abspath);
+        std::string part;
+        while(std::getline(iss, part, '/')) {
+            if(part.empty() || part == ".") {
+                continue;
+            } else if(part == "..") {
+                if( ! parts.empty()) {
+                    parts.pop_back();
+                }
+            } else {
+                parts.push_back(part);
+            }
+        }
+        return parts;
+    }
+
+    // ---- the path of the file with components file relative to the directory dir
+    std::string relative_path (const Vector<std::string> &file, const Vector<std::string> &dir)
+    {
+        Long n(0);
+        while(n < file.size() && n < dir.size() && file[n] == dir[n]) {
+            ++n;
+        }
+        std::string path;
+        for(Long i(n); i < dir.size(); ++i) {
+            path += "../";
+        }
+        for(Long i(n); i < file.size(); ++i) {
+            path += file[i];
+            if(i + 1 < file.size()) {
+                path += '/';
+            }
+        }
+        return path;
+    }
 }
 
 std::map<std::string, VisMF::PersistentIFStream> VisMF::persistentIFStreams;
@@ -31,6 +140,15 @@ bool VisMF::usePersistentIFStreams(false);
 bool VisMF::useSynchronousReads(false);
 bool VisMF::useDynamicSetSelection(true);
 bool VisMF::allowSparseWrites(true);
+bool VisMF::useMMapReads(false);
+bool VisMF::useAggregatedWrites(false);
+int VisMF::aggregatorsPerNode(1);
+Long VisMF::aggregateStripeSize(1048576);
+Long VisMF::aggregateBufferSize(67108864);
+bool VisMF::useDirectIO(false);
+Long VisMF::directIOAlignment(4096);
+std::string VisMF::deltaDir;
+std::string VisMF::deltaRefDir;
 
 Long VisMFBuffer::ioBufferSize(VisMF::IO_Buffer_Size);
 
@@ -96,6 +214,16 @@ VisMF::Initialize ()
     pp.query("usedynamicsetselection", useDynamicSetSelection);
     pp.query("iobuffersize", ioBufferSize);
     pp.query("allowsparsewrites", allowSparseWrites);
+    pp.query("usemmapreads", useMMapReads);
+    pp.query("aggregatewrites", useAggregatedWrites);
+    pp.query("aggregatorspernode", aggregatorsPerNode);
+    pp.query("aggregatestripesize", aggregateStripeSize);
+    pp.query("aggregatebuffersize", aggregateBufferSize);
+    pp.query("usedirectio", useDirectIO);
+    pp.query("directioalignment", directIOAlignment);
+    if(directIOAlignment <= 0) {
+      amrex::Abort("VisMF::Initialize: vismf.directioalignment must be positive");
+    }
 
     initialized = true;
 }
@@ -103,6 +231,7 @@ VisMF::Initialize ()
 void
 VisMF::Finalize ()
 {
+    directIOArena.reset();
     initialized = false;
 }
 
@@ -197,9 +326,10 @@ operator>> (std::istream&            is,
 
 namespace {
 
+template <typename T>
 std::ostream&
 operator<< (std::ostream&               os,
-            const Vector< Vector<Real> >& ar)
+            const Vector< Vector<T> >& ar)
 {
     Long i(0), N(ar.size()), M = (N == 0) ? 0 : ar[0].size();
 
@@ -215,15 +345,16 @@ operator<< (std::ostream&               os,
     }
 
     if( ! os.good()) {
-        amrex::Error("Write of Vector<Vector<Real>> failed");
+        amrex::Error("Write of Vector<Vector<T>> failed");
     }
 
     return os;
 }
 
+template <typename T>
 std::istream&
 operator>> (std::istream&         is,
-            Vector< Vector<Real> >& ar)
+            Vector< Vector<T> >& ar)
 {
     char ch;
     Long i(0), N, M;
@@ -250,11 +381,14 @@ operator>> (std::istream&         is,
 
         for(Long j = 0; j < M; ++j) {
 #ifdef BL_USE_FLOAT
-            is >> dtemp >> ch;
-            ar[i][j] = static_cast<Real>(dtemp);
-#else
-            is >> ar[i][j] >> ch;
+            if constexpr (std::is_same_v<T, Real>) {
+                is >> dtemp >> ch;
+                ar[i][j] = static_cast<Real>(dtemp);
+            } else
 #endif
+            {
+                is >> ar[i][j] >> ch;
+            }
             if( ch != ',' ) {
               amrex::Error("Expected a ',' got something else");
             }
@@ -262,7 +396,7 @@ operator>> (std::istream&         is,
     }
 
     if( ! is.good()) {
-        amrex::Error("Read of Vector<Vector<Real>> failed");
+        amrex::Error("Read of Vector<Vector<T>> failed");
     }
 
     return is;
@@ -315,9 +449,14 @@ operator<< (std::ostream        &os,
       os << '\n';
     }
 
+    if(hd.m_vers == VisMF::Header::Compressed_v1) {
+      os << hd.m_chunkoffsets;
+    }
+
     if(hd.m_vers == VisMF::Header::NoFabHeader_v1       ||
        hd.m_vers == VisMF::Header::NoFabHeaderMinMax_v1 ||
-       hd.m_vers == VisMF::Header::NoFabHeaderFAMinMax_v1)
+       hd.m_vers == VisMF::Header::NoFabHeaderFAMinMax_v1 ||
+       hd.m_vers == VisMF::Header::Compressed_v1)
     {
       if(FArrayBox::getFormat() == FABio::FAB_NATIVE) {
         os << FPC::NativeRealDescriptor() << '\n';
@@ -403,9 +542,14 @@ operator>> (std::istream  &is,
         }
       }
     }
+    if(hd.m_vers == VisMF::Header::Compressed_v1) {
+      is >> hd.m_chunkoffsets;
+      BL_ASSERT(hd.m_ba.size() == hd.m_chunkoffsets.size());
+    }
     if(hd.m_vers == VisMF::Header::NoFabHeader_v1       ||
        hd.m_vers == VisMF::Header::NoFabHeaderMinMax_v1 ||
-       hd.m_vers == VisMF::Header::NoFabHeaderFAMinMax_v1)
+       hd.m_vers == VisMF::Header::NoFabHeaderFAMinMax_v1 ||
+       hd.m_vers == VisMF::Header::Compressed_v1)
     {
       is >> hd.m_writtenRD;
     }
@@ -652,7 +796,11 @@ VisMF::Header::Header (const FabArray<FArrayBox>& mf,
 {
 //    BL_PROFILE("VisMF::Header");
 
-    if(version == NoFabHeader_v1) {
+    if(version == Compressed_v1) {
+      m_chunkoffsets.resize(m_ba.size(), Vector<Long>(m_ncomp + 1, 0));
+    }
+
+    if(version == NoFabHeader_v1 || version == Compressed_v1) {
       m_min.clear();
       m_max.clear();
       m_famin.clear();
@@ -933,11 +1081,17 @@ Long
 VisMF::Write (const FabArray<FArrayBox>&    mf,
               const std::string& mf_name,
               VisMF::How         how,
-              bool               set_ghost)
+              bool               set_ghost,
+              const Vector<Real>& abs_error)
 {
     BL_PROFILE("VisMF::Write(FabArray)");
     BL_ASSERT(mf_name[mf_name.length() - 1] != '/');
     BL_ASSERT(currentVersion != VisMF::Header::Undefined_v1);
+    BL_ASSERT(abs_error.empty() || abs_error.size() == mf.nComp());
+
+    // ---- lossy compression is only supported by the compressed version
+    const VisMF::Header::Version version(abs_error.empty() ? currentVersion
+                                                           : VisMF::Header::Compressed_v1);
 
     // ---- add stream retry
     // ---- add stream buffer (to nfiles)
@@ -990,25 +1144,77 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
     int coordinatorProc(ParallelDescriptor::IOProcessorNumber());
     Long bytesWritten(0);
     bool calcMinMax(false);
-    VisMF::Header hdr(mf, how, currentVersion, calcMinMax);
+    VisMF::Header hdr(mf, how, version, calcMinMax);
 
     std::string filePrefix(mf_name + FabFileSuffix);
 
     NFilesIter nfi(nOutFiles, filePrefix, groupSets, setBuf);
 
-    bool oldHeader(currentVersion == VisMF::Header::Version_v1);
+    bool oldHeader(version == VisMF::Header::Version_v1);
 
-    if(useSparseFPP) {
+    // ---- FABs unchanged since the delta reference are not written
+    VisMF::DeltaInfo delta;
+    const bool deltaWrite(abs_error.empty() && VisMF::DeltaPrepare(mf, mf_name, hdr, delta));
+    auto isUnchanged = [&delta] (int idx) -> bool {
+        return ! delta.unchanged.empty() && delta.unchanged[idx];
+    };
+
+    // ---- the compressed sizes are needed for the offsets, so compress first
+    const bool compressed(version == VisMF::Header::Compressed_v1);
+    Vector<Vector<char> > compressedFabs;
+    if(compressed) {
+        for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            const int idx(mfi.index());
+            if(isUnchanged(idx)) {
+                hdr.m_chunkoffsets[idx] = delta.refHdr.m_chunkoffsets[idx];
+                compressedFabs.emplace_back();
+                continue;
+            }
+            compressedFabs.push_back(VisMF::CompressFAB(mf[mfi], *whichRD, abs_error,
+                                                        hdr.m_chunkoffsets[idx]));
+        }
+    }
+
+    // ---- in aggregated writes a few ranks per node write all the data
+    const bool aggregated(useAggregatedWrites &&
+                          FArrayBox::getFormat() != FABio::FAB_ASCII &&
+                          FArrayBox::getFormat() != FABio::FAB_8BIT);
+
+    // ---- direct i/o pads the data of each FAB to the alignment
+    const bool directIO(useDirectIO && ! aggregated &&
+                        FArrayBox::getFormat() != FABio::FAB_ASCII &&
+                        FArrayBox::getFormat() != FABio::FAB_8BIT);
+
+    int aggregatedFileNumber(-1);
+    if(aggregated) {
+        bytesWritten += VisMF::WriteAggregated(mf, filePrefix, hdr, compressedFabs, delta,
+                                               aggregatedFileNumber);
+    } else if(useSparseFPP) {
         nfi.SetSparseFPP(procsWithDataVector);
     } else if(useDynamicSetSelection) {
         nfi.SetDynamic();
     }
-    for( ; nfi.ReadyToWrite(); ++nfi) {
+    for( ; ! aggregated && nfi.ReadyToWrite(); ++nfi) {
+        if(directIO) {
+            bytesWritten += VisMF::WriteDirect(mf, hdr, compressedFabs, delta, nfi);
+            continue;
+        }
+        if(compressed) {
+            for(const auto& cfab : compressedFabs) {
+                nfi.Stream().write(cfab.data(), static_cast<std::streamsize>(cfab.size()));
+                bytesWritten += static_cast<Long>(cfab.size());
+            }
+            nfi.Stream().flush();
+            continue;
+        }
         // ---- find the total number of bytes including fab headers if needed
         const FABio &fio = FArrayBox::getFABio();
         int whichRDBytes(whichRD->numBytes()), nFABs(0);
         Long writeDataItems(0), writeDataSize(0);
         for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            if(isUnchanged(mfi.index())) {
+                continue;
+            }
             const FArrayBox &fab = mf[mfi];
             if(oldHeader) {
                 std::stringstream hss;
@@ -1032,6 +1238,9 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
         if(canCombineFABs) {
             Long writePosition(0);
             for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+                if(isUnchanged(mfi.index())) {
+                    continue;
+                }
                 std::streamoff hLength = 0;
                 const FArrayBox &fab = mf[mfi];
                 writeDataItems = fab.box().numPts() * mf.nComp();
@@ -1071,6 +1280,9 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
 
         } else {    // ---- write fabs individually
             for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+                if(isUnchanged(mfi.index())) {
+                    continue;
+                }
                 std::streamoff hLength = 0;
                 const FArrayBox &fab = mf[mfi];
                 writeDataItems = fab.box().numPts() * mf.nComp();
@@ -1115,14 +1327,61 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
         coordinatorProc = nfi.CoordinatorProc();
     }
 
-    if(currentVersion == VisMF::Header::Version_v1 ||
-       currentVersion == VisMF::Header::NoFabHeaderMinMax_v1)
+    if(deltaWrite) {
+        VisMF::DeltaFinish(mf, mf_name, delta, coordinatorProc);
+    }
+
+#ifdef BL_USE_MPI
+    if(compressed && ParallelDescriptor::NProcs() > 1) {
+        // ---- gather the chunk offsets to the coordinator
+        const int myProc(ParallelDescriptor::MyProc());
+        const int nProcs(ParallelDescriptor::NProcs());
+        const int nOffsets(mf.nComp() + 1);
+
+        std::vector<int> nmtags(nProcs, 0), offset(nProcs, 0);
+        for(int i : pmap) {
+            nmtags[i] += nOffsets;
+        }
+        for(int i(1); i < nProcs; ++i) {
+            offset[i] = offset[i-1] + nmtags[i-1];
+        }
+
+        std::vector<Long> senddata;
+        for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            const Vector<Long> &co = hdr.m_chunkoffsets[mfi.index()];
+            senddata.insert(senddata.end(), co.begin(), co.end());
+        }
+
+        std::vector<Long> recvdata((myProc == coordinatorProc) ? mf.size() * nOffsets : 0);
+        ParallelDescriptor::Gatherv(senddata.data(), nmtags[myProc], recvdata.data(),
+                                    nmtags, offset, coordinatorProc);
+
+        if(myProc == coordinatorProc) {
+            Vector<int> cnt(nProcs, 0);
+            for(int j(0), N(mf.size()); j < N; ++j) {
+                const int i(pmap[j]);
+                const Long* co = recvdata.data() + offset[i] + cnt[i];
+                hdr.m_chunkoffsets[j].assign(co, co + nOffsets);
+                cnt[i] += nOffsets;
+            }
+        }
+    }
+#endif
+
+    if(version == VisMF::Header::Version_v1 ||
+       version == VisMF::Header::NoFabHeaderMinMax_v1)
     {
         hdr.CalculateMinMax(mf, coordinatorProc);
     }
 
-    VisMF::FindOffsets(mf, filePrefix, hdr, currentVersion, nfi,
-                       ParallelDescriptor::Communicator());
+    if(aggregated) {
+        VisMF::GatherAggregatedOffsets(mf, filePrefix, hdr, delta, aggregatedFileNumber,
+                                       coordinatorProc);
+    } else {
+        VisMF::FindOffsets(mf, filePrefix, hdr, version, nfi,
+                           ParallelDescriptor::Communicator(), &delta,
+                           directIO ? directIOAlignment : 1);
+    }
 
     bytesWritten += VisMF::WriteHeader(mf_name, hdr, coordinatorProc);
 
@@ -1169,7 +1428,9 @@ VisMF::FindOffsets (const FabArray<FArrayBox> &mf,
                     const std::string &filePrefix,
                     VisMF::Header &hdr,
                     VisMF::Header::Version /*whichVersion*/,
-                    NFilesIter &nfi, MPI_Comm comm)
+                    NFilesIter &nfi, MPI_Comm comm,
+                    const VisMF::DeltaInfo *delta,
+                    Long alignment)
 {
 //    BL_PROFILE("VisMF::FindOffsets");
 
@@ -1308,11 +1569,24 @@ VisMF::FindOffsets (const FabArray<FArrayBox> &mf,
               whichFileName   = VisMF::BaseName(NFilesIter::FileName(whichFileNumber, filePrefix));
 
               for(int i : index) {
+                 if(delta && ! delta->unchanged.empty() && delta->unchanged[i]) {
+                   hdr.m_fod[i] = delta->refHdr.m_fod[i];
+                   continue;
+                 }
+                 // ---- direct i/o writes start each FAB at a multiple of alignment
+                 currentOffset[whichFileNumber] =
+                     static_cast<Long>(amrex::aligned_size(alignment, currentOffset[whichFileNumber]));
                  hdr.m_fod[i].m_name = whichFileName;
                  hdr.m_fod[i].m_head = currentOffset[whichFileNumber];
-                 currentOffset[whichFileNumber] += mf.fabbox(i).numPts() * nComps * whichRDBytes
-                                                   + fabHeaderBytes[i];
+                 if(hdr.m_vers == VisMF::Header::Compressed_v1) {
+                   currentOffset[whichFileNumber] += hdr.m_chunkoffsets[i].back();
+                 } else {
+                   currentOffset[whichFileNumber] += mf.fabbox(i).numPts() * nComps * whichRDBytes
+                                                     + fabHeaderBytes[i];
+                 }
               }
+              currentOffset[whichFileNumber] =
+                  static_cast<Long>(amrex::aligned_size(alignment, currentOffset[whichFileNumber]));
             }
           }
         }
@@ -1321,11 +1595,506 @@ VisMF::FindOffsets (const FabArray<FArrayBox> &mf,
 }
 
 
+Long
+VisMF::LayoutFABs (const FabArray<FArrayBox> &mf,
+                   VisMF::Header &hdr,
+                   const Vector<Vector<char> > &compressedFabs,
+                   const VisMF::DeltaInfo &delta,
+                   Long alignment,
+                   Vector<std::string> &fabHeaders)
+{
+    auto whichRD = FArrayBox::getDataDescriptor();
+    const bool oldHeader(hdr.m_vers == VisMF::Header::Version_v1);
+    const bool compressed(hdr.m_vers == VisMF::Header::Compressed_v1);
+    const FABio &fio = FArrayBox::getFABio();
+    const int whichRDBytes(whichRD->numBytes());
+
+    fabHeaders.clear();
+    Long nbytes(0);
+    int ifab(0);
+    for(MFIter mfi(mf); mfi.isValid(); ++mfi, ++ifab) {
+        const int idx(mfi.index());
+        if( ! delta.unchanged.empty() && delta.unchanged[idx]) {
+            continue;
+        }
+        nbytes = static_cast<Long>(amrex::aligned_size(alignment, nbytes));
+        hdr.m_fod[idx].m_head = nbytes;
+        if(compressed) {
+            nbytes += static_cast<Long>(compressedFabs[ifab].size());
+            continue;
+        }
+        if(oldHeader) {
+            std::stringstream hss;
+            fio.write_header(hss, mf[mfi], mf.nComp());
+            fabHeaders.push_back(hss.str());
+            nbytes += static_cast<Long>(fabHeaders.back().size());
+        }
+        nbytes += mf[mfi].box().numPts() * mf.nComp() * whichRDBytes;
+    }
+    return static_cast<Long>(amrex::aligned_size(alignment, nbytes));
+}
+
+
+void
+VisMF::PackFABs (const FabArray<FArrayBox> &mf,
+                 const VisMF::Header &hdr,
+                 const Vector<Vector<char> > &compressedFabs,
+                 const VisMF::DeltaInfo &delta,
+                 const Vector<std::string> &fabHeaders,
+                 char *data)
+{
+    const bool oldHeader(hdr.m_vers == VisMF::Header::Version_v1);
+    const bool compressed(hdr.m_vers == VisMF::Header::Compressed_v1);
+
+    int ifab(0);
+    int iheader(0);
+    for(MFIter mfi(mf); mfi.isValid(); ++mfi, ++ifab) {
+        const int idx(mfi.index());
+        if( ! delta.unchanged.empty() && delta.unchanged[idx]) {
+            continue;
+        }
+        char *afPtr = data + hdr.m_fod[idx].m_head;
+        if(compressed) {
+            std::memcpy(afPtr, compressedFabs[ifab].data(), compressedFabs[ifab].size());
+            continue;
+        }
+        VisMF::PackFAB(mf[mfi], mf.nComp(), oldHeader ? &fabHeaders[iheader++] : nullptr, afPtr);
+    }
+}
+
+
+void
+VisMF::PackFAB (const FArrayBox &fab, int ncomp, const std::string *fabHeader, char *data)
+{
+    auto whichRD = FArrayBox::getDataDescriptor();
+    const bool doConvert( ! (*whichRD == FPC::NativeRealDescriptor()));
+    const int whichRDBytes(whichRD->numBytes());
+
+    if(fabHeader) {
+        std::memcpy(data, fabHeader->data(), fabHeader->size());
+        data += fabHeader->size();
+    }
+    const Long writeDataItems(fab.box().numPts() * ncomp);
+    Real const* fabdata = fab.dataPtr();
+#ifdef AMREX_USE_GPU
+    std::unique_ptr<FArrayBox> hostfab;
+    if (fab.arena()->isManaged() || fab.arena()->isDevice()) {
+        hostfab = std::make_unique<FArrayBox>(fab.box(), fab.nComp(),
+                                              The_Pinned_Arena());
+        Gpu::dtoh_memcpy_async(hostfab->dataPtr(), fab.dataPtr(),
+                               fab.size()*sizeof(Real));
+        Gpu::streamSynchronize();
+        fabdata = hostfab->dataPtr();
+    }
+#endif
+    if(doConvert) {
+        RealDescriptor::convertFromNativeFormat(static_cast<void *> (data),
+                                                writeDataItems, fabdata, *whichRD);
+    } else {
+        std::memcpy(data, fabdata, writeDataItems * whichRDBytes);
+    }
+}
+
+
+Long
+VisMF::WriteDirect (const FabArray<FArrayBox> &mf,
+                    VisMF::Header &hdr,
+                    const Vector<Vector<char> > &compressedFabs,
+                    const VisMF::DeltaInfo &delta,
+                    NFilesIter &nfi)
+{
+    BL_PROFILE("VisMF::WriteDirect()");
+
+    Vector<std::string> fabHeaders;
+    const Long nbytes(VisMF::LayoutFABs(mf, hdr, compressedFabs, delta, directIOAlignment,
+                                        fabHeaders));
+    if(nbytes == 0) {
+        return 0;
+    }
+
+    // ---- the buffers come from their own arena so that they are reused
+    if( ! directIOArena) {
+        directIOArena = std::make_unique<CArena>(0, ArenaInfo().SetCpuMemory());
+    }
+    auto *p = static_cast<char *>(directIOArena->alloc(nbytes + directIOAlignment));
+    char *data = p + (directIOAlignment - reinterpret_cast<std::uintptr_t>(p) % directIOAlignment)
+                     % directIOAlignment;
+    std::memset(data, 0, nbytes);   // ---- the padding
+
+    VisMF::PackFABs(mf, hdr, compressedFabs, delta, fabHeaders, data);
+
+    if( ! nfi.WriteDirect(data, nbytes)) {
+        nfi.Stream().write(data, nbytes);
+        nfi.Stream().flush();
+    }
+
+    directIOArena->free(p);
+    return nbytes;
+}
+
+
+Long
+VisMF::WriteAggregated (const FabArray<FArrayBox> &mf,
+                        const std::string &filePrefix,
+                        VisMF::Header &hdr,
+                        const Vector<Vector<char> > &compressedFabs,
+                        const VisMF::DeltaInfo &delta,
+                        int &fileNumber)
+{
+    BL_PROFILE("VisMF::WriteAggregated()");
+
+    // ---- find where the FABs go in the data of this process
+    Vector<std::string> fabHeaders;
+    const Long nbytes(VisMF::LayoutFABs(mf, hdr, compressedFabs, delta, 1, fabHeaders));
+
+    // ---- the FABs in the order of their data, with their sizes
+    struct Piece { Long head, size; int ifab, iheader; const FArrayBox *fab; };
+    const bool oldHeader(hdr.m_vers == VisMF::Header::Version_v1);
+    const bool compressed(hdr.m_vers == VisMF::Header::Compressed_v1);
+    Vector<Piece> pieces;
+    int ifab(0);
+    for(MFIter mfi(mf); mfi.isValid(); ++mfi, ++ifab) {
+        const int idx(mfi.index());
+        if( ! delta.unchanged.empty() && delta.unchanged[idx]) {
+            continue;
+        }
+        if( ! pieces.empty()) {
+            pieces.back().size = hdr.m_fod[idx].m_head - pieces.back().head;
+        }
+        pieces.push_back({hdr.m_fod[idx].m_head, 0, ifab,
+                          oldHeader ? static_cast<int>(pieces.size()) : -1, &mf[mfi]});
+    }
+    if( ! pieces.empty()) {
+        pieces.back().size = nbytes - pieces.back().head;
+    }
+
+    // ---- the pieces of the data are packed as they are sent, one FAB
+    // ---- at a time, so at most one FAB is copied
+    Vector<char> fabData;
+    int iPiece(0), iPacked(-1);
+    auto pack = [&] (char *buf, Long pos, Long n) {
+        while(n > 0) {
+            const Piece &piece = pieces[iPiece];
+            const Long off(pos - piece.head);
+            const Long m(std::min(n, piece.size - off));
+            const char *src(nullptr);
+            if(compressed) {
+                src = compressedFabs[piece.ifab].data() + off;
+            } else {
+                if(iPacked != iPiece) {
+                    fabData.resize(piece.size);
+                    VisMF::PackFAB(*piece.fab, mf.nComp(),
+                                   oldHeader ? &fabHeaders[piece.iheader] : nullptr,
+                                   fabData.dataPtr());
+                    iPacked = iPiece;
+                }
+                src = fabData.dataPtr() + off;
+            }
+            std::memcpy(buf, src, m);
+            buf += m;
+            pos += m;
+            n -= m;
+            if(off + m == piece.size) {
+                ++iPiece;
+            }
+        }
+    };
+
+    Long offset(0);
+    std::tie(fileNumber, offset) = NFilesIter::AggregatedWrite(nbytes, pack, filePrefix,
+                                                               aggregatorsPerNode,
+                                                               aggregateStripeSize,
+                                                               aggregateBufferSize);
+
+    const std::string fileName(VisMF::BaseName(NFilesIter::FileName(fileNumber, filePrefix)));
+    for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        const int idx(mfi.index());
+        if(delta.unchanged.empty() || ! delta.unchanged[idx]) {
+            hdr.m_fod[idx].m_name = fileName;
+            hdr.m_fod[idx].m_head += offset;
+        }
+    }
+
+    return nbytes;
+}
+
+
+void
+VisMF::GatherAggregatedOffsets (const FabArray<FArrayBox> &mf,
+                                const std::string &filePrefix,
+                                VisMF::Header &hdr,
+                                const VisMF::DeltaInfo &delta,
+                                int fileNumber,
+                                int coordinatorProc)
+{
+    const int myProc(ParallelDescriptor::MyProc());
+
+#ifdef BL_USE_MPI
+    if(ParallelDescriptor::NProcs() > 1) {
+        // ---- gather the [file number, offset] of each FAB to the coordinator
+        const int nProcs(ParallelDescriptor::NProcs());
+        const Vector<int> &pmap = mf.DistributionMap().ProcessorMap();
+
+        std::vector<int> nmtags(nProcs, 0), offset(nProcs, 0);
+        for(int i : pmap) {
+            nmtags[i] += 2;
+        }
+        for(int i(1); i < nProcs; ++i) {
+            offset[i] = offset[i-1] + nmtags[i-1];
+        }
+
+        std::vector<Long> senddata;
+        for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            senddata.push_back(fileNumber);
+            senddata.push_back(hdr.m_fod[mfi.index()].m_head);
+        }
+
+        std::vector<Long> recvdata((myProc == coordinatorProc) ? 2 * mf.size() : 0);
+        ParallelDescriptor::Gatherv(senddata.data(), nmtags[myProc], recvdata.data(),
+                                    nmtags, offset, coordinatorProc);
+
+        if(myProc == coordinatorProc) {
+            Vector<int> cnt(nProcs, 0);
+            for(int j(0), N(mf.size()); j < N; ++j) {
+                const int i(pmap[j]);
+                const Long* fo = recvdata.data() + offset[i] + cnt[i];
+                hdr.m_fod[j].m_name = VisMF::BaseName(NFilesIter::FileName(static_cast<int>(fo[0]),
+                                                                           filePrefix));
+                hdr.m_fod[j].m_head = fo[1];
+                cnt[i] += 2;
+            }
+        }
+    }
+#else
+    amrex::ignore_unused(filePrefix, fileNumber);
+#endif
+
+    if(myProc == coordinatorProc && ! delta.unchanged.empty()) {
+        for(int j(0), N(mf.size()); j < N; ++j) {
+            if(delta.unchanged[j]) {
+                hdr.m_fod[j] = delta.refHdr.m_fod[j];
+            }
+        }
+    }
+}
+
+
+void
+VisMF::SetDeltaReference (const std::string& dir, const std::string& ref_dir)
+{
+    deltaDir = dir;
+    deltaRefDir = ref_dir;
+    for(auto* d : {&deltaDir, &deltaRefDir}) {
+        while(d->size() > 1 && d->back() == '/') {
+            d->pop_back();
+        }
+    }
+}
+
+void
+VisMF::ClearDeltaReference ()
+{
+    deltaDir.clear();
+    deltaRefDir.clear();
+}
+
+
+bool
+VisMF::DeltaPrepare (const FabArray<FArrayBox> &mf,
+                     const std::string &mf_name,
+                     const VisMF::Header &hdr,
+                     VisMF::DeltaInfo &delta)
+{
+    if(deltaDir.empty() || mf_name.compare(0, deltaDir.size() + 1, deltaDir + '/') != 0 ||
+       FArrayBox::getFormat() == FABio::FAB_ASCII ||
+       FArrayBox::getFormat() == FABio::FAB_8BIT)
+    {
+        return false;
+    }
+
+    BL_PROFILE("VisMF::DeltaPrepare()");
+
+    // ---- hash the local FABs, including the ghost cells since they are written
+    delta.hashes.resize(mf.size(), 0);
+    const Vector<int> &index = mf.IndexArray();
+#ifdef AMREX_USE_OMP
+#pragma omp parallel for if (Gpu::notInLaunchRegion())
+#endif
+    for(int li = 0; li < index.size(); ++li) {
+        const FArrayBox &fab = mf[index[li]];
+        Real const* fabdata = fab.dataPtr();
+#ifdef AMREX_USE_GPU
+        std::unique_ptr<FArrayBox> hostfab;
+        if (fab.arena()->isManaged() || fab.arena()->isDevice()) {
+            hostfab = std::make_unique<FArrayBox>(fab.box(), fab.nComp(),
+                                                  The_Pinned_Arena());
+            Gpu::dtoh_memcpy_async(hostfab->dataPtr(), fab.dataPtr(),
+                                   fab.size()*sizeof(Real));
+            Gpu::streamSynchronize();
+            fabdata = hostfab->dataPtr();
+        }
+#endif
+        delta.hashes[index[li]] = hash_bytes(reinterpret_cast<const char*>(fabdata),
+                                             fab.size()*sizeof(Real));
+    }
+
+    if(deltaRefDir.empty()) {
+        return true;
+    }
+
+    // ---- the reference must have been written with the same layout and format
+    const std::string refName(deltaRefDir + mf_name.substr(deltaDir.size()));
+    Vector<char> hashChars, hdrChars;
+    ParallelDescriptor::ReadAndBcastFile(refName + FabHashFileSuffix, hashChars, false);
+    if(hashChars.empty()) {
+        return true;
+    }
+    ParallelDescriptor::ReadAndBcastFile(refName + TheMultiFabHdrFileSuffix, hdrChars, false);
+    if(hdrChars.empty()) {
+        return true;
+    }
+
+    std::istringstream his(hdrChars.dataPtr());
+    his >> delta.refHdr;
+
+    Long nFabs(0);
+    RealDescriptor refRD;
+    std::istringstream hss(hashChars.dataPtr());
+    hss >> nFabs >> refRD >> std::hex;
+
+    const VisMF::Header &ref = delta.refHdr;
+    if( ! his.fail() && ! hss.fail() && nFabs == mf.size() &&
+        refRD == *FArrayBox::getDataDescriptor() &&
+        ref.m_vers == hdr.m_vers && ref.m_ncomp == hdr.m_ncomp &&
+        ref.m_ngrow == hdr.m_ngrow && ref.m_ba == hdr.m_ba)
+    {
+        delta.refHashes.resize(nFabs);
+        for(auto &h : delta.refHashes) {
+            hss >> h;
+        }
+        if( ! hss.fail()) {
+            delta.refName = refName;
+            delta.unchanged.resize(mf.size(), 0);
+            for(int i : index) {
+                delta.unchanged[i] = static_cast<char>(delta.hashes[i] == delta.refHashes[i]);
+            }
+        }
+    }
+
+    return true;
+}
+
+
+void
+VisMF::DeltaFinish (const FabArray<FArrayBox> &mf,
+                    const std::string &mf_name,
+                    VisMF::DeltaInfo &delta,
+                    int coordinatorProc)
+{
+    BL_PROFILE("VisMF::DeltaFinish()");
+
+    const int myProc(ParallelDescriptor::MyProc());
+
+#ifdef BL_USE_MPI
+    if(ParallelDescriptor::NProcs() > 1) {
+        // ---- gather the hashes to the coordinator
+        const int nProcs(ParallelDescriptor::NProcs());
+        const Vector<int> &pmap = mf.DistributionMap().ProcessorMap();
+
+        std::vector<int> nmtags(nProcs, 0), offset(nProcs, 0);
+        for(int i : pmap) {
+            ++nmtags[i];
+        }
+        for(int i(1); i < nProcs; ++i) {
+            offset[i] = offset[i-1] + nmtags[i-1];
+        }
+
+        std::vector<std::uint64_t> senddata;
+        for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            senddata.push_back(delta.hashes[mfi.index()]);
+        }
+
+        std::vector<std::uint64_t> recvdata((myProc == coordinatorProc) ? mf.size() : 0);
+        ParallelDescriptor::Gatherv(senddata.data(), nmtags[myProc], recvdata.data(),
+                                    nmtags, offset, coordinatorProc);
+
+        if(myProc == coordinatorProc) {
+            Vector<int> cnt(nProcs, 0);
+            for(int j(0), N(mf.size()); j < N; ++j) {
+                const int i(pmap[j]);
+                delta.hashes[j] = recvdata[offset[i] + cnt[i]];
+                ++cnt[i];
+            }
+        }
+    }
+#endif
+
+    if(myProc != coordinatorProc) {
+        return;
+    }
+
+    if( ! delta.refName.empty()) {
+        // ---- the unchanged FABs refer to the files of the reference
+        const Vector<std::string> dirParts(path_components(VisMF::DirName(mf_name)));
+        const std::string refDir(VisMF::DirName(delta.refName));
+        Long nUnchanged(0);
+        for(int j(0), N(mf.size()); j < N; ++j) {
+            delta.unchanged[j] = static_cast<char>(delta.hashes[j] == delta.refHashes[j]);
+            if(delta.unchanged[j]) {
+                std::string &name = delta.refHdr.m_fod[j].m_name;
+                name = relative_path(path_components(refDir + name), dirParts);
+                ++nUnchanged;
+            }
+        }
+        if(verbose > 0) {
+            amrex::AllPrint() << "VisMF::Write:  " << nUnchanged << " of " << mf.size()
+                              << " FABs of " << mf_name << " unchanged since "
+                              << delta.refName << '\n';
+        }
+    }
+
+    std::string hashFileName(mf_name + FabHashFileSuffix);
+    std::ofstream hashFile(hashFileName.c_str(), std::ios::out | std::ios::trunc);
+    if( ! hashFile.good()) {
+        amrex::FileOpenFailed(hashFileName);
+    }
+    hashFile << mf.size() << '\n' << *FArrayBox::getDataDescriptor() << '\n' << std::hex;
+    for(auto h : delta.hashes) {
+        hashFile << h << '\n';
+    }
+    if( ! hashFile.good()) {
+        amrex::Error("VisMF::DeltaFinish:  failed to write " + hashFileName);
+    }
+}
+
+
 void
 VisMF::RemoveFiles(const std::string &mf_name, bool a_verbose)
 {
     if(ParallelDescriptor::IOProcessor()) {
       std::string MFHdrFileName(mf_name + TheMultiFabHdrFileSuffix);
+
+      // ---- the data files named in the header, aggregated writes do not
+      // ---- follow the nOutFiles numbering.  names with a directory are
+      // ---- in the reference of a delta write and are not removed
+      std::set<std::string> fileNames;
+      if(amrex::FileExists(MFHdrFileName)) {
+        VisMF::Header hdr;
+        std::ifstream ifs(MFHdrFileName.c_str());
+        ifs >> hdr;
+        for(const auto &fod : hdr.m_fod) {
+          if(fod.m_name.find('/') == std::string::npos) {
+            fileNames.insert(VisMF::DirName(mf_name) + fod.m_name);
+          }
+        }
+      }
+      for(int ip(0); ip < nOutFiles; ++ip) {
+        std::string fileName(NFilesIter::FileName(nOutFiles, mf_name + FabFileSuffix, ip, true));
+        if(amrex::FileExists(fileName)) {
+          fileNames.insert(fileName);
+        }
+      }
+
       if(a_verbose) {
         amrex::Print() << "---- removing:  " << MFHdrFileName << '\n';
       }
@@ -1336,8 +2105,14 @@ VisMF::RemoveFiles(const std::string &mf_name, bool a_verbose)
                     << strerror(errno) << '\n';
         }
       }
-      for(int ip(0); ip < nOutFiles; ++ip) {
-        std::string fileName(NFilesIter::FileName(nOutFiles, mf_name + FabFileSuffix, ip, true));
+      std::string hashFileName(mf_name + FabHashFileSuffix);
+      if(amrex::FileExists(hashFileName)) {
+        if(a_verbose) {
+          amrex::Print() << "---- removing:  " << hashFileName << '\n';
+        }
+        FileSystem::Remove(hashFileName);
+      }
+      for(const auto &fileName : fileNames) {
         if(a_verbose) {
           amrex::Print() << "---- removing:  " << fileName << '\n';
         }
@@ -1396,7 +2171,15 @@ VisMF::readFAB (int                  idx,
     std::ifstream *infs = VisMF::OpenStream(FullName);
     infs->seekg(hdr.m_fod[idx].m_head, std::ios::beg);
 
-    if(hdr.m_vers == Header::Version_v1) {
+    if(Compressed(hdr)) {
+      // ---- only read the chunks of the requested components
+      const int scomp(whichComp == -1 ? 0 : whichComp);
+      const Vector<Long> &chunkOffsets = hdr.m_chunkoffsets[idx];
+      infs->seekg(chunkOffsets[scomp], std::ios::cur);
+      Vector<char> cdata(chunkOffsets[scomp + fab->nComp()] - chunkOffsets[scomp]);
+      infs->read(cdata.data(), static_cast<std::streamsize>(cdata.size()));
+      VisMF::DecompressFAB(*fab, cdata.data(), hdr, idx, scomp);
+    } else if(hdr.m_vers == Header::Version_v1) {
       if(whichComp == -1) {    // ---- read all components
         fab->readFrom(*infs);
       } else {
@@ -1460,7 +2243,11 @@ VisMF::readFAB (FabArray<FArrayBox> &mf,
     std::ifstream *infs = VisMF::OpenStream(FullName);
     infs->seekg(hdr.m_fod[idx].m_head, std::ios::beg);
 
-    if(NoFabHeader(hdr)) {
+    if(Compressed(hdr)) {
+      Vector<char> cdata(hdr.m_chunkoffsets[idx].back());
+      infs->read(cdata.data(), static_cast<std::streamsize>(cdata.size()));
+      VisMF::DecompressFAB(fab, cdata.data(), hdr, idx, 0);
+    } else if(NoFabHeader(hdr)) {
       Real* fabdata = fab.dataPtr();
 #ifdef AMREX_USE_GPU
       std::unique_ptr<FArrayBox> hostfab;
@@ -1490,6 +2277,490 @@ VisMF::readFAB (FabArray<FArrayBox> &mf,
 }
 
 
+namespace {
+    // ---- A quantized chunk starts with this magic number, four unused
+    // ---- bytes and the quantization step, followed by the compressed
+    // ---- integers.
+    constexpr std::uint32_t quantized_magic = 0x51584d41;  // ---- "AMXQ"
+    constexpr std::size_t quantized_header_size = 16;
+
+    // Quantize n values so that the absolute error is at most absError and
+    // compress them into dst.  Return the number of bytes written, or 0 if
+    // a value cannot be quantized or the result does not fit.
+    std::size_t quantize_compress (Real const* src, Long n, Real absError,
+                                   char* dst, std::size_t dst_capacity)
+    {
+        if(dst_capacity <= quantized_header_size) { return 0; }
+        const double step = 2.0 * static_cast<double>(absError);
+        constexpr double qmax = 4.0e18;
+        std::vector<std::int64_t> q(n);
+        for(Long i = 0; i < n; ++i) {
+            const auto x = static_cast<double>(src[i]);
+            const double r = std::nearbyint(x / step);
+            // ---- this also rejects nans and infinities
+            if( ! (std::abs(r) < qmax)) { return 0; }
+            const auto xq = static_cast<double>(static_cast<Real>(r * step));
+            if( ! (std::abs(x - xq) <= static_cast<double>(absError))) { return 0; }
+            q[i] = static_cast<std::int64_t>(r);
+        }
+        const std::uint32_t unused = 0;
+        std::memcpy(dst    , &quantized_magic, 4);
+        std::memcpy(dst + 4, &unused, 4);
+        std::memcpy(dst + 8, &step, 8);
+        const std::size_t zbytes = Compression::compress(q.data(), n * sizeof(std::int64_t),
+                                                         sizeof(std::int64_t),
+                                                         dst + quantized_header_size,
+                                                         dst_capacity - quantized_header_size);
+        return (zbytes > 0) ? zbytes + quantized_header_size : 0;
+    }
+
+    bool is_quantized (char const* src, std::size_t zbytes)
+    {
+        std::uint32_t m = 0;
+        if(zbytes >= quantized_header_size) { std::memcpy(&m, src, 4); }
+        return m == quantized_magic;
+    }
+
+    bool quantized_decompress (char const* src, std::size_t zbytes, Real* dst, Long n)
+    {
+        double step;
+        std::memcpy(&step, src + 8, 8);
+        std::vector<std::int64_t> q(n);
+        if( ! Compression::decompress(src + quantized_header_size, zbytes - quantized_header_size,
+                                      q.data(), n * sizeof(std::int64_t)))
+        {
+            return false;
+        }
+        for(Long i = 0; i < n; ++i) {
+            dst[i] = static_cast<Real>(static_cast<double>(q[i]) * step);
+        }
+        return true;
+    }
+}
+
+Vector<char>
+VisMF::CompressFAB (const FArrayBox     &fab,
+                    const RealDescriptor &rd,
+                    const Vector<Real>   &absError,
+                    Vector<Long>         &chunkOffsets)
+{
+//    BL_PROFILE("VisMF::CompressFAB");
+    const int nComp(fab.nComp());
+    const Long nPts(fab.box().numPts());
+    const auto chunkBytes(static_cast<std::size_t>(nPts * rd.numBytes()));
+    const bool doConvert( ! (rd == FPC::NativeRealDescriptor()));
+
+    Real const* fabdata = fab.dataPtr();
+#ifdef AMREX_USE_GPU
+    std::unique_ptr<FArrayBox> hostfab;
+    if (fab.arena()->isManaged() || fab.arena()->isDevice()) {
+        hostfab = std::make_unique<FArrayBox>(fab.box(), nComp, The_Pinned_Arena());
+        Gpu::dtoh_memcpy_async(hostfab->dataPtr(), fab.dataPtr(), fab.size()*sizeof(Real));
+        Gpu::streamSynchronize();
+        fabdata = hostfab->dataPtr();
+    }
+#endif
+
+    Vector<Vector<char> > chunks(nComp);
+#ifdef AMREX_USE_OMP
+#pragma omp parallel for schedule(dynamic,1)
+#endif
+    for(int n = 0; n < nComp; ++n) {
+        Real const* compdata = fabdata + n * nPts;
+        Vector<char> &chunk = chunks[n];
+        chunk.resize(chunkBytes);
+        if( ! absError.empty() && absError[n] > 0) {
+            const std::size_t qbytes = quantize_compress(compdata, nPts, absError[n],
+                                                         chunk.data(), chunkBytes - 1);
+            if(qbytes > 0) {
+                chunk.resize(qbytes);
+                continue;
+            }
+        }
+        void const* src = compdata;
+        Vector<char> converted;
+        if(doConvert) {
+            converted.resize(chunkBytes);
+            RealDescriptor::convertFromNativeFormat(converted.data(), nPts, compdata, rd);
+            src = converted.data();
+        }
+        // ---- keep the chunk uncompressed unless compression makes it smaller
+        const std::size_t zbytes = Compression::compress(src, chunkBytes, rd.numBytes(),
+                                                         chunk.data(), chunkBytes - 1);
+        if(zbytes > 0) {
+            chunk.resize(zbytes);
+        } else {
+            std::memcpy(chunk.data(), src, chunkBytes);
+        }
+    }
+
+    chunkOffsets.resize(nComp + 1);
+    chunkOffsets[0] = 0;
+    for(int n = 0; n < nComp; ++n) {
+        chunkOffsets[n+1] = chunkOffsets[n] + static_cast<Long>(chunks[n].size());
+    }
+
+    Vector<char> cfab(chunkOffsets[nComp]);
+    for(int n = 0; n < nComp; ++n) {
+        std::memcpy(cfab.data() + chunkOffsets[n], chunks[n].data(), chunks[n].size());
+    }
+    return cfab;
+}
+
+void
+VisMF::DecompressFAB (FArrayBox           &fab,
+                      const char          *src,
+                      const VisMF::Header &hdr,
+                      int                  idx,
+                      int                  scomp)
+{
+//    BL_PROFILE("VisMF::DecompressFAB");
+    const Vector<Long> &chunkOffsets = hdr.m_chunkoffsets[idx];
+    const RealDescriptor &rd = hdr.m_writtenRD;
+    const int nComp(fab.nComp());
+    const Long nPts(fab.box().numPts());
+    const auto chunkBytes(static_cast<std::size_t>(nPts * rd.numBytes()));
+    const bool doConvert( ! (rd == FPC::NativeRealDescriptor()));
+
+    Real* fabdata = fab.dataPtr();
+#ifdef AMREX_USE_GPU
+    std::unique_ptr<FArrayBox> hostfab;
+    if (fab.arena()->isManaged() || fab.arena()->isDevice()) {
+        hostfab = std::make_unique<FArrayBox>(fab.box(), nComp, The_Pinned_Arena());
+        fabdata = hostfab->dataPtr();
+    }
+#endif
+
+    int nBad(0);
+#ifdef AMREX_USE_OMP
+#pragma omp parallel for schedule(dynamic,1) reduction(+:nBad)
+#endif
+    for(int n = 0; n < nComp; ++n) {
+        const char* chunk = src + (chunkOffsets[scomp+n] - chunkOffsets[scomp]);
+        const auto zbytes(static_cast<std::size_t>(chunkOffsets[scomp+n+1] - chunkOffsets[scomp+n]));
+        Real* compdata = fabdata + n * nPts;
+        if(zbytes != chunkBytes && is_quantized(chunk, zbytes)) {
+            if( ! quantized_decompress(chunk, zbytes, compdata, nPts)) {
+                ++nBad;
+            }
+            continue;
+        }
+        void* dst = compdata;
+        Vector<char> converted;
+        if(doConvert) {
+            converted.resize(chunkBytes);
+            dst = converted.data();
+        }
+        if(zbytes == chunkBytes) {    // ---- stored uncompressed
+            std::memcpy(dst, chunk, chunkBytes);
+        } else if( ! Compression::decompress(chunk, zbytes, dst, chunkBytes)) {
+            ++nBad;
+            continue;
+        }
+        if(doConvert) {
+            RealDescriptor::convertToNativeFormat(compdata, nPts, converted.data(), rd);
+        }
+    }
+
+    if(nBad > 0) {
+        amrex::Error("VisMF::DecompressFAB:  invalid compressed data");
+    }
+
+#ifdef AMREX_USE_GPU
+    if (hostfab) {
+        Gpu::htod_memcpy_async(fab.dataPtr(), hostfab->dataPtr(), fab.size()*sizeof(Real));
+        Gpu::streamSynchronize();
+    }
+#endif
+}
+
+namespace {
+    // Upper bound of the length of the header of a FAB.
+    constexpr Long max_fab_header_bytes = 1024;
+
+    // Return the length of the FAB header at p, at most nmax bytes, and set
+    // its RealDescriptor, Box and number of components.  Return -1 if it
+    // is not a header in the new FAB format.
+    Long parse_fab_header (const char* p, Long nmax, RealDescriptor& rd, Box& bx, int& nvar)
+    {
+        const auto* nl = static_cast<const char*>(std::memchr(p, '\n', nmax));
+        if (nl == nullptr) { return -1; }
+        std::istringstream is(std::string(p, nl));
+        char c[4];
+        is >> c[0] >> c[1] >> c[2] >> c[3];
+        if ( ! is.good() || c[0] != 'F' || c[1] != 'A' || c[2] != 'B' || c[3] != '(') {
+            return -1;  // ---- the old FAB format is not supported
+        }
+        is.putback(c[3]);
+        is >> rd >> bx >> nvar;
+        if (is.fail()) { return -1; }
+        return static_cast<Long>(nl - p) + 1;
+    }
+
+#ifndef _WIN32
+    // Return the length of the header at p, at most nmax bytes, if it
+    // describes fab in the native format, and -1 otherwise.
+    Long native_fab_header_length (const char* p, Long nmax, const FArrayBox& fab)
+    {
+        RealDescriptor rd;
+        Box bx;
+        int nvar = -1;
+        const Long hlen = parse_fab_header(p, nmax, rd, bx, nvar);
+        if (hlen < 0 || ! (rd == FPC::NativeRealDescriptor()) ||
+            bx != fab.box() || nvar != fab.nComp())
+        {
+            return -1;
+        }
+        return hlen;
+    }
+#endif
+}
+
+void
+VisMF::readFABRegion (FArrayBox           &dst,
+                      int                  dcomp,
+                      int                  idx,
+                      int                  scomp,
+                      int                  ncomp,
+                      const std::string   &mf_name,
+                      const VisMF::Header &hdr)
+{
+//    BL_PROFILE("VisMF::readFABRegion");
+    AMREX_ASSERT(dst.arena()->isHostAccessible());
+    AMREX_ASSERT(scomp >= 0 && scomp + ncomp <= hdr.m_ncomp && dcomp + ncomp <= dst.nComp());
+
+    const Box region(hdr.m_ba[idx] & dst.box());
+    if(region.isEmpty()) {
+        return;
+    }
+    Box fab_box(hdr.m_ba[idx]);
+    fab_box.grow(hdr.m_ngrow);
+
+    if(Compressed(hdr)) {    // ---- the whole components have to be read
+        const Vector<Long> &chunkOffsets = hdr.m_chunkoffsets[idx];
+        Vector<char> cdata(chunkOffsets[scomp + ncomp] - chunkOffsets[scomp]);
+        std::string FullName(VisMF::DirName(mf_name) + hdr.m_fod[idx].m_name);
+        std::ifstream *infs = VisMF::OpenStream(FullName);
+        infs->seekg(hdr.m_fod[idx].m_head + chunkOffsets[scomp], std::ios::beg);
+        infs->read(cdata.data(), static_cast<std::streamsize>(cdata.size()));
+        VisMF::CloseStream(FullName);
+        FArrayBox fab(fab_box, ncomp, The_Cpu_Arena());
+        VisMF::DecompressFAB(fab, cdata.data(), hdr, idx, scomp);
+        dst.copy<RunOn::Host>(fab, region, 0, region, dcomp, ncomp);
+        return;
+    }
+
+    std::string FullName(VisMF::DirName(mf_name) + hdr.m_fod[idx].m_name);
+    std::ifstream *infs = VisMF::OpenStream(FullName);
+
+    Long dataOffset(hdr.m_fod[idx].m_head);
+    RealDescriptor rd;
+    if(NoFabHeader(hdr)) {
+        rd = hdr.m_writtenRD;
+    } else {
+        // ---- find where the data start from the fab header
+        char fabHeader[max_fab_header_bytes];
+        infs->seekg(dataOffset, std::ios::beg);
+        infs->read(fabHeader, max_fab_header_bytes);
+        const auto nread(static_cast<Long>(infs->gcount()));
+        infs->clear();
+        Box bx;
+        int nvar(-1);
+        const Long hlen = parse_fab_header(fabHeader, nread, rd, bx, nvar);
+        if(hlen < 0 || bx != fab_box || nvar != hdr.m_ncomp) {
+            // ---- the old fab format, read the whole components
+            VisMF::CloseStream(FullName);
+            for(int n = 0; n < ncomp; ++n) {
+                std::unique_ptr<FArrayBox> fab(VisMF::readFAB(idx, mf_name, hdr, scomp + n));
+                dst.copy<RunOn::Host>(*fab, region, 0, region, dcomp + n, 1);
+            }
+            return;
+        }
+        dataOffset += hlen;
+    }
+
+    // ---- read the contiguous byte ranges of the lines of region in
+    // ---- the fab, merging the ones that are adjacent in the file
+    const bool doConvert( ! (rd == FPC::NativeRealDescriptor()));
+    const Long rdBytes(rd.numBytes());
+    const Long lineBytes(region.length(0) * rdBytes);
+    const auto flo = amrex::lbound(fab_box);
+    const auto flen = amrex::length(fab_box);
+    const auto rlo = amrex::lbound(region);
+    const auto rhi = amrex::ubound(region);
+    const Array4<Real> d = dst.array();
+
+    struct Line { int j, k, n; };
+    Vector<Line> lines;
+    Vector<Real> values;
+    Vector<char> converted;
+    Long segStart(0), segBytes(0);
+
+    auto readSegment = [&] ()
+    {
+        if(segBytes == 0) { return; }
+        const Long nItems(segBytes / rdBytes);
+        values.resize(nItems);
+        infs->seekg(segStart, std::ios::beg);
+        if(doConvert) {
+            converted.resize(segBytes);
+            infs->read(converted.data(), segBytes);
+            RealDescriptor::convertToNativeFormat(values.data(), nItems, converted.data(), rd);
+        } else {
+            infs->read(reinterpret_cast<char *>(values.data()), segBytes);
+        }
+        Long v(0);
+        for(const auto& line : lines) {
+            for(int i = rlo.x; i <= rhi.x; ++i) {
+                d(i, line.j, line.k, dcomp + line.n) = values[v++];
+            }
+        }
+        lines.clear();
+        segBytes = 0;
+    };
+
+    for(int n = 0; n < ncomp; ++n) {
+        for(int k = rlo.z; k <= rhi.z; ++k) {
+            for(int j = rlo.y; j <= rhi.y; ++j) {
+                const Long lineStart = dataOffset + rdBytes *
+                    (Long(scomp + n) * fab_box.numPts()
+                     + (Long(k - flo.z) * flen.y + Long(j - flo.y)) * flen.x
+                     + Long(rlo.x - flo.x));
+                if(segBytes > 0 && lineStart != segStart + segBytes) {
+                    readSegment();
+                }
+                if(segBytes == 0) {
+                    segStart = lineStart;
+                }
+                segBytes += lineBytes;
+                lines.push_back(Line{j, k, n});
+            }
+        }
+    }
+    readSegment();
+
+    if( ! infs->good()) {
+        amrex::Error("VisMF::readFABRegion:  failed to read " + FullName);
+    }
+
+    VisMF::CloseStream(FullName);
+}
+
+void
+VisMF::readFABRegion (FArrayBox &dst, int dcomp, int idx, int scomp, int ncomp) const
+{
+    VisMF::readFABRegion(dst, dcomp, idx, scomp, ncomp, m_fafabname, m_hdr);
+}
+
+bool
+VisMF::readFABsMMap (FabArray<FArrayBox> &mf,
+                     const std::string   &mf_name,
+                     const VisMF::Header &hdr)
+{
+#ifdef _WIN32
+    amrex::ignore_unused(mf, mf_name, hdr);
+    return false;
+#else
+    if( ! useMMapReads || mf.boxArray() != hdr.m_ba || mf.nComp() != hdr.m_ncomp ||
+        mf.nGrowVect() != hdr.m_ngrow ||
+        (NoFabHeader(hdr) && ! (hdr.m_writtenRD == FPC::NativeRealDescriptor())))
+    {
+        return false;
+    }
+
+    BL_PROFILE("VisMF::readFABsMMap()");
+
+    const bool compressed(Compressed(hdr));
+    const bool hasFabHeader( ! NoFabHeader(hdr) && ! compressed);
+    const auto pageSize(static_cast<Long>(::sysconf(_SC_PAGESIZE)));
+
+    // ---- [filename, [offset, index]]
+    std::map<std::string, std::map<Long, int> > fabsInFile;
+    for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+      const int idx(mfi.index());
+      fabsInFile[hdr.m_fod[idx].m_name][hdr.m_fod[idx].m_head] = idx;
+    }
+
+    for(auto const& [fileName, fabs] : fabsInFile) {
+      std::string FullName(VisMF::DirName(mf_name) + fileName);
+
+      // ---- map the range of the file with the FABs of this process
+      void* mapPtr(MAP_FAILED);
+      Long mapBegin(0), mapEnd(0);
+      int fd(::open(FullName.c_str(), O_RDONLY));
+      if(fd >= 0) {
+        struct stat st;
+        if(::fstat(fd, &st) == 0) {
+          const int lastIdx(fabs.rbegin()->second);
+          mapBegin = (fabs.begin()->first / pageSize) * pageSize;
+          mapEnd = fabs.rbegin()->first
+                 + (compressed ? hdr.m_chunkoffsets[lastIdx].back()
+                               : static_cast<Long>(mf[lastIdx].nBytes()))
+                 + (hasFabHeader ? max_fab_header_bytes : 0);
+          mapEnd = std::min(mapEnd, static_cast<Long>(st.st_size));
+          if(mapEnd > mapBegin) {
+            mapPtr = ::mmap(nullptr, static_cast<std::size_t>(mapEnd - mapBegin), PROT_READ,
+                            MAP_PRIVATE, fd, static_cast<off_t>(mapBegin));
+          }
+        }
+        ::close(fd);  // ---- the mapping stays valid
+      }
+
+      if(mapPtr == MAP_FAILED) {
+        if(verbose) {
+          amrex::AllPrint() << "VisMF::readFABsMMap:  cannot map " << FullName
+                            << ", reading with streams" << '\n';
+        }
+        for(auto const& kv : fabs) {
+          VisMF::readFAB(mf, kv.second, mf_name, hdr);
+        }
+        continue;
+      }
+
+      const auto mapLength(static_cast<std::size_t>(mapEnd - mapBegin));
+      ::madvise(mapPtr, mapLength, MADV_SEQUENTIAL);
+      ::madvise(mapPtr, mapLength, MADV_WILLNEED);
+      const char* mapData(static_cast<const char*>(mapPtr));
+
+      for(auto const& [offset, idx] : fabs) {
+        FArrayBox& fab = mf[idx];
+        const auto nbytes(compressed ? hdr.m_chunkoffsets[idx].back()
+                                     : static_cast<Long>(fab.nBytes()));
+        Long dataOffset(offset);
+        if(hasFabHeader) {
+          const Long hlen = native_fab_header_length(mapData + (offset - mapBegin),
+                                                     std::min(max_fab_header_bytes,
+                                                              mapEnd - offset),
+                                                     fab);
+          dataOffset = (hlen < 0) ? -1 : offset + hlen;
+        }
+        if(dataOffset < 0 || dataOffset + nbytes > mapEnd) {
+          VisMF::readFAB(mf, idx, mf_name, hdr);
+          continue;
+        }
+        const char* src = mapData + (dataOffset - mapBegin);
+        if(compressed) {
+          VisMF::DecompressFAB(fab, src, hdr, idx, 0);
+          continue;
+        }
+#ifdef AMREX_USE_GPU
+        if( ! fab.arena()->isHostAccessible()) {
+          Gpu::htod_memcpy_async(fab.dataPtr(), src, nbytes);
+          Gpu::streamSynchronize();
+        } else
+#endif
+        {
+          std::memcpy(fab.dataPtr(), src, nbytes);
+        }
+      }
+
+      ::munmap(mapPtr, mapLength);
+    }
+
+    return true;
+#endif
+}
+
 void
 VisMF::Read (FabArray<FArrayBox> &mf,
              const std::string   &mf_name,
@@ -1555,7 +2826,13 @@ VisMF::Read (FabArray<FArrayBox> &mf,
   int nProcs(ParallelDescriptor::NProcs());
   bool noFabHeader(NoFabHeader(hdr));
 
-  if(noFabHeader && useSynchronousReads) {
+  if(VisMF::readFABsMMap(mf, mf_name, hdr)) {
+
+    if(myProc == coordinatorProc && verbose) {
+        amrex::AllPrint() << "VisMF::Read:  read with mmap" << '\n';
+    }
+
+  } else if(noFabHeader && useSynchronousReads) {
 
     // ---- This code is only for reading in file order
     bool doConvert(hdr.m_writtenRD != FPC::NativeRealDescriptor());
@@ -1964,8 +3241,10 @@ VisMF::Read (FabArray<FArrayBox> &mf,
   }
 
 #else
-    for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
-      VisMF::readFAB(mf,mfi.index(), mf_name, hdr);
+    if( ! VisMF::readFABsMMap(mf, mf_name, hdr)) {
+      for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        VisMF::readFAB(mf,mfi.index(), mf_name, hdr);
+      }
     }
 #endif
 
@@ -2151,6 +3430,10 @@ bool VisMF::NoFabHeader(const VisMF::Header &hdr) {
   return false;
 }
 
+bool VisMF::Compressed(const VisMF::Header &hdr) {
+  return hdr.m_vers == VisMF::Header::Compressed_v1;
+}
+
 
 VisMF::PersistentIFStream::~PersistentIFStream()
 {
@@ -2352,29 +3635,42 @@ VisMF::AsyncWriteDoit (const FabArray<FArrayBox>& mf, const std::string& mf_name
     }
 #endif
 
-    auto myfabs = std::make_shared<Vector<FArrayBox> >();
-    for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+    // Host copy of the fab to be written
+    auto stage_fab = [&] (MFIter const& mfi) -> FArrayBox
+    {
         Box bx = strip_ghost ? mfi.validbox() : mfi.fabbox();
 #ifdef AMREX_USE_GPU
         if (data_on_device) {
-            myfabs->emplace_back(bx, mf.nComp(), The_Pinned_Arena());
-            auto& new_fab = myfabs->back();
+            FArrayBox new_fab(bx, mf.nComp(), The_Pinned_Arena());
             if (strip_ghost) {
                 new_fab.copy<RunOn::Device>(mf[mfi], bx);
             } else {
                 Gpu::dtoh_memcpy_async(new_fab.dataPtr(), mf[mfi].dataPtr(), new_fab.size()*sizeof(Real));
             }
+            return new_fab;
         } else
 #endif
         {
             if (is_rvalue && ! strip_ghost) {
-                myfabs->emplace_back(std::move(const_cast<FArrayBox&>(mf[mfi])));
+                return std::move(const_cast<FArrayBox&>(mf[mfi]));
             } else {
-                myfabs->emplace_back(bx, mf.nComp(), The_Cpu_Arena());
-                auto& new_fab = myfabs->back();
+                FArrayBox new_fab(bx, mf.nComp(), The_Cpu_Arena());
                 new_fab.copy<RunOn::Host>(mf[mfi], bx);
+                return new_fab;
             }
         }
+    };
+
+    // With a staging budget, the fabs are copied after the job is submitted
+    // and handed over one by one, so that the copies do not all exist at once.
+    auto myfabs = std::make_shared<Vector<FArrayBox> >();
+    std::shared_ptr<AsyncOut::StagingQueue<FArrayBox> > staging;
+    if (AsyncOut::StagingSize() > 0) {
+        staging = std::make_shared<AsyncOut::StagingQueue<FArrayBox> >();
+    } else {
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            myfabs->emplace_back(stage_fab(mfi));
+        }
     }
 
     std::shared_ptr<FABio> fabio(new FABio_binary(FPC::NativeRealDescriptor().clone()));
@@ -2466,16 +3762,30 @@ VisMF::AsyncWriteDoit (const FabArray<FArrayBox>& mf, const std::string& mf_name
         AsyncOut::Wait();  // Wait for my turn
 
         auto info = AsyncOut::GetWriteInfo(myproc);
-        if (! myfabs->empty()) {
+        if (n_local_fabs > 0) {
             std::string file_name = amrex::Concatenate(mf_name + FabFileSuffix, info.ifile, 5);
             std::ofstream ofs;
             ofs.rdbuf()->pubsetbuf(io_buffer.dataPtr(), io_buffer.size());
             ofs.open(file_name.c_str(), (info.ispot == 0) ? (std::ios::binary | std::ios::trunc)
                                                           : (std::ios::binary | std::ios::app));
             if (!ofs.good()) { amrex::FileOpenFailed(file_name); }
-            for (auto const& fab : *myfabs) {
-                fabio->write_header(ofs, fab, fab.nComp());
-                fabio->write(ofs, fab, 0, fab.nComp());
+            if (staging) {
+                for (int i = 0; i < n_local_fabs; ++i) {
+                    Long nbytes;
+                    {
+                        auto staged = staging->pop();
+                        auto const& fab = staged.first;
+                        nbytes = staged.second;
+                        fabio->write_header(ofs, fab, fab.nComp());
+                        fabio->write(ofs, fab, 0, fab.nComp());
+                    }
+                    AsyncOut::ReleaseStaging(nbytes);
+                }
+            } else {
+                for (auto const& fab : *myfabs) {
+                    fabio->write_header(ofs, fab, fab.nComp());
+                    fabio->write(ofs, fab, 0, fab.nComp());
+                }
             }
             ofs.flush();
             ofs.close();
@@ -2483,6 +3793,23 @@ VisMF::AsyncWriteDoit (const FabArray<FArrayBox>& mf, const std::string& mf_name
 
         AsyncOut::Notify();  // Notify others I am done
     });
+
+    if (staging) {
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            // A fab moved out of an rvalue mf takes no extra memory.
+            Long nbytes = 0;
+            if (! is_rvalue || strip_ghost || data_on_device) {
+                Box bx = strip_ghost ? mfi.validbox() : mfi.fabbox();
+                nbytes = bx.numPts() * ncomp * Long(sizeof(Real));
+            }
+            AsyncOut::AcquireStaging(nbytes);
+            FArrayBox fab = stage_fab(mfi);
+#ifdef AMREX_USE_GPU
+            if (data_on_device) { Gpu::streamSynchronize(); }
+#endif
+            staging->push(std::move(fab), nbytes);
+        }
+    }
 }
 
 }
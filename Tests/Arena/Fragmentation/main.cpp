@@ -0,0 +1,94 @@
+#include <AMReX.H>
+#include <AMReX_CArena.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        // One hunk big enough for everything, so that the layout is known.
+        CArena arena(std::size_t(256)*1024*1024, ArenaInfo{}.SetCpuMemory());
+
+        BoxArray ba(Box(IntVect(0),IntVect(63)));
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+
+        auto mf_old = std::make_unique<MultiFab>(ba, dm, 2, 1, MFInfo().SetArena(&arena));
+        MultiFab mf(ba, dm, 2, 1, MFInfo().SetArena(&arena));
+        mf.setVal(1.0);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            mf[mfi].setVal<RunOn::Host>(Real(mfi.index()), mfi.fabbox(), 1, 1);
+        }
+        const Real sum0 = mf.sum(0, true);
+        const Real sum1 = mf.sum(1, true);
+        // Cache the Array4s, which repack has to rebuild.
+        auto old_arrays = mf.const_arrays();
+        amrex::ignore_unused(old_arrays);
+        const bool has_data = mf.local_size() > 0;
+
+        // Freeing the first MultiFab leaves a hole below the second.
+        mf_old.reset();
+        auto frag = arena.fragmentation();
+        Long nfree = 0;
+        for (auto n : frag.free_histogram) { nfree += n; }
+        if (has_data) {
+            if (frag.largest_free_block >= frag.free_bytes) {
+                amrex::Abort("Fragmentation: there should be a hole below the MultiFab");
+            }
+            if (frag.hunk_occupancy.size() != 1 || frag.nfree_hunks != 0 ||
+                frag.hunk_occupancy[0].second != arena.heap_space_actually_used()) {
+                amrex::Abort("Fragmentation: wrong hunk occupancy");
+            }
+            if (nfree != 2) {
+                amrex::Abort("Fragmentation: wrong number of free blocks");
+            }
+        }
+        if (frag.free_bytes + arena.heap_space_actually_used() != arena.heap_space_used()) {
+            amrex::Abort("Fragmentation: wrong free bytes");
+        }
+        arena.PrintUsage(std::string("Before repack"));
+
+        // Repacking moves the MultiFab into the hole, and the free memory
+        // becomes one block again.
+        Long nbytes = mf.repack();
+        frag = arena.fragmentation();
+        if (has_data && nbytes == 0) {
+            amrex::Abort("Fragmentation: the MultiFab was not moved");
+        }
+        if (frag.largest_free_block != frag.free_bytes) {
+            amrex::Abort("Fragmentation: the free memory is still fragmented");
+        }
+        if (mf.sum(0, true) != sum0 || mf.sum(1, true) != sum1) {
+            amrex::Abort("Fragmentation: wrong data after repack");
+        }
+        auto new_arrays = mf.const_arrays();
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            if (new_arrays[mfi.LocalIndex()].p != mf[mfi].dataPtr()) {
+                amrex::Abort("Fragmentation: stale Array4s after repack");
+            }
+        }
+        ParallelDescriptor::ReduceLongSum(nbytes, ParallelDescriptor::IOProcessorNumber());
+        amrex::Print() << "  Moved " << nbytes << " bytes\n";
+        arena.PrintUsage(std::string("After repack"));
+
+        // An alias does not move the data of mf.
+        {
+            MultiFab alias(mf, amrex::make_alias, 0, mf.nComp());
+            if (alias.repack() != 0 || mf.sum(0, true) != sum0) {
+                amrex::Abort("Fragmentation: an alias was repacked");
+            }
+        }
+
+        // Now the hunk can be released.
+        mf.clear();
+        frag = arena.fragmentation();
+        if ((has_data && (frag.nfree_hunks != 1 || arena.freeUnused() == 0)) ||
+            arena.heap_space_used() != 0) {
+            amrex::Abort("Fragmentation: the unused hunk was not released");
+        }
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,84 @@
+#include <AMReX.H>
+#include <AMReX_CArena.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+// Visit the cells of each FAB with a large stride, so that nearly every
+// access is on a different page like in gathers over large arrays.
+double strided_update (MultiFab& mf, int nrepeat)
+{
+    double t = amrex::second();
+    for (int n = 0; n < nrepeat; ++n) {
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            Real* p = mf[mfi].dataPtr();
+            const auto npts = static_cast<Long>(mf[mfi].size());
+            constexpr Long stride = 5003; // A prime, so that all cells are visited
+            Long m = 0;
+            for (Long i = 0; i < npts; ++i) {
+                p[m] += 0.5;
+                m += stride;
+                if (m >= npts) { m -= npts; }
+            }
+        }
+    }
+    return amrex::second() - t;
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        CArena arena(0, ArenaInfo{}.SetCpuMemory().SetHugePages());
+
+        // Hunks start at a huge page boundary and are a multiple of its size.
+        for (std::size_t nbytes : {std::size_t(100), std::size_t(10*1024*1024+1)}) {
+            void* p = arena.alloc(nbytes);
+            if (!amrex::is_aligned(p, Arena::huge_page_size)) {
+                amrex::Abort("HugePages: a new hunk is not aligned to a huge page");
+            }
+            if (arena.heap_space_used() % Arena::huge_page_size != 0) {
+                amrex::Abort("HugePages: hunks are not a multiple of the huge page size");
+            }
+            arena.free(p);
+        }
+
+        auto usage = arena.hugePageUsage();
+        if (usage.hugetlb_bytes + usage.transparent_bytes + usage.regular_bytes
+            != arena.heap_space_used()) {
+            amrex::Abort("HugePages: wrong huge page usage");
+        }
+        arena.freeUnused();
+        usage = arena.hugePageUsage();
+        if (usage.hugetlb_bytes + usage.transparent_bytes + usage.regular_bytes != 0) {
+            amrex::Abort("HugePages: huge page usage is not zero after freeUnused");
+        }
+
+        BoxArray ba(Box(IntVect(0),IntVect(255)));
+        ba.maxSize(128);
+        DistributionMapping dm(ba);
+
+        CArena plain(0, ArenaInfo{}.SetCpuMemory());
+        MultiFab mf_plain(ba, dm, 1, 0, MFInfo().SetArena(&plain));
+        MultiFab mf_huge(ba, dm, 1, 0, MFInfo().SetArena(&arena));
+        mf_plain.setVal(1.0);
+        mf_huge.setVal(1.0);
+
+        const int nrepeat = 4;
+        double t_plain = strided_update(mf_plain, nrepeat);
+        double t_huge = strided_update(mf_huge, nrepeat);
+        ParallelDescriptor::ReduceRealMax(t_plain);
+        ParallelDescriptor::ReduceRealMax(t_huge);
+
+        amrex::Print() << "  Regular pages: " << t_plain << " s\n"
+                       << "  Huge pages:    " << t_huge << " s\n";
+        arena.PrintUsage(std::string("Huge Page Arena"));
+
+        MultiFab::Subtract(mf_huge, mf_plain, 0, 0, 1, 0);
+        if (mf_huge.norminf(0) != 0.0) {
+            amrex::Abort("HugePages: results differ");
+        }
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,93 @@
+#include <AMReX.H>
+#include <AMReX_CArena.H>
+#include <AMReX_GpuAllocators.H>
+#include <AMReX_PODVector.H>
+#include <AMReX_Print.H>
+#include <AMReX_SArena.H>
+
+#include <cstring>
+#include <random>
+
+using namespace amrex;
+
+// Keep a pool of live blocks of random small sizes and replace random
+// ones, like short-lived descriptors and buffers do.
+double churn (Arena* arena, int nops, bool check)
+{
+    constexpr int nlive = 1000;
+    std::vector<std::pair<char*,std::size_t>> live(nlive, {nullptr,0});
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist_slot(0, nlive-1);
+    std::uniform_int_distribution<int> dist_size(1, 600);
+
+    double t = amrex::second();
+    for (int n = 0; n < nops; ++n) {
+        auto& [p, sz] = live[dist_slot(gen)];
+        if (p) {
+            if (check && (p[0] != static_cast<char>(sz) || p[sz-1] != static_cast<char>(sz))) {
+                amrex::Abort("SArena: a block was overwritten");
+            }
+            arena->free(p);
+        }
+        sz = static_cast<std::size_t>(dist_size(gen));
+        p = static_cast<char*>(arena->alloc(sz));
+        if (check) { std::memset(p, static_cast<int>(sz), sz); }
+    }
+    for (auto const& x : live) {
+        arena->free(x.first);
+    }
+    return amrex::second() - t;
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        SArena sarena;
+        churn(&sarena, 100000, true);
+
+        auto stats = sarena.stats();
+        if (stats.block_bytes != 0 || stats.nalloc != stats.nfree) {
+            amrex::Abort("SArena: blocks are still in use");
+        }
+        if (stats.rounded_bytes < stats.requested_bytes) {
+            amrex::Abort("SArena: wrong rounding statistics");
+        }
+        sarena.freeUnused();
+        stats = sarena.stats();
+        if (stats.slab_bytes != 0 || stats.system_bytes != 0) {
+            amrex::Abort("SArena: slabs are not released by freeUnused");
+        }
+
+        const int nops = 2000000;
+        CArena carena(0, ArenaInfo{}.SetCpuMemory());
+        double t_cpu = churn(The_Cpu_Arena(), nops, false);
+        double t_c = churn(&carena, nops, false);
+        double t_s = churn(&sarena, nops, false);
+        amrex::Print() << "  Cpu Arena time is " << t_cpu << "\n"
+                       << "     CArena time is " << t_c << "\n"
+                       << "     SArena time is " << t_s << "\n";
+
+        // Growing vectors use the slack of the blocks without copying.
+        PODVector<int,PolymorphicArenaAllocator<int>> v;
+        v.setArena(&sarena);
+        int nmoves = 0;
+        const int* pold = nullptr;
+        for (int i = 0; i < 2000; ++i) {
+            v.push_back(i);
+            if (v.data() != pold) {
+                ++nmoves;
+                pold = v.data();
+            }
+        }
+        for (int i = 0; i < 2000; ++i) {
+            if (v[i] != i) {
+                amrex::Abort("SArena: wrong vector content");
+            }
+        }
+        amrex::Print() << "  A vector of 2000 ints moved " << nmoves << " times\n";
+
+        sarena.PrintUsage(std::string("SArena"));
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,128 @@
+#include <AMReX.H>
+#include <AMReX_AsyncOut.H>
+#include <AMReX_Print.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Particles.H>
+
+using namespace amrex;
+
+namespace {
+
+constexpr int NStructReal = 2;
+constexpr int NStructInt  = 1;
+constexpr int NArrayReal  = 2;
+constexpr int NArrayInt   = 1;
+
+using MyPC = ParticleContainer<NStructReal, NStructInt, NArrayReal, NArrayInt>;
+
+AMREX_GPU_HOST_DEVICE ParticleReal rval (Long id, int n)
+{
+    return ParticleReal(id % 100000) + ParticleReal(0.25)*ParticleReal(n);
+}
+
+AMREX_GPU_HOST_DEVICE int ival (Long id, int n)
+{
+    return static_cast<int>(id % 100000) + 1000000*n;
+}
+
+// Set the components of each particle to a function of its id, so that
+// every particle read back can be checked on its own.
+void set_values (MyPC& pc)
+{
+    for (int lev = 0; lev <= pc.finestLevel(); ++lev) {
+        for (MyPC::ParIterType pti(pc, lev); pti.isValid(); ++pti) {
+            const int np = pti.numParticles();
+            auto ptd = pti.GetParticleTile().getParticleTileData();
+            amrex::ParallelFor(np, [=] AMREX_GPU_DEVICE (int ip)
+            {
+                auto& p = ptd.m_aos[ip];
+                const Long id = p.id();
+                for (int n = 0; n < NStructReal; ++n) { p.rdata(n) = rval(id, n); }
+                for (int n = 0; n < NStructInt; ++n) { p.idata(n) = ival(id, n); }
+                for (int n = 0; n < NArrayReal; ++n) {
+                    ptd.m_rdata[n][ip] = rval(id, NStructReal+n);
+                }
+                for (int n = 0; n < NArrayInt; ++n) {
+                    ptd.m_idata[n][ip] = ival(id, NStructInt+n);
+                }
+            });
+        }
+    }
+    Gpu::streamSynchronize();
+}
+
+Long count_errors (MyPC const& pc)
+{
+    using PType = typename MyPC::SuperParticleType;
+    Long nerrors = amrex::ReduceSum(pc,
+        [=] AMREX_GPU_HOST_DEVICE (const PType& p) -> Long
+        {
+            Long r = 0;
+            for (int n = 0; n < NStructReal+NArrayReal; ++n) {
+                if (p.rdata(n) != rval(p.id(), n)) { ++r; }
+            }
+            for (int n = 0; n < NStructInt+NArrayInt; ++n) {
+                if (p.idata(n) != ival(p.id(), n)) { ++r; }
+            }
+            return r;
+        });
+    ParallelDescriptor::ReduceLongSum(nerrors);
+    return nerrors;
+}
+
+void add_parameters ()
+{
+    // The staging budget is smaller than the particles of one grid, so
+    // that the grids are copied and written one at a time.
+    ParmParse pp("amrex");
+    pp.add("async_out", 1);
+    pp.add("async_out_staging_size", 1000);
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv,true,MPI_COMM_WORLD,add_parameters);
+    {
+        int n_cell = 32;
+        int max_grid_size = 8;
+        int nppc = 1;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("nppc", nppc);
+        }
+
+        AMREX_ALWAYS_ASSERT(AsyncOut::StagingSize() > 0);
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        RealBox real_box({AMREX_D_DECL(0.0,0.0,0.0)}, {AMREX_D_DECL(1.0,1.0,1.0)});
+        Array<int,AMREX_SPACEDIM> is_periodic{AMREX_D_DECL(1,1,1)};
+        Geometry geom(domain, real_box, CoordSys::cartesian, is_periodic);
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        MyPC pc(geom, dm, ba);
+        MyPC::ParticleInitData pdata = {{}, {}, {}, {}};
+        pc.InitRandom(Long(nppc)*domain.numPts(), 451, pdata);
+        set_values(pc);
+
+        pc.Checkpoint("async_particles", "particle0");
+        AsyncOut::Finish();
+
+        MyPC newpc(geom, dm, ba);
+        newpc.Restart("async_particles", "particle0");
+
+        const Long np = pc.TotalNumberOfParticles();
+        const Long np_read = newpc.TotalNumberOfParticles();
+        const Long nerrors = count_errors(newpc);
+        amrex::Print() << "Number of particles written and read with staging size "
+                       << AsyncOut::StagingSize() << ": " << np << " " << np_read
+                       << ", number of errors: " << nerrors << "\n";
+        AMREX_ALWAYS_ASSERT(np > 0 && np_read == np && nerrors == 0);
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,106 @@
+#include <AMReX.H>
+#include <AMReX_AsyncOut.H>
+#include <AMReX_Print.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_VisMF.H>
+
+#include <string>
+
+using namespace amrex;
+
+namespace {
+
+Real fval (int i, int j, int k, int n, int m)
+{
+    return Real(i + 100*j + 10000*k + 1000000*n + 10000000*m);
+}
+
+Long count_errors (MultiFab const& mf, int m, bool valid_cells_only)
+{
+    Long nerrors = 0;
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        auto const& a = mf.const_array(mfi);
+        const Box& bx = valid_cells_only ? mfi.validbox() : mfi.fabbox();
+        amrex::LoopOnCpu(bx, mf.nComp(), [&] (int i, int j, int k, int n)
+        {
+            if (a(i,j,k,n) != fval(i,j,k,n,m)) { ++nerrors; }
+        });
+    }
+    ParallelDescriptor::ReduceLongSum(nerrors);
+    return nerrors;
+}
+
+void add_parameters ()
+{
+    // The staging budget is smaller than one FAB, so that the FABs are
+    // copied and written one at a time.
+    ParmParse pp("amrex");
+    pp.add("async_out", 1);
+    pp.add("async_out_staging_size", 1000);
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv,true,MPI_COMM_WORLD,add_parameters);
+    {
+        int n_cell = 32;
+        int max_grid_size = 8;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+        }
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        const int ncomp = 2;
+        const IntVect ng(1);
+        AMREX_ALWAYS_ASSERT(AsyncOut::StagingSize() > 0 &&
+                            AsyncOut::StagingSize() < Long(sizeof(Real))*ncomp*
+                            Box(IntVect(0),IntVect(max_grid_size-1)).numPts());
+
+        // Const and rvalue MultiFabs, with and without ghost cells.
+        const int nwrites = 4;
+        Vector<MultiFab> mfs(nwrites);
+        for (int m = 0; m < nwrites; ++m) {
+            mfs[m].define(ba, dm, ncomp, ng, MFInfo().SetArena(The_Pinned_Arena()));
+            for (MFIter mfi(mfs[m]); mfi.isValid(); ++mfi) {
+                auto const& a = mfs[m].array(mfi);
+                amrex::LoopOnCpu(mfi.fabbox(), ncomp, [&] (int i, int j, int k, int n)
+                {
+                    a(i,j,k,n) = fval(i,j,k,n,m);
+                });
+            }
+        }
+        for (int m = 0; m < nwrites; ++m) {
+            const std::string name = "async_staging_" + std::to_string(m);
+            const bool valid_cells_only = m % 2 != 0;
+            if (m < 2) {
+                VisMF::AsyncWrite(mfs[m], name, valid_cells_only);
+            } else {
+                VisMF::AsyncWrite(std::move(mfs[m]), name, valid_cells_only);
+            }
+        }
+        AsyncOut::Finish();
+
+        Long nerrors = 0;
+        for (int m = 0; m < nwrites; ++m) {
+            const bool valid_cells_only = m % 2 != 0;
+            MultiFab mf(ba, dm, ncomp, valid_cells_only ? IntVect(0) : ng,
+                        MFInfo().SetArena(The_Pinned_Arena()));
+            mf.setVal(-1.0);
+            VisMF::Read(mf, "async_staging_" + std::to_string(m));
+            nerrors += count_errors(mf, m, valid_cells_only);
+        }
+        amrex::Print() << "Number of errors after AsyncWrite with staging size "
+                       << AsyncOut::StagingSize() << ": " << nerrors << "\n";
+        AMREX_ALWAYS_ASSERT(nerrors == 0);
+    }
+    amrex::Finalize();
+}
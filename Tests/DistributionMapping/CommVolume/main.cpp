@@ -0,0 +1,205 @@
+#include <AMReX.H>
+#include <AMReX_Print.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_BoxArray.H>
+#include <AMReX_BoxList.H>
+#include <AMReX_DistributionMapping.H>
+
+#include <array>
+#include <iomanip>
+#include <set>
+#include <utility>
+
+using namespace amrex;
+
+namespace {
+
+struct CommVolume
+{
+    Long ncells = 0;    // ghost cells filled from other processes
+    Long noffnode = 0;  // ghost cells filled from processes on other nodes
+    Long nmsgs  = 0;    // number of pairs of processes exchanging data
+    Long maxcells = 0;  // max over processes of ghost cells received
+    Real efficiency = 0; // load balance efficiency
+};
+
+int node_size = 8;
+
+// Processor map of nprocs virtual processes built by the given strategy
+Vector<int> make_pmap (const BoxArray& ba, int nprocs, DistributionMapping::Strategy strategy)
+{
+    std::vector<std::vector<int>> procs;
+    if (strategy == DistributionMapping::GRAPH) {
+        procs = DistributionMapping::makeGraph(ba, true, nprocs);
+    } else {
+        DistributionMapping::strategy(strategy);
+        procs = DistributionMapping::makeSFC(ba, true, nprocs);
+        DistributionMapping::strategy(DistributionMapping::SFC);
+    }
+    Vector<int> pmap(ba.size(), -1);
+    for (int iproc = 0; iproc < nprocs; ++iproc) {
+        for (int ibox : procs[iproc]) {
+            if (pmap[ibox] != -1) {
+                amrex::Abort("Box "+std::to_string(ibox)+" is assigned twice");
+            }
+            pmap[ibox] = iproc;
+        }
+    }
+    for (int iproc : pmap) {
+        if (iproc < 0) { amrex::Abort("Not all boxes are assigned"); }
+    }
+    return pmap;
+}
+
+CommVolume comm_volume (const BoxArray& ba, Vector<int> const& pmap, int nprocs, int ng)
+{
+    CommVolume r;
+    Vector<Long> recv(nprocs, 0);
+    Vector<Long> work(nprocs, 0);
+    std::set<std::pair<int,int>> pairs;
+    std::vector<std::pair<int,Box>> isects;
+    for (int i = 0, N = static_cast<int>(ba.size()); i < N; ++i) {
+        work[pmap[i]] += ba[i].numPts();
+        ba.intersections(amrex::grow(ba[i],ng), isects);
+        for (auto const& is : isects) {
+            if (pmap[is.first] != pmap[i]) {
+                r.ncells += is.second.numPts();
+                if (pmap[is.first]/node_size != pmap[i]/node_size) {
+                    r.noffnode += is.second.numPts();
+                }
+                recv[pmap[i]] += is.second.numPts();
+                pairs.insert(std::make_pair(pmap[is.first], pmap[i]));
+            }
+        }
+    }
+    r.nmsgs = static_cast<Long>(pairs.size());
+    for (auto n : recv) {
+        r.maxcells = std::max(r.maxcells, n);
+    }
+    Long maxwork = *std::max_element(work.begin(), work.end());
+    r.efficiency = static_cast<Real>(ba.numPts()) / static_cast<Real>(nprocs*maxwork);
+    return r;
+}
+
+// Returns the communication volumes of Morton, Hilbert and Graph
+std::array<CommVolume,3> test (std::string const& name, const BoxArray& ba, int nprocs, int ng)
+{
+    amrex::Print() << "\n" << name << ": " << ba.size() << " boxes, "
+                   << ba.numPts() << " cells, " << nprocs << " processes, "
+                   << node_size << " processes per node, " << ng << " ghost cells\n";
+
+    std::array<std::pair<std::string,DistributionMapping::Strategy>,3> strategies
+        {{ {"Morton", DistributionMapping::SFC},
+           {"Hilbert", DistributionMapping::HILBERT},
+           {"Graph", DistributionMapping::GRAPH} }};
+
+    amrex::Print() << "                   total cells  off-node cells    max cells    messages  efficiency\n";
+    std::array<CommVolume,3> r;
+    Long morton_cells = 1;
+    for (int is = 0; is < 3; ++is) {
+        auto const& [sname, strategy] = strategies[is];
+        auto const& pmap = make_pmap(ba, nprocs, strategy);
+        auto const& cv = r[is] = comm_volume(ba, pmap, nprocs, ng);
+        if (strategy == DistributionMapping::SFC) {
+            morton_cells = std::max(cv.ncells, Long(1));
+        }
+        amrex::Print() << "    " << std::left << std::setw(10) << sname << std::right
+                       << std::setw(16) << cv.ncells << std::setw(16) << cv.noffnode
+                       << std::setw(13) << cv.maxcells << std::setw(12) << cv.nmsgs
+                       << std::setw(12) << std::setprecision(4) << cv.efficiency
+                       << "    (" << static_cast<double>(cv.ncells)/static_cast<double>(morton_cells)
+                       << " of Morton)\n";
+    }
+    return r;
+}
+
+}
+
+void add_parameters ()
+{
+    // Pretend there are nodes for the GRAPH strategy, unless specified otherwise.
+    ParmParse pp("DistributionMapping");
+    if (!pp.contains("node_size")) {
+        pp.add("node_size", node_size);
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv,true,MPI_COMM_WORLD,add_parameters);
+    {
+        int n_cell = 256;
+        int max_grid_size = 32;
+        int nprocs = 48;
+        int ng = 1;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("nprocs", nprocs);
+            pp.query("ng", ng);
+        }
+        {
+            ParmParse pp("DistributionMapping");
+            pp.query("node_size", node_size);
+            AMREX_ALWAYS_ASSERT(node_size > 0);
+        }
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        auto cv = test("Uniform domain", ba, nprocs, ng);
+        // Hilbert chunks have less surface than Morton chunks.  On the
+        // uniform domain, the boundaries between the nodes happen to favor
+        // Morton, so only the total is compared.
+        AMREX_ALWAYS_ASSERT(cv[1].ncells <= cv[0].ncells);
+        // Graph keeps the heavy edges on the nodes.
+        AMREX_ALWAYS_ASSERT(cv[2].noffnode <= cv[0].noffnode);
+
+        // Boxes covering a ball, like a refined level
+        BoxList bl;
+        const auto center = domain.length() / 2;
+        const auto radius = static_cast<Real>(n_cell)*Real(0.4);
+        for (int i = 0; i < ba.size(); ++i) {
+            const Box& bx = ba[i];
+            const IntVect ctr = bx.smallEnd() + bx.length()/2 - center;
+            Real d2 = 0;
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                d2 += static_cast<Real>(ctr[idim])*static_cast<Real>(ctr[idim]);
+            }
+            if (d2 < radius*radius) {
+                bl.push_back(ba[i]);
+            }
+        }
+        BoxArray ba2(std::move(bl));
+        ba2.maxSize(max_grid_size/2);
+        cv = test("Ball", ba2, nprocs, ng);
+        AMREX_ALWAYS_ASSERT(cv[1].ncells <= cv[0].ncells);
+        AMREX_ALWAYS_ASSERT(cv[1].noffnode <= cv[0].noffnode);
+        AMREX_ALWAYS_ASSERT(cv[2].noffnode <= cv[0].noffnode);
+
+        // Weighted paths with the real processes
+        DistributionMapping::strategy(DistributionMapping::HILBERT);
+        Vector<Real> cost(ba2.size());
+        for (int i = 0; i < ba2.size(); ++i) {
+            cost[i] = static_cast<Real>(ba2[i].numPts()*(1+i%3));
+        }
+        Real eff = 0;
+        DistributionMapping dm = DistributionMapping::makeSFC(cost, ba2, eff);
+        AMREX_ALWAYS_ASSERT(dm.size() == ba2.size());
+        for (int i = 0; i < ba2.size(); ++i) {
+            AMREX_ALWAYS_ASSERT(dm[i] >= 0 && dm[i] < ParallelDescriptor::NProcs());
+        }
+        amrex::Print() << "\nWeighted Hilbert distribution on " << ParallelDescriptor::NProcs()
+                       << " processes: efficiency = " << eff << "\n";
+        DistributionMapping::strategy(DistributionMapping::SFC);
+
+        DistributionMapping dm2 = DistributionMapping::makeGraph(cost, ba2);
+        AMREX_ALWAYS_ASSERT(dm2.size() == ba2.size());
+        for (int i = 0; i < ba2.size(); ++i) {
+            AMREX_ALWAYS_ASSERT(dm2[i] >= 0 && dm2[i] < ParallelDescriptor::NProcs());
+        }
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,107 @@
+#include <AMReX.H>
+#include <AMReX_Print.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_LayoutData.H>
+#include <AMReX_DistributionMapping.H>
+
+using namespace amrex;
+
+namespace {
+
+AMREX_GPU_HOST_DEVICE AMREX_FORCE_INLINE
+Real fval (int i, int j, int k, int n)
+{
+    return Real(i) + Real(1000)*Real(j) + Real(1.e6)*Real(k) + Real(0.5)*Real(n);
+}
+
+Real moved_fraction (const BoxArray& ba, const DistributionMapping& dm1,
+                     const DistributionMapping& dm2)
+{
+    Long moved = 0;
+    for (int i = 0; i < ba.size(); ++i) {
+        if (dm1[i] != dm2[i]) { moved += ba[i].numPts(); }
+    }
+    return static_cast<Real>(moved) / static_cast<Real>(ba.numPts());
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int n_cell = 128;
+        int max_grid_size = 16;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+        }
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        const int ncomp = 2;
+        const IntVect ng(2);
+        MultiFab mf(ba, dm, ncomp, ng);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            auto const& a = mf.array(mfi);
+            amrex::ParallelFor(mfi.fabbox(), ncomp, [=] AMREX_GPU_DEVICE (int i, int j, int k, int n)
+            {
+                a(i,j,k,n) = fval(i,j,k,n);
+            });
+        }
+
+        // The boxes in one corner of the domain become more expensive.
+        LayoutData<Real> cost(ba, dm);
+        for (MFIter mfi(cost); mfi.isValid(); ++mfi) {
+            const Box& bx = mfi.validbox();
+            Real c = static_cast<Real>(bx.numPts());
+            if (bx.smallEnd(0) < n_cell/4 && bx.smallEnd(1) < n_cell/2) {
+                c *= Real(3.0);
+            }
+            cost[mfi] = c;
+        }
+
+        Real knapsack_eff0 = 0, knapsack_eff = 0;
+        auto knapsack_dm = DistributionMapping::makeKnapSack(cost, knapsack_eff0, knapsack_eff);
+        amrex::Print() << "KnapSack: efficiency " << knapsack_eff0 << " -> " << knapsack_eff
+                       << ", fraction of data moved " << moved_fraction(ba, dm, knapsack_dm)
+                       << "\n";
+
+        DistributionMapping newdm;
+        Real last_fraction = 2;
+        for (Real w : {Real(0.0), Real(0.2), Real(1.0), Real(5.0)}) {
+            Real eff0 = 0, eff = 0, fraction = 0;
+            auto rdm = DistributionMapping::makeRebalance(cost, w, eff0, eff, &fraction);
+            amrex::Print() << "Rebalance with migration weight " << w << ": efficiency "
+                           << eff0 << " -> " << eff << ", fraction of data moved "
+                           << fraction << "\n";
+            AMREX_ALWAYS_ASSERT(eff >= eff0);
+            AMREX_ALWAYS_ASSERT(fraction <= last_fraction);
+            AMREX_ALWAYS_ASSERT(std::abs(fraction - moved_fraction(ba, dm, rdm)) < Real(1.e-10));
+            last_fraction = fraction;
+            if (w == Real(0.0)) { newdm = rdm; }
+        }
+
+        mf.Redistribute(newdm);
+        AMREX_ALWAYS_ASSERT(mf.DistributionMap() == newdm && mf.nGrowVect() == ng);
+
+        Long nerrors = 0;
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            auto const& a = mf.const_array(mfi);
+            const Box& bx = mfi.fabbox();
+            amrex::LoopOnCpu(bx, ncomp, [&] (int i, int j, int k, int n)
+            {
+                if (a(i,j,k,n) != fval(i,j,k,n)) { ++nerrors; }
+            });
+        }
+        ParallelDescriptor::ReduceLongSum(nerrors);
+        amrex::Print() << "Number of errors after Redistribute: " << nerrors << "\n";
+        AMREX_ALWAYS_ASSERT(nerrors == 0);
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,114 @@
+#include <AMReX.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+#include <FabArrayCommTest.H>
+
+using namespace amrex;
+
+bool withinBudget ()
+{
+    bool r = FabArrayBase::cacheBytes() <= FabArrayBase::cache_max_bytes;
+    ParallelDescriptor::ReduceBoolAnd(r);
+    return r;
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        Box domain(IntVect(0), IntVect(63));
+        Geometry geom(domain, RealBox(AMREX_D_DECL(0.,0.,0.),AMREX_D_DECL(1.,1.,1.)),
+                      CoordSys::cartesian, {AMREX_D_DECL(1,1,1)});
+
+        Vector<MultiFab> mfs;
+        for (int max_size : {16, 8, 32, 24}) {
+            BoxArray ba(domain);
+            ba.maxSize(max_size);
+            mfs.emplace_back(ba, DistributionMapping(ba), 2, 1);
+        }
+
+        // The budget allows the largest of the FB entries.
+        Vector<MultiFab> refs;
+        Long budget = 0;
+        for (auto const& mf : mfs) {
+            refs.emplace_back(mf.boxArray(), mf.DistributionMap(), 2, 1);
+            fill(refs.back());
+            const Long nbytes = FabArrayBase::cacheBytes();
+            refs.back().FillBoundary(geom.periodicity());
+            budget = std::max(budget, FabArrayBase::cacheBytes() - nbytes);
+        }
+        ParallelDescriptor::ReduceLongMax(budget);
+        FabArrayBase::flushFBCache();
+        FabArrayBase::cache_max_bytes = budget;
+
+        const auto& stats = FabArrayBase::m_FBC_stats;
+        const bool use_persistent_comm = FabArrayBase::use_persistent_comm;
+        int nerrors = 0;
+
+        // Without plans, the entries are evicted as new ones are built.
+        FabArrayBase::use_persistent_comm = false;
+        Long nevict = stats.nevict;
+        for (int i = 0; i < 2; ++i) {
+            for (auto& mf : mfs) {
+                fill(mf);
+                mf.FillBoundary(geom.periodicity());
+            }
+        }
+        nevict = stats.nevict - nevict;
+        ParallelDescriptor::ReduceLongSum(nevict);
+        amrex::Print() << "Without plans: " << nevict << " evictions\n";
+        if (nevict == 0 || !withinBudget()) {
+            amrex::Print() << "The FB cache is not kept within the budget\n";
+            ++nerrors;
+        }
+
+        // The entries owning persistent or neighborhood plans are only
+        // evicted by trimCaches.
+        const auto engine = FabArrayBase::comm_engine;
+        for (bool neighbor : {false, true}) {
+            FabArrayBase::use_persistent_comm = !neighbor;
+            FabArrayBase::comm_engine = neighbor ? FabArrayBase::CommEngine::Neighbor
+                                                 : FabArrayBase::CommEngine::PointToPoint;
+            for (int i = 0; i < 2; ++i) {
+                for (auto& mf : mfs) {
+                    fill(mf);
+                    mf.FillBoundary(geom.periodicity());
+                }
+            }
+            nevict = stats.nevict;
+            const int size = stats.size;
+            FabArrayBase::trimCaches();
+            amrex::Print() << "trimCaches evicted " << stats.nevict - nevict << " of "
+                           << size << " FB entries on the I/O process\n";
+            if (!withinBudget()) {
+                amrex::Print() << "trimCaches does not keep the FB cache within the budget\n";
+                ++nerrors;
+            }
+            if (stats.size != size - (stats.nevict - nevict)) {
+                amrex::Print() << "The FB cache statistics are inconsistent\n";
+                ++nerrors;
+            }
+
+            // The evicted entries are rebuilt.
+            for (int i = 0; i < static_cast<int>(mfs.size()); ++i) {
+                fill(mfs[i]);
+                mfs[i].FillBoundary(geom.periodicity());
+                if (maxdiff(mfs[i], refs[i]) != Real(0)) {
+                    amrex::Print() << "FillBoundary " << i << " differs after eviction\n";
+                    ++nerrors;
+                }
+            }
+        }
+        FabArrayBase::comm_engine = engine;
+        FabArrayBase::printCacheStats(&amrex::OutStream());
+
+        FabArrayBase::use_persistent_comm = use_persistent_comm;
+        FabArrayBase::cache_max_bytes = 0;
+
+        AMREX_ALWAYS_ASSERT(nerrors == 0);
+        amrex::Print() << "The FB cache stays within fabarray.cache_max_bytes\n";
+    }
+    amrex::Finalize();
+}
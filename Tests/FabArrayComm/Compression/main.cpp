@@ -0,0 +1,165 @@
+#include <AMReX.H>
+#include <AMReX_Compression.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+#include <FabArrayCommTest.H>
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace amrex;
+
+namespace {
+
+std::vector<unsigned char> smooth_doubles (std::size_t nbytes)
+{
+    std::vector<unsigned char> r(nbytes);
+    const std::size_t n = nbytes / sizeof(double);
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto x = static_cast<double>(i);
+        const double v = 1.0 + 1.e-3*x + 1.e-7*x*x;
+        std::memcpy(r.data()+i*sizeof(double), &v, sizeof(double));
+    }
+    return r;
+}
+
+std::vector<unsigned char> random_bytes (std::size_t nbytes)
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::vector<unsigned char> r(nbytes);
+    for (auto& c : r) { c = static_cast<unsigned char>(dist(gen)); }
+    return r;
+}
+
+// Compress and decompress the data, and check that they are unchanged
+// and that corrupted input is rejected.  Return the number of errors.
+int round_trip (std::string const& name, std::vector<unsigned char> const& src,
+                std::size_t elem_size, bool compressible)
+{
+    int nerrors = 0;
+    const std::size_t nbytes = src.size();
+    std::vector<unsigned char> z(2*nbytes + 2*Compression::header_size + 64);
+    std::vector<unsigned char> out(nbytes+1, 0xab);
+
+    const std::size_t zbytes = Compression::compress(src.data(), nbytes, elem_size,
+                                                     z.data(), z.size());
+    if (zbytes == 0) {
+        amrex::Print() << name << ": compress fails with a large buffer\n";
+        return 1;
+    }
+    if (!Compression::decompress(z.data(), zbytes, out.data(), nbytes)) {
+        amrex::Print() << name << ": decompress fails\n";
+        ++nerrors;
+    } else if (std::memcmp(out.data(), src.data(), nbytes) != 0 || out[nbytes] != 0xab) {
+        amrex::Print() << name << ": round trip differs\n";
+        ++nerrors;
+    }
+
+    if (Compression::decompress(z.data(), zbytes, out.data(), nbytes+1)) {
+        amrex::Print() << name << ": decompress accepts the wrong size\n";
+        ++nerrors;
+    }
+    if (Compression::decompress(z.data(), zbytes-1, out.data(), nbytes)) {
+        amrex::Print() << name << ": decompress accepts truncated data\n";
+        ++nerrors;
+    }
+
+    // Only accept results smaller than the original data.
+    if (nbytes > 0) {
+        const std::size_t zsmall = Compression::compress(src.data(), nbytes, elem_size,
+                                                         z.data(), nbytes-1);
+        if (compressible && (zsmall == 0 || zsmall >= nbytes)) {
+            amrex::Print() << name << ": data are not compressed\n";
+            ++nerrors;
+        } else if (!compressible && zsmall != 0) {
+            amrex::Print() << name << ": incompressible data fit in " << zsmall << " bytes\n";
+            ++nerrors;
+        }
+    }
+    return nerrors;
+}
+
+void exchange (bool compress, Geometry const& geom, MultiFab& mf, MultiFab& dst)
+{
+    FabArrayBase::comm_compress = compress;
+    ::exchange(geom, mf, dst);
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int nerrors = 0;
+
+        for (std::size_t nbytes : {0, 1, 2, 3, 7, 8, 9, 1000, 65536, 100003}) {
+            for (std::size_t elem_size : {1, 2, 3, 4, 8}) {
+                const std::string suffix = " of " + std::to_string(nbytes)
+                    + " bytes with elements of " + std::to_string(elem_size) + " bytes";
+                const bool large = nbytes >= 1000;
+                nerrors += round_trip("Zeros"+suffix, std::vector<unsigned char>(nbytes, 0),
+                                      elem_size, large);
+                nerrors += round_trip("Smooth data"+suffix, smooth_doubles(nbytes),
+                                      elem_size, large && elem_size == sizeof(double));
+                nerrors += round_trip("Random data"+suffix, random_bytes(nbytes),
+                                      elem_size, false);
+            }
+        }
+        amrex::Print() << "Compression round trips: " << nerrors << " errors\n";
+
+        // Compressed messages give the same results as uncompressed ones.
+        Box domain(IntVect(0), IntVect(63));
+        Geometry geom(domain, RealBox(AMREX_D_DECL(0.,0.,0.),AMREX_D_DECL(1.,1.,1.)),
+                      CoordSys::cartesian, {AMREX_D_DECL(1,1,1)});
+        BoxArray ba(domain);
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+        BoxArray ba2(domain);
+        ba2.maxSize(20);
+        DistributionMapping dm2(ba2);
+
+        const bool comm_compress = FabArrayBase::comm_compress;
+        const Long comm_compress_threshold = FabArrayBase::comm_compress_threshold;
+        FabArrayBase::comm_compress_threshold = 0;
+
+        MultiFab mf_ref(ba, dm, 2, 2);
+        MultiFab dst_ref(ba2, dm2, 2, 1);
+        exchange(false, geom, mf_ref, dst_ref);
+
+        MultiFab mf(ba, dm, 2, 2);
+        MultiFab dst(ba2, dm2, 2, 1);
+        exchange(true, geom, mf, dst);
+
+        if (maxdiff(mf, mf_ref) != Real(0)) {
+            amrex::Print() << "Compressed FillBoundary differs\n";
+            ++nerrors;
+        }
+        if (maxdiff(dst, dst_ref) != Real(0)) {
+            amrex::Print() << "Compressed ParallelCopy differs\n";
+            ++nerrors;
+        }
+
+        Long ncompressed[2] = {FabArrayBase::m_FB_compress_stats.ncompressed,
+                               FabArrayBase::m_PC_compress_stats.ncompressed};
+        ParallelDescriptor::ReduceLongSum(ncompressed, 2);
+        amrex::Print() << "Compressed messages: " << ncompressed[0] << " FillBoundary, "
+                       << ncompressed[1] << " ParallelCopy\n";
+        if (ParallelDescriptor::NProcs() > 1 && (ncompressed[0] == 0 || ncompressed[1] == 0)) {
+            amrex::Print() << "No message is compressed\n";
+            ++nerrors;
+        }
+
+        FabArrayBase::comm_compress = comm_compress;
+        FabArrayBase::comm_compress_threshold = comm_compress_threshold;
+
+        AMREX_ALWAYS_ASSERT(nerrors == 0);
+        amrex::Print() << "Compression is lossless\n";
+    }
+    amrex::Finalize();
+}
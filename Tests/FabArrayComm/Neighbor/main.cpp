@@ -0,0 +1,73 @@
+#include <AMReX.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+#include <FabArrayCommTest.H>
+
+using namespace amrex;
+
+// The exchange of FabArrayCommTest.H with the given engine.
+void exchange (FabArrayBase::CommEngine engine, Geometry const& geom,
+               MultiFab& mf, MultiFab& dst)
+{
+    FabArrayBase::comm_engine = engine;
+    exchange(geom, mf, dst);
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        Box domain(IntVect(0), IntVect(63));
+        Geometry geom(domain, RealBox(AMREX_D_DECL(0.,0.,0.),AMREX_D_DECL(1.,1.,1.)),
+                      CoordSys::cartesian, {AMREX_D_DECL(1,1,1)});
+
+        const auto engine = FabArrayBase::comm_engine;
+        int nerrors = 0;
+        // The last layouts are exchanged with a cap on the graph
+        // communicators, so that some of them fall back to point-to-point.
+        for (int max_size : {16, 32, 8, 24}) {
+#ifdef AMREX_USE_MPI
+            if (max_size == 8) {
+                FabArrayBase::neighbor_comm_max = FabArrayBase::numNeighborComms();
+            }
+#endif
+            BoxArray ba(domain);
+            ba.maxSize(max_size);
+            DistributionMapping dm(ba);
+            BoxArray ba2(domain);
+            ba2.maxSize(max_size+4);
+            DistributionMapping dm2(ba2);
+
+            MultiFab mf_ref(ba, dm, 2, 2);
+            MultiFab dst_ref(ba2, dm2, 2, 1);
+            exchange(FabArrayBase::CommEngine::PointToPoint, geom, mf_ref, dst_ref);
+
+            MultiFab mf(ba, dm, 2, 2);
+            MultiFab dst(ba2, dm2, 2, 1);
+            exchange(FabArrayBase::CommEngine::Neighbor, geom, mf, dst);
+            // Again with the cached plans.
+            exchange(FabArrayBase::CommEngine::Neighbor, geom, mf, dst);
+
+            if (maxdiff(mf, mf_ref) != Real(0)) {
+                amrex::Print() << "Neighbor FillBoundary differs for max_size " << max_size << "\n";
+                ++nerrors;
+            }
+            if (maxdiff(dst, dst_ref) != Real(0)) {
+                amrex::Print() << "Neighbor ParallelCopy differs for max_size " << max_size << "\n";
+                ++nerrors;
+            }
+#ifdef AMREX_USE_MPI
+            amrex::Print() << "max_size " << max_size << ": "
+                           << FabArrayBase::numNeighborComms() << " graph communicators\n";
+            AMREX_ALWAYS_ASSERT(FabArrayBase::numNeighborComms() <= FabArrayBase::neighbor_comm_max);
+#endif
+        }
+        FabArrayBase::comm_engine = engine;
+
+        AMREX_ALWAYS_ASSERT(nerrors == 0);
+        amrex::Print() << "The neighbor engine matches point-to-point\n";
+    }
+    amrex::Finalize();
+}
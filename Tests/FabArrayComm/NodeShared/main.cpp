@@ -0,0 +1,83 @@
+#include <AMReX.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+#include <FabArrayCommTest.H>
+
+using namespace amrex;
+
+// A periodic FillBoundary on mf, then a ParallelCopy from mf into the
+// ghost cells and valid cells of dst.  With nowait, the valid cells of mf
+// are overwritten between the _nowait and _finish calls, which must not
+// change the results.
+void exchange (Geometry const& geom, MultiFab& mf, MultiFab& dst, bool nowait)
+{
+    const int ncomp = mf.nComp();
+    fill(mf);
+    if (nowait) {
+        mf.FillBoundary_nowait(geom.periodicity());
+        mf.setVal(-3.0, 0, ncomp, 0);
+        mf.FillBoundary_finish();
+        fill_valid(mf);
+    } else {
+        mf.FillBoundary(geom.periodicity());
+    }
+
+    dst.setVal(-2.0);
+    if (nowait) {
+        dst.ParallelCopy_nowait(mf, 0, 0, ncomp, IntVect(0), dst.nGrowVect(), geom.periodicity());
+        mf.setVal(-3.0, 0, ncomp, 0);
+        dst.ParallelCopy_finish();
+        fill_valid(mf);
+    } else {
+        dst.ParallelCopy(mf, 0, 0, ncomp, IntVect(0), dst.nGrowVect(), geom.periodicity());
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        Box domain(IntVect(0), IntVect(63));
+        Geometry geom(domain, RealBox(AMREX_D_DECL(0.,0.,0.),AMREX_D_DECL(1.,1.,1.)),
+                      CoordSys::cartesian, {AMREX_D_DECL(1,1,1)});
+
+        int nerrors = 0;
+        for (int max_size : {16, 32}) {
+            BoxArray ba(domain);
+            ba.maxSize(max_size);
+            DistributionMapping dm(ba);
+            BoxArray ba2(domain);
+            ba2.maxSize(max_size+4);
+            DistributionMapping dm2(ba2);
+
+            MultiFab mf_ref(ba, dm, 2, 2);
+            MultiFab dst_ref(ba2, dm2, 2, 1);
+            exchange(geom, mf_ref, dst_ref, false);
+
+            MultiFab mf(ba, dm, 2, 2, MFInfo().SetNodeShared(true));
+            MultiFab dst(ba2, dm2, 2, 1, MFInfo().SetNodeShared(true));
+#if defined(AMREX_USE_MPI) && !defined(AMREX_USE_GPU)
+            AMREX_ALWAYS_ASSERT(mf.isNodeShared() == (ParallelDescriptor::NProcs() > 1));
+#endif
+            for (bool nowait : {false, true}) {
+                exchange(geom, mf, dst, nowait);
+                if (maxdiff(mf, mf_ref) != Real(0)) {
+                    amrex::Print() << "Node shared FillBoundary differs for max_size " << max_size
+                                   << (nowait ? " with nowait\n" : "\n");
+                    ++nerrors;
+                }
+                if (maxdiff(dst, dst_ref) != Real(0)) {
+                    amrex::Print() << "Node shared ParallelCopy differs for max_size " << max_size
+                                   << (nowait ? " with nowait\n" : "\n");
+                    ++nerrors;
+                }
+            }
+        }
+
+        AMREX_ALWAYS_ASSERT(nerrors == 0);
+        amrex::Print() << "Node shared memory matches the messages\n";
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,82 @@
+#include <AMReX.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+#include <FabArrayCommTest.H>
+
+using namespace amrex;
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        Box domain(IntVect(0), IntVect(63));
+        Geometry geom(domain, RealBox(AMREX_D_DECL(0.,0.,0.),AMREX_D_DECL(1.,1.,1.)),
+                      CoordSys::cartesian, {AMREX_D_DECL(1,1,1)});
+        BoxArray ba(domain);
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+
+        // Each call is repeated so that the cached persistent plan is
+        // reused, and the components change so that it is rebuilt.
+        const std::vector<std::pair<int,int>> comps{{0,3}, {0,3}, {1,2}, {1,2}, {0,1}, {0,3}};
+
+        const int ncomp = 3;
+        const int nghost = 2;
+        MultiFab ref(ba, dm, ncomp, nghost);
+        MultiFab mf(ba, dm, ncomp, nghost);
+
+        const bool use_persistent_comm = FabArrayBase::use_persistent_comm;
+        int nerrors = 0;
+        for (auto const& [scomp, nc] : comps) {
+            FabArrayBase::use_persistent_comm = false;
+            fill(ref);
+            ref.FillBoundary(scomp, nc, geom.periodicity());
+
+            FabArrayBase::use_persistent_comm = true;
+            fill(mf);
+            mf.FillBoundary(scomp, nc, geom.periodicity());
+
+            if (maxdiff(mf, ref) != Real(0)) {
+                amrex::Print() << "Persistent FillBoundary of components " << scomp
+                               << " to " << scomp+nc-1 << " differs\n";
+                ++nerrors;
+            }
+        }
+
+        // Overlapping calls on a FabArray whose boxes are all on process 0,
+        // so that the other processes have no work.  The plan must still be
+        // kept active on all of them, or the later plans would be built
+        // with different tags on different processes.
+        {
+            BoxArray ba0(domain);
+            ba0.maxSize(32);
+            DistributionMapping dm0(Vector<int>(ba0.size(), 0));
+            MultiFab a(ba0, dm0, ncomp, nghost);
+            MultiFab b(ba0, dm0, ncomp, nghost);
+            fill(a);
+            fill(b);
+            a.FillBoundary_nowait(0, ncomp, geom.periodicity());
+            b.FillBoundary_nowait(0, 1, geom.periodicity());
+            a.FillBoundary_finish();
+            b.FillBoundary_finish();
+        }
+
+        FabArrayBase::use_persistent_comm = false;
+        fill(ref);
+        ref.FillBoundary(geom.periodicity());
+        FabArrayBase::use_persistent_comm = true;
+        fill(mf);
+        mf.FillBoundary(geom.periodicity());
+        if (maxdiff(mf, ref) != Real(0)) {
+            amrex::Print() << "Persistent FillBoundary after overlapping calls differs\n";
+            ++nerrors;
+        }
+        FabArrayBase::use_persistent_comm = use_persistent_comm;
+
+        AMREX_ALWAYS_ASSERT(nerrors == 0);
+        amrex::Print() << "Persistent FillBoundary matches the default path\n";
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,106 @@
+#include <AMReX.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_iMultiFab.H>
+#include <AMReX_MFSplitIter.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+#include <FabArrayCommTest.H>
+
+using namespace amrex;
+
+// The sum of the cell and its 2*AMREX_SPACEDIM neighbors.
+void stencil (Box const& bx, Array4<Real const> const& a, Array4<Real> const& r, int ncomp)
+{
+    ParallelFor(bx, ncomp, [=] AMREX_GPU_DEVICE (int i, int j, int k, int n)
+    {
+        r(i,j,k,n) = a(i,j,k,n)
+            AMREX_D_TERM(+ a(i-1,j,k,n) + a(i+1,j,k,n),
+                         + a(i,j-1,k,n) + a(i,j+1,k,n),
+                         + a(i,j,k-1,n) + a(i,j,k+1,n));
+    });
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        Box domain(IntVect(0), IntVect(63));
+        Geometry geom(domain, RealBox(AMREX_D_DECL(0.,0.,0.),AMREX_D_DECL(1.,1.,1.)),
+                      CoordSys::cartesian, {AMREX_D_DECL(1,1,1)});
+        BoxArray ba(domain);
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+
+        const int ncomp = 2;
+        MultiFab mf(ba, dm, ncomp, 1);
+        MultiFab ref(ba, dm, ncomp, 0);
+        MultiFab res(ba, dm, ncomp, 0);
+        iMultiFab visits(ba, dm, 1, 0);
+
+        fill(mf);
+        mf.FillBoundary(geom.periodicity());
+#ifdef AMREX_USE_OMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+        for (MFIter mfi(mf, TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+            stencil(mfi.tilebox(), mf.const_array(mfi), ref.array(mfi), ncomp);
+        }
+
+        // The second pass runs without a FillBoundary in progress, so that
+        // every box is visited in the first phase.
+        int nerrors = 0;
+        for (bool nowait : {true, false}) {
+            fill(mf);
+            res.setVal(-1.0);
+            visits.setVal(0);
+            if (nowait) {
+                mf.FillBoundary_nowait(geom.periodicity());
+            } else {
+                mf.FillBoundary(geom.periodicity());
+            }
+            Long ninterior = 0;
+#ifdef AMREX_USE_OMP
+#pragma omp parallel if (Gpu::notInLaunchRegion()) reduction(+:ninterior)
+#endif
+            for (MFSplitIter mfi(mf, 1, MFItInfo().EnableTiling()); mfi.isValid(); ++mfi) {
+                const Box& bx = mfi.tilebox();
+                AMREX_ALWAYS_ASSERT(mfi.isInterior() || !mf.fbd);
+                if (mfi.isInterior()) { ninterior += bx.numPts(); }
+                stencil(bx, mf.const_array(mfi), res.array(mfi), ncomp);
+                auto const& v = visits.array(mfi);
+                ParallelFor(bx, [=] AMREX_GPU_DEVICE (int i, int j, int k)
+                {
+                    v(i,j,k) += 1;
+                });
+            }
+            Gpu::streamSynchronize();
+            AMREX_ALWAYS_ASSERT(!mf.fbd);
+
+            if (visits.min(0) != 1 || visits.max(0) != 1) {
+                amrex::Print() << "MFSplitIter does not visit every cell once (nowait "
+                               << nowait << ")\n";
+                ++nerrors;
+            }
+            MultiFab::Subtract(res, ref, 0, 0, ncomp, 0);
+            for (int n = 0; n < ncomp; ++n) {
+                if (res.norminf(n) != Real(0)) {
+                    amrex::Print() << "MFSplitIter stencil of component " << n
+                                   << " differs (nowait " << nowait << ")\n";
+                    ++nerrors;
+                }
+            }
+            ParallelDescriptor::ReduceLongSum(ninterior);
+            amrex::Print() << "nowait " << nowait << ": " << ninterior << " of "
+                           << ba.numPts() << " cells visited in the interior phase\n";
+            if (!nowait && ninterior != ba.numPts()) {
+                amrex::Print() << "MFSplitIter without FillBoundary in progress has a boundary phase\n";
+                ++nerrors;
+            }
+        }
+
+        AMREX_ALWAYS_ASSERT(nerrors == 0);
+        amrex::Print() << "MFSplitIter matches the non-split loop\n";
+    }
+    amrex::Finalize();
+}
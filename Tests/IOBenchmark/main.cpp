@@ -0,0 +1,334 @@
+#include <AMReX.H>
+#include <AMReX_AsyncOut.H>
+#include <AMReX_FileSystem.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Particles.H>
+#include <AMReX_Print.H>
+#include <AMReX_Utility.H>
+#include <AMReX_VisMF.H>
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+using namespace amrex;
+
+namespace {
+
+struct Timing
+{
+    Real time = 0.0;       // wall time until all processes are done
+    Real imbalance = 1.0;  // max over mean of the time of each process
+};
+
+template <typename F>
+Timing timed (F&& f)
+{
+    ParallelDescriptor::Barrier();
+    const Real t0 = amrex::second();
+    f();
+    Real tlocal = amrex::second() - t0;
+    ParallelDescriptor::Barrier();
+    Real ttotal = amrex::second() - t0;
+
+    Real tmax = tlocal;
+    Real tsum = tlocal;
+    ParallelDescriptor::ReduceRealMax(tmax);
+    ParallelDescriptor::ReduceRealSum(tsum);
+    ParallelDescriptor::ReduceRealMax(ttotal);
+
+    Timing r;
+    r.time = ttotal;
+    if (tsum > 0.0) {
+        r.imbalance = tmax / (tsum / ParallelDescriptor::NProcs());
+    }
+    return r;
+}
+
+struct Row
+{
+    std::string type;
+    std::string how = "-";
+    int nfiles = 0;
+    int version = 0;
+    int async = 0;
+    int rep = 0;
+    Real mbytes = 0.0;
+    Real write_time = 0.0;
+    Real return_time = 0.0;
+    Real meta_time = 0.0;
+    Real read_time = 0.0;
+    Real imbalance = 1.0;
+
+    static std::string header ()
+    {
+        return "type,how,nfiles,version,async,nprocs,rep,mbytes,write_s,write_mbps,"
+               "return_s,meta_s,read_s,read_mbps,imbalance";
+    }
+
+    [[nodiscard]] std::string str () const
+    {
+        std::ostringstream os;
+        os << type << ',' << how << ',' << nfiles << ',' << version << ',' << async << ','
+           << ParallelDescriptor::NProcs() << ',' << rep << ',' << mbytes << ','
+           << write_time << ',' << (write_time > 0.0 ? mbytes/write_time : 0.0) << ','
+           << return_time << ',' << meta_time << ',' << read_time << ','
+           << (read_time > 0.0 ? mbytes/read_time : 0.0) << ',' << imbalance;
+        return os.str();
+    }
+};
+
+void remove_output (std::string const& path, bool keep_files)
+{
+    ParallelDescriptor::Barrier();
+    if (!keep_files && ParallelDescriptor::IOProcessor() && FileSystem::Exists(path)) {
+        FileSystem::RemoveAll(path);
+    }
+    ParallelDescriptor::Barrier();
+}
+
+void create_directory (std::string const& path)
+{
+    if (ParallelDescriptor::IOProcessor()) {
+        if (!amrex::UtilCreateDirectory(path, 0755)) {
+            amrex::CreateDirectoryFailed(path);
+        }
+    }
+    ParallelDescriptor::Barrier();
+}
+
+}
+
+void test ();
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    test();
+    amrex::Finalize();
+}
+
+void test ()
+{
+    int n_cell = 64;
+    int max_grid_size = 32;
+    int ncomp = 4;
+    int nppc = 1;
+    int nrepeat = 1;
+    int read = 1;
+    int keep_files = 0;
+    std::string directory = ".";
+    std::string results_file;
+    Vector<std::string> hows{"NFiles"};
+    Vector<int> nfiles{1};
+    Vector<int> versions{VisMF::GetHeaderVersion()};
+    Vector<int> asyncs{0};
+    Vector<int> particle_nfiles{1};
+    Vector<int> particle_checkpoint{1};
+    {
+        ParmParse pp;
+        pp.query("n_cell", n_cell);
+        pp.query("max_grid_size", max_grid_size);
+        pp.query("ncomp", ncomp);
+        pp.query("nppc", nppc);
+        pp.query("nrepeat", nrepeat);
+        pp.query("read", read);
+        pp.query("keep_files", keep_files);
+        pp.query("directory", directory);
+        pp.query("results_file", results_file);
+        pp.queryarr("how", hows);
+        pp.queryarr("nfiles", nfiles);
+        pp.queryarr("headerversion", versions);
+        pp.queryarr("async", asyncs);
+        pp.queryarr("particle_nfiles", particle_nfiles);
+        pp.queryarr("particle_checkpoint", particle_checkpoint);
+    }
+    if (!directory.empty() && directory.back() != '/') {
+        directory += '/';
+    }
+
+    Box domain(IntVect(0), IntVect(n_cell-1));
+    BoxArray ba(domain);
+    ba.maxSize(max_grid_size);
+    DistributionMapping dm(ba);
+
+    MultiFab mf(ba, dm, ncomp, 0);
+    auto const& ma = mf.arrays();
+    amrex::ParallelFor(mf, IntVect(0), ncomp,
+    [=] AMREX_GPU_DEVICE (int b, int i, int j, int k, int n)
+    {
+        ma[b](i,j,k,n) = std::sin(Real(0.1)*Real(i+n)) * std::cos(Real(0.05)*Real(j))
+            + Real(0.01)*Real(k);
+    });
+    Gpu::streamSynchronize();
+
+    const Real mf_mbytes = Real(ba.numPts()) * ncomp * sizeof(Real) / Real(1.e6);
+
+    Vector<Row> rows;
+    auto report = [&] (Row const& row)
+    {
+        rows.push_back(row);
+        amrex::Print() << row.str() << '\n';
+    };
+
+    amrex::Print() << Row::header() << '\n';
+
+    const auto version0 = VisMF::GetHeaderVersion();
+    const int nfiles0 = VisMF::GetNOutFiles();
+
+    // ---- MultiFab
+    const std::string mf_dir = directory + "iobenchmark_mf";
+    for (int rep = 0; rep < nrepeat; ++rep) {
+    for (int async : asyncs) {
+        if (async && !AsyncOut::UseAsyncOut()) {
+            amrex::Print() << "# async = 1 skipped, it needs amrex.async_out = 1\n";
+            continue;
+        }
+        // VisMF::AsyncWrite always writes version 1 to amrex.async_out_nfiles files.
+        const Vector<std::string> how_list = async ? Vector<std::string>{"-"} : hows;
+        const Vector<int> nfiles_list = async ? Vector<int>{0} : nfiles;
+        const Vector<int> version_list = async ? Vector<int>{VisMF::Header::Version_v1} : versions;
+        for (auto const& how_name : how_list) {
+        for (int nf : nfiles_list) {
+        for (int version : version_list) {
+            Row row;
+            row.type = "multifab";
+            row.how = how_name;
+            row.nfiles = nf;
+            row.version = version;
+            row.async = async;
+            row.rep = rep;
+            row.mbytes = mf_mbytes;
+
+            VisMF::How how = VisMF::NFiles;
+            if (how_name == "OneFilePerCPU") {
+                how = VisMF::OneFilePerCPU;
+            } else if (how_name != "NFiles" && how_name != "-") {
+                amrex::Abort("IOBenchmark: unknown how " + how_name);
+            }
+            if (!async) {
+                VisMF::SetNOutFiles(nf);
+                VisMF::SetHeaderVersion(static_cast<VisMF::Header::Version>(version));
+            }
+
+            remove_output(mf_dir, false);
+            const std::string name = mf_dir + "/mf";
+
+            // ---- the directory and a header without data
+            row.meta_time = timed([&] () {
+                create_directory(mf_dir);
+                VisMF::WriteOnlyHeader(mf, mf_dir + "/header_only", how);
+            }).time;
+
+            if (async) {
+                Real return_time = 0.0;
+                Timing t = timed([&] () {
+                    const Real t0 = amrex::second();
+                    VisMF::AsyncWrite(mf, name);
+                    return_time = amrex::second() - t0;
+                    AsyncOut::Finish();
+                });
+                ParallelDescriptor::ReduceRealMax(return_time);
+                row.write_time = t.time;
+                row.return_time = return_time;
+                row.imbalance = t.imbalance;
+            } else {
+                Timing t = timed([&] () { VisMF::Write(mf, name, how); });
+                row.write_time = t.time;
+                row.return_time = t.time;
+                row.imbalance = t.imbalance;
+            }
+
+            if (read) {
+                MultiFab mf_read(ba, dm, ncomp, 0);
+                row.read_time = timed([&] () { VisMF::Read(mf_read, name); }).time;
+            }
+
+            report(row);
+        }}}
+    }}
+    remove_output(mf_dir, keep_files);
+
+    VisMF::SetHeaderVersion(version0);
+    VisMF::SetNOutFiles(nfiles0);
+
+    // ---- particles
+    if (nppc > 0) {
+        RealBox real_box;
+        for (int n = 0; n < AMREX_SPACEDIM; n++) {
+            real_box.setLo(n, 0.0);
+            real_box.setHi(n, 1.0);
+        }
+        Array<int,AMREX_SPACEDIM> is_per{AMREX_D_DECL(1,1,1)};
+        Geometry geom(domain, real_box, CoordSys::cartesian, is_per);
+
+        constexpr int NStructReal = 2;
+        constexpr int NStructInt  = 1;
+        constexpr int NArrayReal  = 2;
+        constexpr int NArrayInt   = 1;
+        using MyPC = ParticleContainer<NStructReal, NStructInt, NArrayReal, NArrayInt>;
+
+        MyPC pc(geom, dm, ba);
+        MyPC::ParticleInitData pdata = {{1.0, 2.0}, {3}, {4.0, 5.0}, {6}};
+        pc.InitRandom(Long(nppc) * ba.numPts(), 451, pdata, false);
+
+        const Long np = pc.TotalNumberOfParticles();
+        const Real particle_mbytes = Real(np) *
+            ((AMREX_SPACEDIM + NStructReal + NArrayReal) * sizeof(ParticleReal)
+             + (2 + NStructInt + NArrayInt) * sizeof(int)) / Real(1.e6);
+
+        const std::string p_dir = directory + "iobenchmark_particles";
+        ParmParse pp("particles");
+        for (int rep = 0; rep < nrepeat; ++rep) {
+        for (int nf : particle_nfiles) {
+        for (int checkpoint : particle_checkpoint) {
+            Row row;
+            row.type = checkpoint ? "particle_checkpoint" : "particle_plotfile";
+            row.nfiles = nf;
+            row.async = AsyncOut::UseAsyncOut();
+            row.rep = rep;
+            row.mbytes = particle_mbytes;
+
+            pp.remove("particles_nfiles");
+            pp.add("particles_nfiles", nf);
+
+            remove_output(p_dir, false);
+
+            row.meta_time = timed([&] () { create_directory(p_dir); }).time;
+
+            Real return_time = 0.0;
+            Timing t = timed([&] () {
+                const Real t0 = amrex::second();
+                if (checkpoint) {
+                    pc.Checkpoint(p_dir, "particles");
+                } else {
+                    pc.WritePlotFile(p_dir, "particles");
+                }
+                return_time = amrex::second() - t0;
+                AsyncOut::Finish();
+            });
+            ParallelDescriptor::ReduceRealMax(return_time);
+            row.write_time = t.time;
+            row.return_time = return_time;
+            row.imbalance = t.imbalance;
+
+            if (read && checkpoint) {
+                MyPC pc_read(geom, dm, ba);
+                row.read_time = timed([&] () { pc_read.Restart(p_dir, "particles"); }).time;
+                AMREX_ALWAYS_ASSERT(pc_read.TotalNumberOfParticles() == np);
+            }
+
+            report(row);
+        }}}
+        remove_output(p_dir, keep_files);
+    }
+
+    if (!results_file.empty() && ParallelDescriptor::IOProcessor()) {
+        std::ofstream ofs(results_file);
+        if (!ofs.good()) { amrex::FileOpenFailed(results_file); }
+        ofs << Row::header() << '\n';
+        for (auto const& row : rows) {
+            ofs << row.str() << '\n';
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_NArena.H>
+#include <AMReX_OpenMP.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        amrex::Print() << "Number of NUMA domains: " << NUMA::NumDomains() << "\n";
+
+        NArena arena;
+
+        BoxArray ba(Box(IntVect(0),IntVect(63)));
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+
+        MultiFab mf(ba, dm, 2, 1, MFInfo().SetArena(&arena));
+        mf.setVal(1.0);
+
+        // The FABs are placed on the domain of the thread that works on their middle tile.
+        auto const owner = mf.staticOwnerThreads(OpenMP::get_max_threads());
+        int nmatch = 0;
+#ifdef AMREX_USE_OMP
+#pragma omp parallel reduction(+:nmatch)
+#endif
+        for (MFIter mfi(mf, true); mfi.isValid(); ++mfi) {
+            if (mfi.LocalTileIndex() == mfi.numLocalTiles()/2) {
+                if (owner[mfi.LocalIndex()] == OpenMP::get_thread_num()) { ++nmatch; }
+            }
+        }
+        amrex::Print() << nmatch << " of " << mf.local_size() << " FABs assigned to the expected thread\n";
+        AMREX_ALWAYS_ASSERT(nmatch == mf.local_size());
+
+        std::size_t used = 0;
+        for (int d = 0; d < arena.numDomains(); ++d) {
+            used += arena.heap_space_actually_used(d);
+        }
+        std::size_t nbytes = 0;
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            nbytes += mf[mfi].nBytes();
+        }
+        AMREX_ALWAYS_ASSERT(used >= nbytes);
+
+        arena.PrintUsage("NArena");
+        AMREX_ALWAYS_ASSERT(mf.sum(0) == Real(ba.numPts()));
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,147 @@
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_OpenMP.H>
+#include <AMReX_Print.H>
+#include <AMReX_TCArena.H>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace amrex;
+
+// Allocate a temporary FArrayBox for each tile like many OpenMP kernels do.
+void tile_scratch (MultiFab& mf, Arena* arena)
+{
+#ifdef AMREX_USE_OMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(mf,true); mfi.isValid(); ++mfi) {
+        Box const& tbx = mfi.growntilebox();
+        FArrayBox tmp(tbx, 2, arena);
+        tmp.template setVal<RunOn::Host>(0.1, tbx, 0, 1);
+        tmp.template setVal<RunOn::Host>(0.2, tbx, 1, 1);
+        mf[mfi].template plus<RunOn::Host>(tmp, tbx, tbx, 0, 0, 1);
+        mf[mfi].template plus<RunOn::Host>(tmp, tbx, tbx, 1, 0, 1);
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        BoxArray ba(Box(IntVect(0),IntVect(127)));
+        ba.maxSize(32);
+        DistributionMapping dm(ba);
+
+        MultiFab mf(ba,dm,1,1);
+        mf.setVal(0.0);
+
+        const int nrepeat = 10;
+        CArena carena(0, ArenaInfo{}.SetCpuMemory());
+        TCArena tcarena(0, ArenaInfo{}.SetCpuMemory());
+
+        double t = amrex::second();
+        for (int i = 0; i < nrepeat; ++i) {
+            tile_scratch(mf, &carena);
+        }
+        double t_c = amrex::second() - t;
+
+        t = amrex::second();
+        for (int i = 0; i < nrepeat; ++i) {
+            tile_scratch(mf, &tcarena);
+        }
+        double t_tc = amrex::second() - t;
+
+        auto stats = tcarena.cacheStats();
+        amrex::Print() << "   CArena time is " << t_c << ", "
+                       << carena.numLocks() << " locks, "
+                       << carena.numContendedLocks() << " contended\n"
+                       << "  TCArena time is " << t_tc << ", "
+                       << tcarena.numLocks() << " locks, "
+                       << tcarena.numContendedLocks() << " contended, "
+                       << stats.nhits << " of " << stats.nalloc << " allocations from the caches\n";
+
+        AMREX_ALWAYS_ASSERT(amrex::almostEqual(mf.min(0), Real(2*nrepeat)*Real(0.3), 10));
+        AMREX_ALWAYS_ASSERT(amrex::almostEqual(mf.max(0), Real(2*nrepeat)*Real(0.3), 10));
+
+        tcarena.freeUnused();
+        AMREX_ALWAYS_ASSERT(tcarena.heap_space_actually_used() == 0);
+        AMREX_ALWAYS_ASSERT(tcarena.heap_space_used() == 0);
+
+        // Small caches: big blocks are freed at once, the bins stay within
+        // thread_bytes, and the first allocation after the parallel region
+        // empties the lists of freed blocks.
+        const std::size_t thread_bytes = 64*1024;
+        TCArena small(0, ArenaInfo{}.SetCpuMemory(), 16*1024, thread_bytes);
+        const int nblocks = 200;
+#ifdef AMREX_USE_OMP
+#pragma omp parallel
+#endif
+        {
+            std::vector<void*> blocks;
+            for (int i = 0; i < nblocks; ++i) {
+                blocks.push_back(small.alloc(std::size_t(16)*(1 + (i*37)%1000)));
+            }
+            for (auto* p : blocks) {
+                small.free(p);
+            }
+            void* big = small.alloc(100*1024);
+            small.free(big);
+        }
+        auto small_stats = small.cacheStats();
+        amrex::Print() << "  Small TCArena: " << small_stats.nfree << " deferred and "
+                       << small_stats.nfree_direct << " direct frees, "
+                       << small_stats.cached_bytes << " bytes cached\n";
+        void* p = small.alloc(8);
+        small.free(p);
+        small_stats = small.cacheStats();
+        AMREX_ALWAYS_ASSERT(small.heap_space_actually_used() ==
+                            static_cast<std::size_t>(small_stats.cached_bytes));
+#ifdef AMREX_USE_OMP
+        const auto nthreads = static_cast<Long>(OpenMP::get_max_threads());
+        AMREX_ALWAYS_ASSERT(small_stats.nfree == nthreads*nblocks &&
+                            small_stats.nfree_direct == nthreads);
+        AMREX_ALWAYS_ASSERT(small_stats.cached_bytes <= nthreads*Long(thread_bytes));
+#endif
+        small.freeUnused();
+        AMREX_ALWAYS_ASSERT(small.heap_space_actually_used() == 0);
+
+        // Another thread allocates and frees while a parallel region uses
+        // the caches.  It must not empty the lists of the OpenMP threads.
+        std::atomic<bool> done{false};
+        std::atomic<int> nbad{0};
+        std::thread other([&] () {
+            while (!done.load()) {
+                auto* q = static_cast<int*>(small.alloc(sizeof(int)*64));
+                for (int i = 0; i < 64; ++i) { q[i] = i; }
+                for (int i = 0; i < 64; ++i) { if (q[i] != i) { ++nbad; } }
+                small.free(q);
+            }
+        });
+        for (int irepeat = 0; irepeat < nrepeat; ++irepeat) {
+#ifdef AMREX_USE_OMP
+#pragma omp parallel
+#endif
+            {
+                const int tid = OpenMP::get_thread_num();
+                std::vector<int*> blocks;
+                for (int i = 0; i < nblocks; ++i) {
+                    auto* q = static_cast<int*>(small.alloc(sizeof(int)*(1 + i%100)));
+                    *q = tid*nblocks + i;
+                    blocks.push_back(q);
+                }
+                for (int i = 0; i < nblocks; ++i) {
+                    if (*blocks[i] != tid*nblocks + i) { ++nbad; }
+                    small.free(blocks[i]);
+                }
+            }
+        }
+        done = true;
+        other.join();
+        AMREX_ALWAYS_ASSERT(nbad == 0);
+        small.freeUnused();
+        AMREX_ALWAYS_ASSERT(small.heap_space_actually_used() == 0);
+    }
+    amrex::Finalize();
+}
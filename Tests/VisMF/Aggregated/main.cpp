@@ -0,0 +1,114 @@
+#include <AMReX.H>
+#include <AMReX_Print.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_NFiles.H>
+#include <AMReX_Utility.H>
+#include <AMReX_VisMF.H>
+
+#include <VisMFTest.H>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+using namespace amrex;
+
+namespace {
+
+// The number of data files, which must be numbered from zero without gaps.
+int count_files (std::string const& name)
+{
+    int nfiles = 0;
+    bool gaps = false;
+    for (int i = 0; i < ParallelDescriptor::NProcs(); ++i) {
+        if (amrex::FileExists(NFilesIter::FileName(i, name + "_D_"))) {
+            gaps = gaps || nfiles < i;
+            ++nfiles;
+        }
+    }
+    return gaps ? -1 : nfiles;
+}
+
+void add_parameters ()
+{
+    // Two aggregators per node writing in pieces smaller than a FAB.
+    ParmParse pp("vismf");
+    pp.add("aggregatewrites", 1);
+    pp.add("aggregatorspernode", 2);
+    pp.add("aggregatestripesize", 4096);
+    pp.add("aggregatebuffersize", 10000);
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv,true,MPI_COMM_WORLD,add_parameters);
+    {
+        int n_cell = 48;
+        int max_grid_size = 12;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+        }
+
+        // Fewer output files than aggregators, so that RemoveFiles must
+        // find the files in the header.
+        const int noutfiles = VisMF::GetNOutFiles();
+        VisMF::SetNOutFiles(1);
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        const int ncomp = 3;
+        const IntVect ng(1);
+        MultiFab mf(ba, dm, ncomp, ng, MFInfo().SetArena(The_Pinned_Arena()));
+        fill(mf);
+
+        // The FABs are read by other processes than the ones that wrote them.
+        Vector<int> pmap = dm.ProcessorMap();
+        std::reverse(pmap.begin(), pmap.end());
+        DistributionMapping dm2(std::move(pmap));
+        MultiFab ref(ba, dm2, ncomp, ng, MFInfo().SetArena(The_Pinned_Arena()));
+        ref.ParallelCopy(mf, 0, 0, ncomp, ng, ng);
+
+        const auto version = VisMF::GetHeaderVersion();
+        for (auto hv : {VisMF::Header::Version_v1, VisMF::Header::NoFabHeader_v1,
+                        VisMF::Header::Compressed_v1})
+        {
+            const std::string name = "vismf_aggregated_" + std::to_string(int(hv));
+            VisMF::SetHeaderVersion(hv);
+            VisMF::Write(mf, name);
+
+            MultiFab mf2(ba, dm2, ncomp, ng, MFInfo().SetArena(The_Pinned_Arena()));
+            mf2.setVal(0.0);
+            VisMF::Read(mf2, name);
+            const Long nerrors = count_errors(mf2, ref);
+            amrex::Print() << "Header version " << int(hv)
+                           << ": number of errors after aggregated writes: " << nerrors << "\n";
+            AMREX_ALWAYS_ASSERT(nerrors == 0);
+
+            if (ParallelDescriptor::IOProcessor()) {
+                const int nfiles = count_files(name);
+                amrex::Print() << "Header version " << int(hv) << ": " << nfiles
+                               << " data files written\n";
+                AMREX_ALWAYS_ASSERT(nfiles > 0);
+            }
+            ParallelDescriptor::Barrier();
+
+            VisMF::RemoveFiles(name);
+            if (ParallelDescriptor::IOProcessor()) {
+                AMREX_ALWAYS_ASSERT(count_files(name) == 0 &&
+                                    !amrex::FileExists(name + "_H"));
+            }
+            ParallelDescriptor::Barrier();
+        }
+        VisMF::SetHeaderVersion(version);
+        VisMF::SetNOutFiles(noutfiles);
+    }
+    amrex::Finalize();
+}
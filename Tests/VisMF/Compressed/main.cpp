@@ -0,0 +1,112 @@
+#include <AMReX.H>
+#include <AMReX_Print.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_VisMF.H>
+
+#include <VisMFTest.H>
+
+using namespace amrex;
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int n_cell = 64;
+        int max_grid_size = 32;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+        }
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        const int ncomp = 3;
+        const IntVect ng(1);
+        MultiFab mf(ba, dm, ncomp, ng, MFInfo().SetArena(The_Pinned_Arena()));
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            auto const& a = mf.array(mfi);
+            amrex::LoopOnCpu(mfi.fabbox(), ncomp, [&] (int i, int j, int k, int n)
+            {
+                // The last component is noise that does not compress.
+                a(i,j,k,n) = (n == ncomp-1) ? amrex::Random() : fval(i,j,k,n);
+            });
+        }
+
+        const auto version = VisMF::GetHeaderVersion();
+
+        VisMF::SetHeaderVersion(VisMF::Header::NoFabHeader_v1);
+        Long raw_bytes = VisMF::Write(mf, "vismf_raw");
+
+        VisMF::SetHeaderVersion(VisMF::Header::Compressed_v1);
+        Long compressed_bytes = VisMF::Write(mf, "vismf_compressed");
+
+        VisMF::SetHeaderVersion(version);
+
+        ParallelDescriptor::ReduceLongSum(raw_bytes);
+        ParallelDescriptor::ReduceLongSum(compressed_bytes);
+
+        amrex::Print() << "Bytes written: uncompressed " << raw_bytes
+                       << ", compressed " << compressed_bytes << "\n";
+        AMREX_ALWAYS_ASSERT(compressed_bytes < raw_bytes);
+
+        MultiFab mf2(ba, dm, ncomp, ng, MFInfo().SetArena(The_Pinned_Arena()));
+        mf2.setVal(0.0);
+        VisMF::Read(mf2, "vismf_compressed");
+        Long nerrors = count_errors(mf2, mf);
+        amrex::Print() << "Number of errors after VisMF::Read: " << nerrors << "\n";
+        AMREX_ALWAYS_ASSERT(nerrors == 0);
+
+        // Read single components through the chunk offsets.
+        VisMF vismf("vismf_compressed");
+        for (int n = 0; n < ncomp; ++n) {
+            MultiFab mfn(ba, dm, 1, ng, MFInfo().SetArena(The_Pinned_Arena()));
+            for (MFIter mfi(mfn); mfi.isValid(); ++mfi) {
+                mfn[mfi].copy<RunOn::Host>(vismf.GetFab(mfi.index(), n));
+                vismf.clear(mfi.index(), n);
+            }
+            MultiFab refn(mf, amrex::make_alias, n, 1);
+            nerrors = count_errors(mfn, refn);
+            amrex::Print() << "Number of errors reading component " << n << ": " << nerrors << "\n";
+            AMREX_ALWAYS_ASSERT(nerrors == 0);
+        }
+
+        // Read a region of two components of every grid.
+        for (auto const* name : {"vismf_raw", "vismf_compressed"}) {
+            VisMF vismf_region(name);
+            for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+                const Box region = amrex::grow(mfi.validbox(), -2);
+                FArrayBox fab(region, 2, The_Pinned_Arena());
+                vismf_region.readFABRegion(fab, 0, mfi.index(), 1, 2);
+                auto const& a = fab.const_array();
+                auto const& b = mf.const_array(mfi);
+                nerrors = 0;
+                amrex::LoopOnCpu(region, 2, [&] (int i, int j, int k, int n)
+                {
+                    if (a(i,j,k,n) != b(i,j,k,n+1)) { ++nerrors; }
+                });
+                AMREX_ALWAYS_ASSERT(nerrors == 0);
+            }
+        }
+
+        // Lossy compression with an error bound for the smooth components.
+        const Vector<Real> abs_error{Real(1.e-4), Real(1.e-2), Real(0.0)};
+        Long lossy_bytes = VisMF::Write(mf, "vismf_lossy", VisMF::NFiles, false, abs_error);
+        ParallelDescriptor::ReduceLongSum(lossy_bytes);
+        amrex::Print() << "Bytes written with loss: " << lossy_bytes << "\n";
+        AMREX_ALWAYS_ASSERT(lossy_bytes < compressed_bytes);
+
+        VisMF::Read(mf2, "vismf_lossy");
+        for (int n = 0; n < ncomp; ++n) {
+            MultiFab::Subtract(mf2, mf, n, n, 1, ng);
+            const Real err = mf2.norm0(n, ng[0]);
+            amrex::Print() << "Maximum error of component " << n << ": " << err << "\n";
+            AMREX_ALWAYS_ASSERT(err <= abs_error[n]);
+        }
+    }
+    amrex::Finalize();
+}
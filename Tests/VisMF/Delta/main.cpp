@@ -0,0 +1,80 @@
+#include <AMReX.H>
+#include <AMReX_Print.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Utility.H>
+#include <AMReX_VisMF.H>
+
+#include <VisMFTest.H>
+
+using namespace amrex;
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int n_cell = 64;
+        int max_grid_size = 16;
+        int nchk = 4;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("nchk", nchk);
+        }
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        const int ncomp = 2;
+        const IntVect ng(1);
+        MultiFab mf(ba, dm, ncomp, ng, MFInfo().SetArena(The_Pinned_Arena()));
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            auto const& a = mf.array(mfi);
+            amrex::LoopOnCpu(mfi.fabbox(), ncomp, [&] (int i, int j, int k, int n)
+            {
+                a(i,j,k,n) = Real(i + 100*j + 10000*k) + Real(0.5)*Real(n);
+            });
+        }
+
+        Long full_bytes = 0;
+        for (int ichk = 0; ichk < nchk; ++ichk) {
+            const std::string chkdir = amrex::Concatenate("chk", ichk, 2);
+            const std::string refdir = (ichk == 0) ? std::string()
+                                                   : amrex::Concatenate("chk", ichk-1, 2);
+            amrex::UtilCreateCleanDirectory(chkdir, true);
+
+            // Only change one FAB between checkpoints.
+            if (ichk > 0) {
+                for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+                    if (mfi.index() == ichk % mf.size()) {
+                        mf[mfi].plus<RunOn::Host>(Real(1.0));
+                    }
+                }
+            }
+
+            VisMF::SetDeltaReference(chkdir, refdir);
+            Long bytes = VisMF::Write(mf, chkdir + "/mf");
+            VisMF::ClearDeltaReference();
+            ParallelDescriptor::ReduceLongSum(bytes);
+
+            amrex::Print() << "Bytes written to " << chkdir << ": " << bytes << "\n";
+            if (ichk == 0) {
+                full_bytes = bytes;
+            } else if (mf.size() > 2) {
+                AMREX_ALWAYS_ASSERT(bytes < full_bytes/2);
+            }
+
+            // The unchanged FABs are read from the earlier checkpoints.
+            MultiFab mf2(ba, dm, ncomp, ng, MFInfo().SetArena(The_Pinned_Arena()));
+            mf2.setVal(-1.0);
+            VisMF::Read(mf2, chkdir + "/mf");
+            Long nerrors = count_errors(mf2, mf);
+            amrex::Print() << "Number of errors reading " << chkdir << ": " << nerrors << "\n";
+            AMREX_ALWAYS_ASSERT(nerrors == 0);
+        }
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,94 @@
+#include <AMReX.H>
+#include <AMReX_Print.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_VisMF.H>
+
+#include <VisMFTest.H>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <utility>
+
+using namespace amrex;
+
+namespace {
+
+// The size of the data file, which is padded to the alignment.
+Long file_size (std::string const& name)
+{
+    std::ifstream ifs(name, std::ios::binary | std::ios::ate);
+    return ifs.good() ? static_cast<Long>(ifs.tellg()) : Long(-1);
+}
+
+void add_parameters ()
+{
+    ParmParse pp("vismf");
+    pp.add("usedirectio", 1);
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv,true,MPI_COMM_WORLD,add_parameters);
+    {
+        int n_cell = 48;
+        int max_grid_size = 12;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+        }
+        AMREX_ALWAYS_ASSERT(VisMF::GetUseDirectIO());
+        // All processes write to one file.
+        const int noutfiles = VisMF::GetNOutFiles();
+        VisMF::SetNOutFiles(1);
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        const int ncomp = 3;
+        const IntVect ng(1);
+        MultiFab mf(ba, dm, ncomp, ng, MFInfo().SetArena(The_Pinned_Arena()));
+        fill(mf);
+
+        // The FABs are read by other processes than the ones that wrote them.
+        Vector<int> pmap = dm.ProcessorMap();
+        std::reverse(pmap.begin(), pmap.end());
+        DistributionMapping dm2(std::move(pmap));
+        MultiFab ref(ba, dm2, ncomp, ng, MFInfo().SetArena(The_Pinned_Arena()));
+        ref.ParallelCopy(mf, 0, 0, ncomp, ng, ng);
+
+        const auto version = VisMF::GetHeaderVersion();
+        for (auto hv : {VisMF::Header::Version_v1, VisMF::Header::NoFabHeader_v1,
+                        VisMF::Header::Compressed_v1})
+        {
+            const std::string name = "vismf_directio_" + std::to_string(int(hv));
+            VisMF::SetHeaderVersion(hv);
+            VisMF::Write(mf, name);
+
+            MultiFab mf2(ba, dm2, ncomp, ng, MFInfo().SetArena(The_Pinned_Arena()));
+            mf2.setVal(0.0);
+            VisMF::Read(mf2, name);
+            const Long nerrors = count_errors(mf2, ref);
+            amrex::Print() << "Header version " << int(hv)
+                           << ": number of errors after direct i/o writes: " << nerrors << "\n";
+            AMREX_ALWAYS_ASSERT(nerrors == 0);
+
+            // The data of each process are padded to the default alignment.
+            if (ParallelDescriptor::IOProcessor()) {
+                const Long nbytes = file_size(name + "_D_00000");
+                amrex::Print() << "Header version " << int(hv) << ": " << nbytes
+                               << " bytes in the data file\n";
+                AMREX_ALWAYS_ASSERT(nbytes > 0 && nbytes % 4096 == 0);
+            }
+        }
+        VisMF::SetHeaderVersion(version);
+        VisMF::SetNOutFiles(noutfiles);
+    }
+    amrex::Finalize();
+}
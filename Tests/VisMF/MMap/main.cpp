@@ -0,0 +1,81 @@
+#include <AMReX.H>
+#include <AMReX_Print.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_VisMF.H>
+
+#include <VisMFTest.H>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+using namespace amrex;
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int n_cell = 64;
+        int max_grid_size = 16;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+        }
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        const int ncomp = 3;
+        const IntVect ng(1);
+        MultiFab mf(ba, dm, ncomp, ng, MFInfo().SetArena(The_Pinned_Arena()));
+        fill(mf);
+
+        // The FABs are read by other processes than the ones that wrote them.
+        Vector<int> pmap = dm.ProcessorMap();
+        std::reverse(pmap.begin(), pmap.end());
+        DistributionMapping dm2(std::move(pmap));
+
+        const auto version = VisMF::GetHeaderVersion();
+        const bool use_mmap = VisMF::GetUseMMapReads();
+        VisMF::SetUseMMapReads(true);
+
+        for (auto hv : {VisMF::Header::Version_v1, VisMF::Header::NoFabHeader_v1,
+                        VisMF::Header::Compressed_v1})
+        {
+            const std::string name = "vismf_mmap_" + std::to_string(int(hv));
+            VisMF::SetHeaderVersion(hv);
+            VisMF::Write(mf, name);
+
+            // Same BoxArray, so the FABs are copied from the mapped files.
+            MultiFab mf2(ba, dm2, ncomp, ng, MFInfo().SetArena(The_Pinned_Arena()));
+            mf2.setVal(0.0);
+            VisMF::Read(mf2, name);
+            MultiFab ref(ba, dm2, ncomp, ng, MFInfo().SetArena(The_Pinned_Arena()));
+            ref.ParallelCopy(mf, 0, 0, ncomp, ng, ng);
+            Long nerrors = count_errors(mf2, ref);
+            amrex::Print() << "Header version " << int(hv)
+                           << ": number of errors after VisMF::Read with mmap: " << nerrors << "\n";
+            AMREX_ALWAYS_ASSERT(nerrors == 0);
+
+            // The same with streams.
+            VisMF::SetUseMMapReads(false);
+            MultiFab mf3(ba, dm2, ncomp, ng, MFInfo().SetArena(The_Pinned_Arena()));
+            mf3.setVal(0.0);
+            VisMF::Read(mf3, name);
+            VisMF::SetUseMMapReads(true);
+            nerrors = count_errors(mf3, mf2);
+            amrex::Print() << "Header version " << int(hv)
+                           << ": number of differences with VisMF::Read with streams: "
+                           << nerrors << "\n";
+            AMREX_ALWAYS_ASSERT(nerrors == 0);
+        }
+
+        VisMF::SetUseMMapReads(use_mmap);
+        VisMF::SetHeaderVersion(version);
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,89 @@
+#include <AMReX.H>
+#include <AMReX_Print.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_PlotFileUtil.H>
+#include <AMReX_VisMF.H>
+
+#include <algorithm>
+#include <string>
+
+using namespace amrex;
+
+namespace {
+
+Real fval (int lev, int i, int j, int k, int n)
+{
+    return Real(i + 100*j + 10000*k + 1000000*n + 10000000*lev);
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        const int n_cell = 32;
+        const Vector<std::string> varnames{"a", "b", "c"};
+        const int ncomp = static_cast<int>(varnames.size());
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        RealBox rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Vector<Geometry> geom{Geometry(domain, rb, CoordSys::cartesian, {AMREX_D_DECL(0,0,0)}),
+                              Geometry(amrex::refine(domain,2), rb, CoordSys::cartesian,
+                                       {AMREX_D_DECL(0,0,0)})};
+
+        // Level 1 covers the middle of the domain.
+        Vector<BoxArray> ba{BoxArray(domain),
+                            BoxArray(amrex::refine(Box(IntVect(n_cell/4), IntVect(3*n_cell/4-1)), 2))};
+        Vector<MultiFab> mf(2);
+        for (int lev = 0; lev < 2; ++lev) {
+            ba[lev].maxSize(8);
+            mf[lev].define(ba[lev], DistributionMapping(ba[lev]), ncomp, 0);
+            for (MFIter mfi(mf[lev]); mfi.isValid(); ++mfi) {
+                auto const& a = mf[lev].array(mfi);
+                amrex::LoopOnCpu(mfi.validbox(), ncomp, [&] (int i, int j, int k, int n)
+                {
+                    a(i,j,k,n) = fval(lev,i,j,k,n);
+                });
+            }
+        }
+
+        const auto version = VisMF::GetHeaderVersion();
+        VisMF::SetHeaderVersion(VisMF::Header::Version_v1);
+        WriteMultiLevelPlotfile("plt_region", 2, amrex::GetVecOfConstPtrs(mf), varnames,
+                                geom, 0.0, {0,0}, {IntVect(2)});
+        VisMF::SetHeaderVersion(version);
+
+        PlotFileData pf("plt_region");
+        Long nerrors = 0;
+        const Vector<Vector<std::string>> selections{{"a","b","c"}, {"c"}, {"c","a"}, {"b","c"}};
+        for (int lev = 0; lev < 2; ++lev) {
+            const Box& lev_domain = geom[lev].Domain();
+            // A region across several boxes, and one partly outside level 1.
+            const Vector<Box> regions{Box(IntVect(5), IntVect(13)),
+                                      Box(IntVect(lev_domain.length(0)/4 - 3),
+                                          IntVect(lev_domain.length(0)/4 + 6))};
+            for (auto const& region : regions) {
+                for (auto const& names : selections) {
+                    FArrayBox fab = pf.get(lev, region, names);
+                    AMREX_ALWAYS_ASSERT(fab.box() == region && fab.nComp() == int(names.size()));
+                    auto const& a = fab.const_array();
+                    for (int m = 0; m < int(names.size()); ++m) {
+                        const int n = static_cast<int>(std::find(varnames.begin(), varnames.end(),
+                                                                 names[m]) - varnames.begin());
+                        amrex::LoopOnCpu(region, [&] (int i, int j, int k)
+                        {
+                            const Real expected = ba[lev].contains(IntVect(AMREX_D_DECL(i,j,k)))
+                                ? fval(lev,i,j,k,n) : Real(0);
+                            if (a(i,j,k,m) != expected) { ++nerrors; }
+                        });
+                    }
+                }
+            }
+        }
+        amrex::Print() << "Number of errors reading regions of a Version_v1 plotfile: "
+                       << nerrors << "\n";
+        AMREX_ALWAYS_ASSERT(nerrors == 0);
+    }
+    amrex::Finalize();
+}
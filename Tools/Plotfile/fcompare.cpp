@@ -5,6 +5,8 @@
 #include <limits>
 #include <cmath>
 #include <cstdlib>
+#include <tuple>
+#include <utility>
 
 using namespace amrex;
 
@@ -15,6 +17,38 @@ struct ErrZone {
     IntVect cell;
 };
 
+// Max and sum of |B-A|^p and |A|^p, p = max(norm,1), for each variable
+struct NormData {
+    Vector<Real> dmax, dsum, amax, asum;
+    Vector<int> nan_a, nan_b;
+
+    explicit NormData (int n)
+        : dmax(n,0.0), dsum(n,0.0), amax(n,0.0), asum(n,0.0), nan_a(n,0), nan_b(n,0) {}
+
+    void ReduceAll ()
+    {
+        const int n = static_cast<int>(dmax.size());
+        ParallelDescriptor::ReduceRealMax(dmax.data(), n);
+        ParallelDescriptor::ReduceRealMax(amax.data(), n);
+        ParallelDescriptor::ReduceRealSum(dsum.data(), n);
+        ParallelDescriptor::ReduceRealSum(asum.data(), n);
+        ParallelDescriptor::ReduceIntMax(nan_a.data(), n);
+        ParallelDescriptor::ReduceIntMax(nan_b.data(), n);
+    }
+
+    // absolute and relative errors of variable n, dv is the cell volume
+    [[nodiscard]] std::pair<Real,Real> errors (int n, int norm, Real dv) const
+    {
+        if (norm == 0) {
+            return {dmax[n], dmax[n]/amax[n]};
+        } else {
+            const Real p = Real(1.)/static_cast<Real>(norm);
+            const Real aerr = std::pow(dsum[n],p);
+            return {aerr*std::pow(dv,p), aerr/std::pow(asum[n],p)};
+        }
+    }
+};
+
 void PrintUsage()
 {
     amrex::Print()
@@ -24,7 +58,7 @@ void PrintUsage()
         << " variable.\n"
         << "\n"
         << " usage:\n"
-        << "    fcompare [-n|--norm num] [-d|--diffvar var] [-z|--zone_info var] [-a|--allow_diff_grids] [-l|--allow_diff_num_levels] [-r|rel_tol] [--abs_tol] [--abort_if_not_all_found] file1 file2\n"
+        << "    fcompare [-n|--norm num] [-d|--diffvar var] [-z|--zone_info var] [-a|--allow_diff_grids] [-l|--allow_diff_num_levels] [-r|rel_tol] [--abs_tol] [--abort_if_not_all_found] [-e|--early_exit] file1 file2\n"
         << "\n"
         << " optional arguments:\n"
         << "    -n|--norm num            : what norm to use (default is 0 for inf norm)\n"
@@ -37,6 +71,10 @@ void PrintUsage()
         << "    -r|--rel_tol rtol        : relative tolerance (default is 0)\n"
         << "    --abs_tol atol           : absolute tolerance (default is 0)\n"
         << "    --abort_if_not_all_found : abort if not all variables are present in both files\n"
+        << "    -e|--early_exit          : stop at the first variable exceeding the tolerances\n"
+        << "                               or having NaNs, without the diffvar and zone_info outputs.\n"
+        << "                               The grids of a level are skipped only with a NaN or\n"
+        << "                               with rtol = 0, otherwise the check is after each level\n"
         << '\n';
 }
 
@@ -63,6 +101,7 @@ int main_main()
     std::string zone_info_var_name;
     Vector<std::string> plot_names(1);
     bool abort_if_not_all_found = false;
+    bool early_exit = false;
 
     int farg = 1;
     while (farg <= narg) {
@@ -92,6 +131,8 @@ int main_main()
             atol = Real(std::stod(amrex::get_command_argument(++farg)));
         } else if (fname == "--abort_if_not_all_found") {
             abort_if_not_all_found = true;
+        } else if (fname == "-e" || fname == "--early_exit") {
+            early_exit = true;
         } else {
             break;
         }
@@ -180,13 +221,14 @@ int main_main()
         }
     }
 
-    // create a multifab to store the difference for output, if desired
+    // create a multifab to store the difference for output, if desired.
+    // it is filled on the host, so it is in pinned memory.
     Vector<MultiFab> mf_array(nlevels);
     if (save_var_a >= 0) {
         for (int ilev = 0; ilev < nlevels; ++ilev) {
             mf_array[ilev].define(pf_a.boxArray(ilev),
                                   pf_a.DistributionMap(ilev),
-                                  1, 0);
+                                  1, 0, MFInfo().SetArena(The_Pinned_Arena()));
         }
     }
 
@@ -199,7 +241,22 @@ int main_main()
                    << "  " << std::setw(24) << "(||A - B||/||A||)" << "\n"
                    << " " << std::string(76,'-') << "\n";
 
-    // go level-by-level and patch-by-patch and compare the data
+    // the variables in both files
+    Vector<int> comps_a;
+    Vector<std::string> vars_a, vars_b;
+    for (int icomp_a = 0; icomp_a < ncomp_a; ++icomp_a) {
+        if (ivar_b[icomp_a] >= 0) {
+            comps_a.push_back(icomp_a);
+            vars_a.push_back(names_a[icomp_a]);
+            vars_b.push_back(names_b[ivar_b[icomp_a]]);
+        }
+    }
+    const int ncomp = static_cast<int>(comps_a.size());
+    const int myproc = ParallelDescriptor::MyProc();
+
+    // go level-by-level and grid-by-grid and compare the data.  each process
+    // reads one of its grids of A and the same region of B at a time, so the
+    // memory used does not depend on the size of the plotfiles.
     for (int ilev = 0; ilev < nlevels; ++ilev)
     {
         if (pf_a.boxArray(ilev).empty() && pf_b.boxArray(ilev).empty()) {
@@ -216,73 +273,129 @@ int main_main()
             }
         }
 
-        Vector<Real> aerror(ncomp_a, 0.0);
-        Vector<Real> rerror(ncomp_a, 0.0);
-        Vector<Real> rerror_denom(ncomp_a, 0.0);
-        Vector<int> has_nan_a(ncomp_a, false);
-        Vector<int> has_nan_b(ncomp_a, false);
-        for (int icomp_a = 0; icomp_a < ncomp_a; ++icomp_a) {
-            if (ivar_b[icomp_a] >= 0) {
-                const MultiFab& mf_a = pf_a.get(ilev, names_a[icomp_a]);
-                MultiFab mf_b;
-                if (grids_match) {
-                    mf_b = pf_b.get(ilev, names_b[ivar_b[icomp_a]]);
-                } else {
-                    mf_b.define(mf_a.boxArray(), mf_a.DistributionMap(), 1, 0);
-                    MultiFab tmp = pf_b.get(ilev, names_b[ivar_b[icomp_a]]);
-                    mf_b.ParallelCopy(tmp);
-                }
-                has_nan_a[icomp_a] = mf_a.contains_nan();
-                has_nan_b[icomp_a] = mf_b.contains_nan();
-                MultiFab::Subtract(mf_b,mf_a,0,0,1,0); // b = b - a
-                Real max_err = mf_b.norm0();
-                if (norm == 1) {
-                    aerror[icomp_a] = mf_b.norm1();
-                    rerror[icomp_a] = aerror[icomp_a];
-                    rerror_denom[icomp_a] = mf_a.norm1();
-                } else if (norm == 2) {
-                    aerror[icomp_a] = mf_b.norm2();
-                    rerror[icomp_a] = aerror[icomp_a];
-                    rerror_denom[icomp_a] = mf_a.norm2();
-                } else {
-                    aerror[icomp_a] = max_err;
-                    rerror[icomp_a] = aerror[icomp_a];
-                    rerror_denom[icomp_a] = mf_a.norm0();
-                }
+        Real dv = 1.0;
+        for (int idim = 0; idim < dm; ++idim) {
+            dv *= pf_a.cellSize(ilev)[idim];
+        }
 
-                if (norm == 0) {
-                    rerror[icomp_a] /= rerror_denom[icomp_a];
-                } else {
-                    const auto& dx = pf_a.cellSize(ilev);
-                    Real dv = 1.0;
-                    for (int idim = 0; idim < dm; ++idim) {
-                        dv *= dx[idim];
-                    }
-                    aerror[icomp_a] *= std::pow(dv,Real(1.)/static_cast<Real>(norm));
-                    rerror[icomp_a] = rerror[icomp_a]/rerror_denom[icomp_a];
-                }
+        const DistributionMapping& dmap = pf_a.DistributionMap(ilev);
+        Vector<int> mygrids;
+        for (int i = 0; i < static_cast<int>(dmap.size()); ++i) {
+            if (dmap[i] == myproc) { mygrids.push_back(i); }
+        }
 
-                if (icomp_a == save_var_a || icomp_a == zone_info_var_a) {
-                    mf_b.abs(0,1);
-                }
+        // with early exit, the errors are checked after each round of grids
+        int nrounds = static_cast<int>(mygrids.size());
+        if (early_exit) {
+            ParallelDescriptor::ReduceIntMax(nrounds);
+        }
 
-                if (icomp_a == save_var_a) {
-                    MultiFab::Copy(mf_array[ilev], mf_b, 0, 0, 1, 0);
-                }
+        NormData nd(ncomp);
+        bool stopped = false;
+        for (int iround = 0; iround < nrounds; ++iround) {
+            if (iround < static_cast<int>(mygrids.size()) && ncomp > 0) {
+                const int gid = mygrids[iround];
+                const Box& bx = pf_a.boxArray(ilev)[gid];
+                const FArrayBox fab_a = pf_a.get(ilev, bx, vars_a);
+                const FArrayBox fab_b = pf_b.get(ilev, bx, vars_b);
+                const auto lo = amrex::lbound(bx);
+                const auto hi = amrex::ubound(bx);
+                for (int n = 0; n < ncomp; ++n) {
+                    auto const& a = fab_a.const_array(n);
+                    auto const& b = fab_b.const_array(n);
+                    Real dmax = 0.0, dsum = 0.0, amax = 0.0, asum = 0.0;
+                    int nan_a = 0, nan_b = 0;
+#ifdef AMREX_USE_OMP
+#pragma omp parallel for collapse(2) reduction(max:dmax,amax) reduction(+:dsum,asum,nan_a,nan_b)
+#endif
+                    for (int k = lo.z; k <= hi.z; ++k) {
+                    for (int j = lo.y; j <= hi.y; ++j) {
+                    for (int i = lo.x; i <= hi.x; ++i) {
+                        const Real va = a(i,j,k);
+                        const Real vb = b(i,j,k);
+                        const Real d = std::abs(vb-va);
+                        const Real x = std::abs(va);
+                        dmax = std::max(dmax, d);
+                        amax = std::max(amax, x);
+                        if (norm <= 1) {
+                            dsum += d;
+                            asum += x;
+                        } else if (norm == 2) {
+                            dsum += d*d;
+                            asum += x*x;
+                        } else {
+                            dsum += std::pow(d, static_cast<Real>(norm));
+                            asum += std::pow(x, static_cast<Real>(norm));
+                        }
+                        nan_a += std::isnan(va);
+                        nan_b += std::isnan(vb);
+                    }}}
+                    nd.dmax[n] = std::max(nd.dmax[n], dmax);
+                    nd.amax[n] = std::max(nd.amax[n], amax);
+                    nd.dsum[n] += dsum;
+                    nd.asum[n] += asum;
+                    nd.nan_a[n] = std::max(nd.nan_a[n], nan_a);
+                    nd.nan_b[n] = std::max(nd.nan_b[n], nan_b);
+
+                    const int icomp_a = comps_a[n];
+                    if (icomp_a == save_var_a) {
+                        auto const& diff = mf_array[ilev][gid].array();
+                        amrex::LoopOnCpu(bx, [&] (int i, int j, int k)
+                        {
+                            diff(i,j,k) = std::abs(b(i,j,k)-a(i,j,k));
+                        });
+                    }
 
-                if (icomp_a == zone_info_var_a) {
-                    if (max_err > err_zone.max_abs_err) {
-                        err_zone.max_abs_err = max_err;
+                    if (icomp_a == zone_info_var_a && dmax > err_zone.max_abs_err) {
+                        err_zone.max_abs_err = dmax;
                         err_zone.level = ilev;
-                        err_zone.cell = mf_b.maxIndex(0);
-                        auto isects = pf_a.boxArray(ilev).intersections
-                            (Box(err_zone.cell,err_zone.cell), true, 0);
-                        err_zone.grid_index = isects[0].first;
+                        err_zone.grid_index = gid;
+                        err_zone.cell = bx.smallEnd();
+                        bool found = false;
+                        for (int k = lo.z; k <= hi.z && !found; ++k) {
+                        for (int j = lo.y; j <= hi.y && !found; ++j) {
+                        for (int i = lo.x; i <= hi.x && !found; ++i) {
+                            if (std::abs(b(i,j,k)-a(i,j,k)) == dmax) {
+                                err_zone.cell = IntVect(AMREX_D_DECL(i,j,k));
+                                found = true;
+                            }
+                        }}}
+                    }
+                }
+            }
+
+            if (early_exit) {
+                // the errors only grow, so with rtol = 0 an error above atol is final
+                NormData nd_all = nd;
+                nd_all.ReduceAll();
+                for (int n = 0; n < ncomp; ++n) {
+                    if (nd_all.nan_a[n] || nd_all.nan_b[n] ||
+                        (rtol == 0.0 && nd_all.errors(n,norm,dv).first > atol)) {
+                        stopped = true;
                     }
                 }
+                if (stopped) {
+                    nd = std::move(nd_all);
+                    break;
+                }
             }
         }
 
+        if (!stopped) {
+            nd.ReduceAll();
+        }
+
+        Vector<Real> aerror(ncomp_a, 0.0);
+        Vector<Real> rerror(ncomp_a, 0.0);
+        Vector<int> has_nan_a(ncomp_a, false);
+        Vector<int> has_nan_b(ncomp_a, false);
+        for (int n = 0; n < ncomp; ++n) {
+            const int icomp_a = comps_a[n];
+            std::tie(aerror[icomp_a], rerror[icomp_a]) = nd.errors(n, norm, dv);
+            has_nan_a[icomp_a] = nd.nan_a[n];
+            has_nan_b[icomp_a] = nd.nan_b[n];
+        }
+
         amrex::Print() << " level = " << ilev << "\n";
         for (int icomp_a = 0; icomp_a < ncomp_a; ++icomp_a) {
             if (ivar_b[icomp_a] < 0) {
@@ -334,6 +447,12 @@ int main_main()
             all_variables_passed = all_variables_passed &&
                 (aerror[icomp_a] <= atol || rerror[icomp_a] <= rtol);
         }
+
+        if (early_exit && (stopped || any_nans || !all_variables_passed)) {
+            amrex::Print() << " STOPPED at level " << ilev
+                           << (stopped ? " before all the grids were compared" : "") << '\n';
+            return EXIT_FAILURE;
+        }
     }
 
     if (save_var_a >= 0) {
@@ -354,27 +473,29 @@ int main_main()
     }
 
     if (zone_info) {
-        if (err_zone.max_abs_err > 0.) {
-            ParallelDescriptor::Barrier();
-            const DistributionMapping& dmap = pf_a.DistributionMap(err_zone.level);
-            bool owner_proc = ParallelDescriptor::MyProc() == dmap[err_zone.grid_index];
-
-            if (owner_proc) {
+        Real max_abs_err = err_zone.max_abs_err;
+        ParallelDescriptor::ReduceRealMax(max_abs_err);
+        if (max_abs_err > 0.) {
+            int owner = (err_zone.max_abs_err == max_abs_err) ? myproc
+                                                              : ParallelDescriptor::NProcs();
+            ParallelDescriptor::ReduceIntMin(owner);
+
+            if (myproc == owner) {
                 amrex::AllPrint() << '\n'
                                   << " maximum error in " << zone_info_var_name << "\n"
                                   << "   level = " << err_zone.level << " (i,j,k) = " << err_zone.cell << "\n";
-            }
 
-            for (int icomp_a = 0; icomp_a < ncomp_a; ++icomp_a) {
-                const MultiFab& mf = pf_a.get(err_zone.level,names_a[icomp_a]);
-                if (owner_proc) {
-                    Real v = mf[err_zone.grid_index](err_zone.cell);
+                const FArrayBox fab = pf_a.get(err_zone.level, Box(err_zone.cell,err_zone.cell),
+                                               names_a);
+                for (int icomp_a = 0; icomp_a < ncomp_a; ++icomp_a) {
+                    Real v = fab(err_zone.cell, icomp_a);
                     amrex::AllPrint() << " " << std::setw(24)
                                       << names_a[icomp_a] << "  "
                                       << std::setw(24) << std::right
                                       << v << "\n";
                 }
             }
+            ParallelDescriptor::Barrier();
         }
     }
 